@@ -0,0 +1,156 @@
+// Table-driven alert patterns (buzzer + LED) for the gas receivers
+//
+// A pattern is a list of {duration ms, level} steps in flash, ending with a
+// zero duration, after which it repeats from the first step:
+//
+//   const AlertStep PATTERN_BLINK[] PROGMEM = {{200, HIGH}, {200, LOW}, {0, LOW}};
+//
+// Each channel plays one pattern on its output pins while it is active.
+// alertRun() serves every channel in one pass, but only when the earliest
+// step deadline has come, so most loop() iterations return right away.
+// Output levels are kept in RAM; pins are only written when they change.
+
+#ifndef ALERT_SEQUENCER_H
+#define ALERT_SEQUENCER_H
+
+#ifndef ALERT_MAX_CHANNELS
+#define ALERT_MAX_CHANNELS 4
+#endif
+#define ALERT_PINS_PER_CHANNEL 2  // buzzer and LED
+#define ALERT_NO_PIN 0xFF
+#define ALERT_NO_CHANNEL 0xFF     // alertAddChannel() with every channel taken
+
+struct AlertStep {
+  uint16_t durationMs;  // 0 = end of pattern
+  uint8_t level;
+};
+
+struct AlertChannel {
+  const AlertStep *pattern;  // in PROGMEM
+  uint8_t pins[ALERT_PINS_PER_CHANNEL];
+  bool active;
+  uint8_t step;
+  uint8_t level;             // what the pins are driven to now
+  unsigned long stepStart;
+};
+
+AlertChannel alertChannels[ALERT_MAX_CHANNELS];
+uint8_t alertChannelCount = 0;
+uint8_t alertActiveCount = 0;
+unsigned long alertNextWake = 0;   // earliest step deadline of the active channels
+
+inline uint16_t alertStepDuration(const AlertChannel &c, uint8_t step) {
+  return pgm_read_word(&c.pattern[step].durationMs);
+}
+
+inline uint8_t alertStepLevel(const AlertChannel &c, uint8_t step) {
+  return pgm_read_byte(&c.pattern[step].level);
+}
+
+void alertWrite(AlertChannel &c, uint8_t level) {
+  if (level == c.level) {
+    return;
+  }
+  c.level = level;
+  for (uint8_t i = 0; i < ALERT_PINS_PER_CHANNEL; i++) {
+    if (c.pins[i] != ALERT_NO_PIN) {
+      digitalWrite(c.pins[i], level);
+    }
+  }
+}
+
+// Register a channel (pins are driven LOW); returns its index for
+// alertSetActive(), or ALERT_NO_CHANNEL if ALERT_MAX_CHANNELS are taken.
+// The other calls ignore ALERT_NO_CHANNEL.
+uint8_t alertAddChannel(const AlertStep *pattern, uint8_t buzzerPin, uint8_t ledPin) {
+  if (alertChannelCount == ALERT_MAX_CHANNELS) {
+    return ALERT_NO_CHANNEL;
+  }
+  AlertChannel &c = alertChannels[alertChannelCount];
+  c.pattern = pattern;
+  c.pins[0] = buzzerPin;
+  c.pins[1] = ledPin;
+  c.active = false;
+  c.step = 0;
+  c.level = HIGH;
+  alertWrite(c, LOW);
+  return alertChannelCount++;
+}
+
+// Start (from the first step) or stop a channel's pattern. Cheap to call
+// every loop(): nothing happens unless the state changes.
+void alertSetActive(uint8_t channel, bool active) {
+  if (channel >= alertChannelCount) {
+    return;
+  }
+  AlertChannel &c = alertChannels[channel];
+  if (c.active == active) {
+    return;
+  }
+  c.active = active;
+  if (active) {
+    alertActiveCount++;
+    c.step = 0;
+    c.stepStart = millis();
+    alertWrite(c, alertStepLevel(c, 0));
+    alertNextWake = c.stepStart;  // let alertRun() recompute the deadline
+  } else {
+    alertActiveCount--;
+    alertWrite(c, LOW);
+  }
+}
+
+// Switch a channel to another pattern (e.g. from a warning to the full
+// alarm); a playing channel starts the new one from its first step
+void alertSetPattern(uint8_t channel, const AlertStep *pattern) {
+  if (channel >= alertChannelCount) {
+    return;
+  }
+  AlertChannel &c = alertChannels[channel];
+  if (c.pattern == pattern) {
+    return;
+  }
+  c.pattern = pattern;
+  if (c.active) {
+    c.step = 0;
+    c.stepStart = millis();
+    alertWrite(c, alertStepLevel(c, 0));
+    alertNextWake = c.stepStart;
+  }
+}
+
+// Advance every active pattern whose current step has ended
+void alertRun() {
+  unsigned long now = millis();
+  if (alertActiveCount == 0 || (long)(now - alertNextWake) < 0) {
+    return;
+  }
+  unsigned long nextWake = now + 0x7FFFFFFFUL;
+  for (uint8_t i = 0; i < alertChannelCount; i++) {
+    AlertChannel &c = alertChannels[i];
+    if (!c.active) {
+      continue;
+    }
+    // Steps are timed from the previous deadline, not from when loop() got
+    // here, so the rhythm doesn't drift; after a long stall the missed
+    // steps are skipped without touching the pins
+    uint16_t duration = alertStepDuration(c, c.step);
+    while (now - c.stepStart >= duration) {
+      c.stepStart += duration;
+      c.step++;
+      duration = alertStepDuration(c, c.step);
+      if (duration == 0) {
+        c.step = 0;
+        duration = alertStepDuration(c, 0);
+      }
+    }
+    alertWrite(c, alertStepLevel(c, c.step));
+    unsigned long due = c.stepStart + duration;
+    if ((long)(due - nextWake) < 0) {
+      nextWake = due;
+    }
+  }
+  alertNextWake = nextWake;
+}
+
+#endif
@@ -0,0 +1,112 @@
+// Interrupt-driven push buttons with debouncing and an event queue
+//
+// Buttons are active LOW (INPUT_PULLUP). A CHANGE interrupt timestamps every
+// edge. The first edge after the line has been quiet for
+// BUTTON_DEBOUNCE_MS flips the button between released and pressed; the
+// ISR doesn't read the pin for it, since a contact that bounces fast may
+// already read high again. Bounces come within a few ms of the previous
+// edge and are ignored. Once the line has been quiet again,
+// buttonNextEvent() checks the state against the pin, so a lost edge
+// can't leave a button inverted. Presses go into a small ring that loop()
+// drains with buttonNextEvent(), so nothing on the main path waits for a
+// button.
+//
+// Each button needs a pin with interrupt support (any GPIO on ESP32).
+
+#ifndef BUTTON_EVENTS_H
+#define BUTTON_EVENTS_H
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+#ifndef BUTTON_DEBOUNCE_MS
+#define BUTTON_DEBOUNCE_MS 30
+#endif
+#define BUTTON_MAX 4
+#define BUTTON_NONE 0xFF      // buttonAdd() with every slot taken
+#define BUTTON_QUEUE_LEN 8   // power of two
+
+struct ButtonEvent {
+  uint8_t button;           // index returned by buttonAdd()
+  unsigned long pressedAt;  // millis() of the press
+};
+
+struct ButtonState {
+  uint8_t pin;
+  volatile bool down;               // debounced state
+  volatile unsigned long lastEdge;
+};
+
+ButtonState buttons[BUTTON_MAX];
+uint8_t buttonCount = 0;
+ButtonEvent buttonQueue[BUTTON_QUEUE_LEN];
+volatile uint8_t buttonQueueHead = 0;   // written by the ISRs
+volatile uint8_t buttonQueueTail = 0;   // written by buttonNextEvent()
+volatile uint32_t buttonQueueDrops = 0;
+
+void IRAM_ATTR buttonOnEdge(uint8_t index) {
+  ButtonState &b = buttons[index];
+  unsigned long now = millis();
+  bool quiet = now - b.lastEdge >= BUTTON_DEBOUNCE_MS;
+  b.lastEdge = now;
+  if (!quiet) {
+    return;   // a bounce
+  }
+  b.down = !b.down;
+  if (!b.down) {
+    return;   // a release
+  }
+  uint8_t head = buttonQueueHead;
+  if ((uint8_t)(head - buttonQueueTail) >= BUTTON_QUEUE_LEN) {
+    buttonQueueDrops++;
+    return;
+  }
+  buttonQueue[head & (BUTTON_QUEUE_LEN - 1)] = {index, now};
+  buttonQueueHead = head + 1;
+}
+
+// attachInterrupt() handlers take no argument, so one per button slot
+template <uint8_t I> void IRAM_ATTR buttonIsr() { buttonOnEdge(I); }
+void (*const buttonIsrs[BUTTON_MAX])() = {buttonIsr<0>, buttonIsr<1>, buttonIsr<2>, buttonIsr<3>};
+
+// Set up a button on pin; returns its index (the order of the calls), or
+// BUTTON_NONE if BUTTON_MAX buttons are already set up
+uint8_t buttonAdd(uint8_t pin) {
+  if (buttonCount == BUTTON_MAX) {
+    return BUTTON_NONE;
+  }
+  uint8_t index = buttonCount++;
+  buttons[index].pin = pin;
+  buttons[index].lastEdge = millis() - BUTTON_DEBOUNCE_MS;
+  pinMode(pin, INPUT_PULLUP);
+  buttons[index].down = digitalRead(pin) == LOW;
+  attachInterrupt(digitalPinToInterrupt(pin), buttonIsrs[index], CHANGE);
+  return index;
+}
+
+// Settle each quiet button on its pin level
+void buttonResync() {
+  for (uint8_t i = 0; i < buttonCount; i++) {
+    ButtonState &b = buttons[i];
+    noInterrupts();
+    if (millis() - b.lastEdge >= BUTTON_DEBOUNCE_MS) {
+      b.down = digitalRead(b.pin) == LOW;
+    }
+    interrupts();
+  }
+}
+
+// Take the oldest press, if any. Never blocks.
+bool buttonNextEvent(ButtonEvent &e) {
+  buttonResync();
+  uint8_t tail = buttonQueueTail;
+  if (tail == buttonQueueHead) {
+    return false;
+  }
+  e = buttonQueue[tail & (BUTTON_QUEUE_LEN - 1)];
+  buttonQueueTail = tail + 1;
+  return true;
+}
+
+#endif
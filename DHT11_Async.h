@@ -0,0 +1,174 @@
+// Non-blocking DHT11 reader
+//
+// The DHT library bit-bangs each read with interrupts disabled for ~20-25 ms.
+// This reader instead:
+//   1. dht11Start() pulls the data line LOW (start signal) and returns
+//   2. dht11Poll() releases the line after DHT11_START_LOW_MS and attaches a
+//      CHANGE interrupt that timestamps every edge of the sensor's reply
+//   3. once the reply is complete (or times out), dht11Poll() decodes the
+//      40-bit frame from the edge timings, checks the checksum and
+//      publishes temperature/humidity
+//
+// Call dht11Poll() often (every loop); it never waits. A task that polls
+// less often should sleep dht11WaitMs() between polls instead of its own
+// period, or the start signal lasts until the next poll rather than
+// DHT11_START_LOW_MS.
+// Only one DHT11 per sketch is supported since the ISR has no arguments.
+
+#ifndef DHT11_ASYNC_H
+#define DHT11_ASYNC_H
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+#define DHT11_START_LOW_MS   20     // host start signal, datasheet minimum is 18 ms
+#define DHT11_REPLY_US       10000  // whole reply takes ~5 ms
+#define DHT11_MAX_EDGES      90     // 84 expected + margin for the release edge
+#define DHT11_BIT_ONE_US     48     // HIGH pulse: ~27 us = 0, ~70 us = 1
+
+enum Dht11State { DHT11_IDLE, DHT11_START_LOW, DHT11_RECEIVING };
+
+enum Dht11Result {
+  DHT11_OK,
+  DHT11_ERR_TIMEOUT,   // fewer than 41 HIGH pulses (no sensor / bad wiring)
+  DHT11_ERR_CHECKSUM
+};
+
+struct Dht11Reader {
+  uint8_t pin;
+  Dht11State state;
+  unsigned long stateStart;
+  volatile uint8_t edgeCount;
+  volatile uint16_t edgeTimes[DHT11_MAX_EDGES];   // low 16 bits of micros()
+  volatile uint8_t edgeLevels[DHT11_MAX_EDGES];   // pin level after the edge
+  // Published results
+  Dht11Result lastResult;
+  float temperature;   // °C, NAN until the first good read
+  float humidity;      // %RH
+  unsigned long lastUpdate;
+  uint32_t reads, timeouts, checksumErrors;
+};
+
+Dht11Reader dht11;
+
+void IRAM_ATTR dht11OnEdge() {
+  uint8_t n = dht11.edgeCount;
+  if (n < DHT11_MAX_EDGES) {
+    dht11.edgeTimes[n] = (uint16_t)micros();
+    dht11.edgeLevels[n] = digitalRead(dht11.pin);
+    dht11.edgeCount = n + 1;
+  }
+}
+
+// Decode 5 bytes from recorded edges. The data bits are the last 40
+// complete HIGH pulses (rising edge followed by falling edge); anything
+// before them is the release edge and the sensor's 80 us response.
+inline Dht11Result dht11Decode(const volatile uint16_t *times, const volatile uint8_t *levels,
+                               uint8_t count, uint8_t data[5]) {
+  uint8_t widths[DHT11_MAX_EDGES / 2];
+  uint8_t pulses = 0;
+  for (uint8_t i = 0; i + 1 < count; i++) {
+    if (levels[i] == HIGH && levels[i + 1] == LOW) {
+      uint16_t w = (uint16_t)(times[i + 1] - times[i]);
+      widths[pulses++] = w > 255 ? 255 : w;
+    }
+  }
+  if (pulses < 41) {
+    return DHT11_ERR_TIMEOUT;
+  }
+  const uint8_t *bits = widths + pulses - 40;
+  for (uint8_t i = 0; i < 5; i++) {
+    uint8_t b = 0;
+    for (uint8_t j = 0; j < 8; j++) {
+      b = (b << 1) | (bits[i * 8 + j] > DHT11_BIT_ONE_US ? 1 : 0);
+    }
+    data[i] = b;
+  }
+  if ((uint8_t)(data[0] + data[1] + data[2] + data[3]) != data[4]) {
+    return DHT11_ERR_CHECKSUM;
+  }
+  return DHT11_OK;
+}
+
+void dht11Begin(uint8_t pin) {
+  dht11.pin = pin;
+  dht11.state = DHT11_IDLE;
+  dht11.lastResult = DHT11_ERR_TIMEOUT;
+  dht11.temperature = NAN;
+  dht11.humidity = NAN;
+  pinMode(pin, INPUT_PULLUP);
+}
+
+// Begin a read (no-op if one is already in progress). DHT11 needs >= 1 s between reads.
+void dht11Start() {
+  if (dht11.state != DHT11_IDLE) {
+    return;
+  }
+  pinMode(dht11.pin, OUTPUT);
+  digitalWrite(dht11.pin, LOW);
+  dht11.stateStart = millis();
+  dht11.state = DHT11_START_LOW;
+}
+
+// Milliseconds until dht11Poll() has the next step to take
+unsigned long dht11WaitMs() {
+  if (dht11.state == DHT11_START_LOW) {
+    unsigned long elapsed = millis() - dht11.stateStart;
+    return elapsed >= DHT11_START_LOW_MS ? 0 : DHT11_START_LOW_MS - elapsed;
+  }
+  if (dht11.state == DHT11_RECEIVING) {
+    unsigned long elapsed = micros() - dht11.stateStart;
+    return elapsed >= DHT11_REPLY_US ? 0 : (DHT11_REPLY_US - elapsed) / 1000 + 1;
+  }
+  return 0;
+}
+
+// Advance the state machine. Returns true when a read finished; check
+// dht11.lastResult, since temperature/humidity only change on a good read.
+bool dht11Poll() {
+  switch (dht11.state) {
+    case DHT11_IDLE:
+      return false;
+
+    case DHT11_START_LOW:
+      if (millis() - dht11.stateStart < DHT11_START_LOW_MS) {
+        return false;
+      }
+      // Release the line and let the ISR timestamp the reply
+      dht11.edgeCount = 0;
+      attachInterrupt(digitalPinToInterrupt(dht11.pin), dht11OnEdge, CHANGE);
+      pinMode(dht11.pin, INPUT_PULLUP);
+      dht11.stateStart = micros();
+      dht11.state = DHT11_RECEIVING;
+      return false;
+
+    case DHT11_RECEIVING: {
+      if (dht11.edgeCount < DHT11_MAX_EDGES && micros() - dht11.stateStart < DHT11_REPLY_US) {
+        return false;
+      }
+      detachInterrupt(digitalPinToInterrupt(dht11.pin));
+      dht11.state = DHT11_IDLE;
+      dht11.reads++;
+
+      uint8_t data[5];
+      Dht11Result result = dht11Decode(dht11.edgeTimes, dht11.edgeLevels, dht11.edgeCount, data);
+      dht11.lastResult = result;
+      if (result == DHT11_ERR_TIMEOUT) {
+        dht11.timeouts++;
+      } else if (result == DHT11_ERR_CHECKSUM) {
+        dht11.checksumErrors++;
+      } else {
+        // Byte 0/1 = humidity integer/decimal, 2/3 = temperature (bit 7 of byte 3 = negative)
+        dht11.humidity = data[0] + data[1] * 0.1;
+        float t = data[2] + (data[3] & 0x7F) * 0.1;
+        dht11.temperature = (data[3] & 0x80) ? -t : t;
+        dht11.lastUpdate = millis();
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+#endif
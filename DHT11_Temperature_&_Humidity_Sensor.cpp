@@ -1,29 +1,33 @@
-#include "DHT.h"
+#include "DHT11_Async.h"
 
-#define DHTPIN 7
-#define DHTTYPE DHT11
+#define DHTPIN 2   // moved from D7: the reader needs an interrupt pin (D2/D3 on Uno)
 
-DHT dht(DHTPIN, DHTTYPE);
+unsigned long lastReadStart = 0;
 
 void setup() {
   Serial.begin(9600);
-  dht.begin();
+  dht11Begin(DHTPIN);
 }
 
 void loop() {
-  float h = dht.readHumidity();
-  float t = dht.readTemperature();
+  // Start a new reading every 2 seconds; loop() keeps running meanwhile
+  if (millis() - lastReadStart >= 2000) {
+    lastReadStart = millis();
+    dht11Start();
+  }
+
+  if (!dht11Poll()) {
+    return;   // no new reading yet
+  }
 
-  if (isnan(h) || isnan(t)) {
+  if (dht11.lastResult != DHT11_OK) {
     Serial.println("Failed to read from DHT sensor!");
     return;
   }
 
   Serial.print("Humidity: ");
-  Serial.print(h);
+  Serial.print(dht11.humidity);
   Serial.print(" % | Temperature: ");
-  Serial.print(t);
+  Serial.print(dht11.temperature);
   Serial.println(" °C");
-
-  delay(2000);
 }
@@ -0,0 +1,212 @@
+// Deferred binary logging: a log call stores a compact record in a RAM ring
+// and logDrain() sends it later, only as fast as the serial port takes it.
+// The code that logs never waits for the port.
+//
+// Each sketch declares its messages once, in an X-macro catalog (one
+// X(id, format) per line, lines continued with a backslash):
+//
+//   #define TRAFFIC_LOG(X)
+//     X(LOG_VEHICLE, "Road %c: Vehicle #%d detected!")
+//     X(LOG_GREEN,   "Road %c: GREEN (%ds)")
+//   LOG_CATALOG(TRAFFIC_LOG)
+//
+//   LOG(LOG_VEHICLE, 'A' + i, vehicleCount[i]);
+//   logDrain();   // somewhere that runs often
+//
+// Record layout, little-endian:
+//   0x1E (ASCII record separator), message ID, argument count,
+//   millis() (4 bytes), then 4 bytes per argument.
+// Integers are sent as 32 bits and float/double as float. Format strings
+// stay in flash and are never sent. tools/log_decode.py reads the catalog
+// from the sketch source and turns the stream back into text.
+//
+// Plain Serial prints pass through the decoder unchanged, as long as they
+// don't land in the middle of a record. Call logFlush() before making one.
+//
+// Arguments must be numbers or chars (%d %u %ld %x %c %f ...); strings
+// can't be sent. LOG() checks at compile time that the argument count
+// matches the format. When the ring is full, new records are dropped, and
+// a later record says how many were lost.
+//
+// Define LOG_DEFERRED 0 to format the text on the board instead. It uses
+// the same ring and needs no decoder; on AVR, %f prints "?".
+
+#ifndef DEFERRED_LOG_H
+#define DEFERRED_LOG_H
+
+#ifndef LOG_DEFERRED
+#define LOG_DEFERRED 1
+#endif
+#ifndef LOG_RING_SIZE
+#define LOG_RING_SIZE 256      // bytes, power of two
+#endif
+#ifndef LOG_SERIAL
+#define LOG_SERIAL Serial
+#endif
+#define LOG_SYNC 0x1E
+#define LOG_HEADER_LEN 7
+#define LOG_MAX_ARGS 8
+#define LOG_TEXT_MAX 120       // longest line with LOG_DEFERRED 0
+
+// Both cores may log on the ESP32; elsewhere this only guards against ISRs
+#if defined(ESP32)
+portMUX_TYPE logMux = portMUX_INITIALIZER_UNLOCKED;
+#define LOG_LOCK() portENTER_CRITICAL(&logMux)
+#define LOG_UNLOCK() portEXIT_CRITICAL(&logMux)
+#elif defined(__AVR__)
+// Save and restore SREG so logging from an ISR (or with interrupts already
+// masked) doesn't turn them back on
+#define LOG_LOCK() uint8_t logSreg = SREG; cli()
+#define LOG_UNLOCK() SREG = logSreg
+#else
+#define LOG_LOCK() noInterrupts()
+#define LOG_UNLOCK() interrupts()
+#endif
+
+// Number of conversions in a format, for the compile-time argument check
+constexpr uint8_t logCountArgs(const char *f) {
+  return *f == 0 ? 0
+       : *f != '%' ? logCountArgs(f + 1)
+       : f[1] == '%' ? logCountArgs(f + 2)
+       : 1 + logCountArgs(f + 1);
+}
+
+template <uint8_t N> struct LogArity { static const uint8_t value = N; };
+template <typename... Args> LogArity<sizeof...(Args)> logArity(Args...);  // never defined
+
+#define LOG_CATALOG_ID(id, format) id,
+#define LOG_CATALOG_FORMAT(id, format) const char id##_FORMAT[] PROGMEM = format;
+#define LOG_CATALOG_FORMAT_PTR(id, format) id##_FORMAT,
+#define LOG_CATALOG_ARGC(id, format) logCountArgs(format),
+
+// Message IDs (ID 0 is the dropped-records notice), formats and argument counts
+#define LOG_CATALOG(CATALOG) \
+  enum LogId : uint8_t { LOG_DROPPED, CATALOG(LOG_CATALOG_ID) LOG_ID_COUNT }; \
+  const char LOG_DROPPED_FORMAT[] PROGMEM = "(%lu log records dropped)"; \
+  CATALOG(LOG_CATALOG_FORMAT) \
+  const char *const logFormats[LOG_ID_COUNT] PROGMEM = {LOG_DROPPED_FORMAT, CATALOG(LOG_CATALOG_FORMAT_PTR)}; \
+  constexpr uint8_t logArgCounts[LOG_ID_COUNT] = {1, CATALOG(LOG_CATALOG_ARGC)};
+
+#define LOG(id, ...) do { \
+    static_assert(decltype(logArity(__VA_ARGS__))::value == logArgCounts[id], \
+                  "LOG() arguments don't match the message format"); \
+    logEmit(&logFormats[id], id, ##__VA_ARGS__); \
+  } while (0)
+
+uint8_t logRing[LOG_RING_SIZE];
+volatile uint16_t logHead = 0;        // free-running, advanced by logPush()
+volatile uint16_t logTail = 0;        // free-running, advanced by logDrain()
+uint32_t logDropped = 0;              // records lost since the last notice
+
+// Argument encoding: 32-bit integers, floats as float
+template <typename T> inline uint32_t logWord(T v) { return (uint32_t)v; }
+inline uint32_t logWord(float v) {
+  uint32_t w;
+  memcpy(&w, &v, 4);
+  return w;
+}
+inline uint32_t logWord(double v) { return logWord((float)v); }
+uint32_t logWord(const char *v) = delete;   // strings can't be deferred
+
+inline void logHeader(uint8_t *record, uint8_t id, uint8_t argc) {
+  uint32_t now = millis();
+  record[0] = LOG_SYNC;
+  record[1] = id;
+  record[2] = argc;
+  memcpy(record + 3, &now, 4);
+}
+
+// The "records dropped" notice, as a record or as text
+uint8_t logDroppedNotice(uint8_t *buf, uint32_t count) {
+#if LOG_DEFERRED
+  logHeader(buf, 0, 1);   // LOG_DROPPED
+  memcpy(buf + LOG_HEADER_LEN, &count, 4);
+  return LOG_HEADER_LEN + 4;
+#else
+  return snprintf((char *)buf, 32, "(%lu log records dropped)\r\n", (unsigned long)count);
+#endif
+}
+
+inline void logCopy(const uint8_t *data, uint8_t len) {
+  uint16_t head = logHead;
+  for (uint8_t i = 0; i < len; i++) {
+    logRing[(head + i) & (LOG_RING_SIZE - 1)] = data[i];
+  }
+  logHead = head + len;
+}
+
+// Queue one whole record, or drop it if the ring can't take it
+void logPush(const uint8_t *record, uint8_t len) {
+  uint8_t notice[32];
+  LOG_LOCK();
+  uint8_t noticeLen = logDropped ? logDroppedNotice(notice, logDropped) : 0;
+  uint16_t space = LOG_RING_SIZE - (uint16_t)(logHead - logTail);
+  if (space < noticeLen + len) {
+    logDropped++;
+  } else {
+    if (noticeLen) {
+      logCopy(notice, noticeLen);
+      logDropped = 0;
+    }
+    logCopy(record, len);
+  }
+  LOG_UNLOCK();
+}
+
+template <typename... Args> void logEmit(const char *const *format, uint8_t id, Args... args) {
+  static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "too many LOG() arguments");
+#if LOG_DEFERRED
+  (void)format;
+  uint32_t words[sizeof...(Args) + 1] = {logWord(args)...};
+  uint8_t record[LOG_HEADER_LEN + 4 * sizeof...(Args)];
+  logHeader(record, id, sizeof...(Args));
+  memcpy(record + LOG_HEADER_LEN, words, 4 * sizeof...(Args));
+  logPush(record, sizeof(record));
+#else
+  (void)id;
+  char line[LOG_TEXT_MAX + 2];
+#if defined(__AVR__)
+  int len = snprintf_P(line, LOG_TEXT_MAX, (const char *)pgm_read_ptr(format), args...);
+#else
+  int len = snprintf(line, LOG_TEXT_MAX, *format, args...);
+#endif
+  if (len >= LOG_TEXT_MAX) {
+    len = LOG_TEXT_MAX - 1;
+  }
+  line[len++] = '\r';
+  line[len++] = '\n';
+  logPush((const uint8_t *)line, len);
+#endif
+}
+
+// Send as much as the serial port takes without blocking; call it often
+void logDrain() {
+  LOG_LOCK();
+  uint16_t head = logHead;
+  LOG_UNLOCK();
+  uint16_t tail = logTail;
+  while (tail != head) {
+    int room = LOG_SERIAL.availableForWrite();
+    if (room <= 0) {
+      break;
+    }
+    uint16_t offset = tail & (LOG_RING_SIZE - 1);
+    uint16_t chunk = head - tail;
+    if (chunk > LOG_RING_SIZE - offset) chunk = LOG_RING_SIZE - offset;
+    if (chunk > (uint16_t)room) chunk = room;
+    LOG_SERIAL.write(logRing + offset, chunk);
+    tail += chunk;
+    LOG_LOCK();
+    logTail = tail;
+    LOG_UNLOCK();
+  }
+}
+
+// Send everything queued, waiting for the port (e.g. before a direct print)
+void logFlush() {
+  while (logTail != logHead) {
+    logDrain();
+  }
+}
+
+#endif
@@ -0,0 +1,277 @@
+// Compile-time GPIO: pins as template parameters, lowered to direct
+// register access
+//
+//   typedef FastPin<13> Led;          Led::output(); Led::high(); Led::toggle();
+//   typedef FastPinGroup<2, 3, 4> Rgb;  Rgb::output(); Rgb::write(0b101);
+//
+// The pin number is known at compile time, so there are no lookup tables
+// or pin checks at run time:
+//   AVR Uno/Nano/Mega: a write is one SBI/CBI on ports A-G (2 cycles vs
+//     ~50 for digitalWrite()). Mega ports H-L are outside the SBI range;
+//     there a write is a short read-modify-write with interrupts masked.
+//     toggle() writes PINx, which flips the output in one instruction.
+//   ESP32: writes go to the GPIO out_w1ts / out_w1tc registers, which set
+//     or clear only the given bits, so they are safe from ISRs and the
+//     other core without a lock (a couple of cycles vs ~1 us for
+//     digitalWrite()).
+//   Anything else (e.g. the native simulator): plain digitalWrite().
+//
+// latched() returns the level an output was last driven to, read from the
+// output latch, never the pin itself.
+//
+// FastPinGroup::write() sets all of its pins from a bit mask (bit i = i-th
+// pin). On AVR that is one write per port involved, made with interrupts
+// masked, so code on the board never sees a half-updated group (the pins of
+// different ports change a few cycles apart). On ESP32 it is a set and then
+// a clear per GPIO bank: the new high pins go up a few ns before the new low
+// ones go down, and an ISR or the other core may run in between. Writing
+// GPIO.out in one read-modify-write instead would lose W1TS/W1TC writes
+// made meanwhile from the other core, so it isn't done. None of this
+// shows on a lamp or LED.
+//
+// test/test_fast_gpio runs the AVR code on the host against an array of
+// registers (FAST_GPIO_HOST_REGS) and times it against digitalWrite() on
+// the simulator.
+//
+// Setting the pin mode goes through pinMode(); it is not on a hot path.
+
+#ifndef FAST_GPIO_H
+#define FAST_GPIO_H
+
+#if defined(FAST_GPIO_HOST_REGS)
+#define FAST_GPIO_AVR 1
+#define FAST_GPIO_MEGA 1
+#elif defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__) || defined(__AVR_ATmega2560__) || \
+    defined(__AVR_ATmega1280__)
+#define FAST_GPIO_AVR 1
+#if defined(__AVR_ATmega2560__) || defined(__AVR_ATmega1280__)
+#define FAST_GPIO_MEGA 1
+#endif
+#elif defined(ESP32)
+#define FAST_GPIO_ESP32 1
+#include <soc/soc.h>
+#include <soc/gpio_reg.h>
+#endif
+
+#if FAST_GPIO_AVR
+
+// Each pin is encoded as port index << 3 | bit (A = 0, B = 1, ... L = 10; there is no port I)
+#define FAST_GPIO_PA 0
+#define FAST_GPIO_PB 1
+#define FAST_GPIO_PC 2
+#define FAST_GPIO_PD 3
+#define FAST_GPIO_PE 4
+#define FAST_GPIO_PF 5
+#define FAST_GPIO_PG 6
+#define FAST_GPIO_PH 7
+#define FAST_GPIO_PJ 8
+#define FAST_GPIO_PK 9
+#define FAST_GPIO_PL 10
+#define FAST_GPIO_PORTS 11
+#define FG(port, bit) ((FAST_GPIO_P##port << 3) | (bit))
+
+// Data-memory address of each port's PINx register; DDRx and PORTx follow it
+constexpr uint16_t fastGpioPinRegs[FAST_GPIO_PORTS] = {
+  0x20, 0x23, 0x26, 0x29, 0x2C, 0x2F, 0x32, 0x100, 0x103, 0x106, 0x109
+};
+
+#if FAST_GPIO_MEGA
+// Arduino Mega pin numbers (as in the core's pins_arduino.h)
+constexpr uint8_t fastGpioPins[] = {
+  FG(E, 0), FG(E, 1), FG(E, 4), FG(E, 5), FG(G, 5), FG(E, 3), FG(H, 3), FG(H, 4),   // 0-7
+  FG(H, 5), FG(H, 6), FG(B, 4), FG(B, 5), FG(B, 6), FG(B, 7), FG(J, 1), FG(J, 0),   // 8-15
+  FG(H, 1), FG(H, 0), FG(D, 3), FG(D, 2), FG(D, 1), FG(D, 0), FG(A, 0), FG(A, 1),   // 16-23
+  FG(A, 2), FG(A, 3), FG(A, 4), FG(A, 5), FG(A, 6), FG(A, 7), FG(C, 7), FG(C, 6),   // 24-31
+  FG(C, 5), FG(C, 4), FG(C, 3), FG(C, 2), FG(C, 1), FG(C, 0), FG(D, 7), FG(G, 2),   // 32-39
+  FG(G, 1), FG(G, 0), FG(L, 7), FG(L, 6), FG(L, 5), FG(L, 4), FG(L, 3), FG(L, 2),   // 40-47
+  FG(L, 1), FG(L, 0), FG(B, 3), FG(B, 2), FG(B, 1), FG(B, 0), FG(F, 0), FG(F, 1),   // 48-55
+  FG(F, 2), FG(F, 3), FG(F, 4), FG(F, 5), FG(F, 6), FG(F, 7), FG(K, 0), FG(K, 1),   // 56-63
+  FG(K, 2), FG(K, 3), FG(K, 4), FG(K, 5), FG(K, 6), FG(K, 7)                        // 64-69
+};
+#else
+// Uno / Nano: D0-D7 = PORTD, D8-D13 = PORTB, A0-A5 (14-19) = PORTC
+constexpr uint8_t fastGpioPins[] = {
+  FG(D, 0), FG(D, 1), FG(D, 2), FG(D, 3), FG(D, 4), FG(D, 5), FG(D, 6), FG(D, 7),
+  FG(B, 0), FG(B, 1), FG(B, 2), FG(B, 3), FG(B, 4), FG(B, 5),
+  FG(C, 0), FG(C, 1), FG(C, 2), FG(C, 3), FG(C, 4), FG(C, 5)
+};
+#endif
+
+#undef FG
+
+constexpr uint8_t fastGpioPort(uint8_t pin) { return fastGpioPins[pin] >> 3; }
+constexpr uint8_t fastGpioMask(uint8_t pin) { return 1 << (fastGpioPins[pin] & 7); }
+
+#ifdef FAST_GPIO_HOST_REGS
+inline volatile uint8_t &fastGpioReg(uint16_t address) { return FAST_GPIO_HOST_REGS[address]; }
+#else
+inline volatile uint8_t &fastGpioReg(uint16_t address) { return *(volatile uint8_t *)address; }
+#endif
+
+template <uint8_t Pin> struct FastPin {
+  static_assert(Pin < sizeof(fastGpioPins), "no such pin on this board");
+  static constexpr uint16_t pinReg = fastGpioPinRegs[fastGpioPort(Pin)];
+  static constexpr uint16_t portReg = pinReg + 2;
+  static constexpr uint8_t mask = fastGpioMask(Pin);
+  static constexpr bool sbiReachable = portReg < 0x40;  // I/O space 0x00-0x1F
+
+  static void output() { pinMode(Pin, OUTPUT); }
+  static void input() { pinMode(Pin, INPUT); }
+  static void inputPullup() { pinMode(Pin, INPUT_PULLUP); }
+
+  static inline void high() {
+    if (sbiReachable) {
+      fastGpioReg(portReg) |= mask;
+    } else {
+      uint8_t sreg = SREG;
+      cli();
+      fastGpioReg(portReg) |= mask;
+      SREG = sreg;
+    }
+  }
+  static inline void low() {
+    if (sbiReachable) {
+      fastGpioReg(portReg) &= (uint8_t)~mask;
+    } else {
+      uint8_t sreg = SREG;
+      cli();
+      fastGpioReg(portReg) &= (uint8_t)~mask;
+      SREG = sreg;
+    }
+  }
+  static inline void write(bool level) { level ? high() : low(); }
+  static inline void toggle() { fastGpioReg(pinReg) = mask; }
+  static inline bool read() { return fastGpioReg(pinReg) & mask; }
+  static inline bool latched() { return fastGpioReg(portReg) & mask; }
+};
+
+// Mask of the group's pins on one port, and the port bits for a group value.
+// Recursion over the pin list (Arduino AVR builds with C++11).
+template <uint8_t Port, uint8_t Index, uint8_t... Pins> struct FastGpioPortBits {
+  static constexpr uint8_t mask = 0;
+  static inline uint8_t value(uint16_t) { return 0; }
+};
+
+template <uint8_t Port, uint8_t Index, uint8_t Pin, uint8_t... Rest>
+struct FastGpioPortBits<Port, Index, Pin, Rest...> {
+  typedef FastGpioPortBits<Port, Index + 1, Rest...> Next;
+  static constexpr uint8_t bit = fastGpioPort(Pin) == Port ? fastGpioMask(Pin) : 0;
+  static constexpr uint8_t mask = bit | Next::mask;
+  static inline uint8_t value(uint16_t bits) { return ((bits >> Index) & 1 ? (uint8_t)bit : 0) | Next::value(bits); }
+};
+
+template <uint8_t Port, uint8_t... Pins> struct FastGpioGroupWriter {
+  static inline void write(uint16_t bits) {
+    typedef FastGpioPortBits<Port, 0, Pins...> Bits;
+    if (Bits::mask) {
+      volatile uint8_t &reg = fastGpioReg(fastGpioPinRegs[Port] + 2);
+      reg = (reg & (uint8_t)~Bits::mask) | Bits::value(bits);
+    }
+    FastGpioGroupWriter<Port + 1, Pins...>::write(bits);
+  }
+};
+
+template <uint8_t... Pins> struct FastGpioGroupWriter<FAST_GPIO_PORTS, Pins...> {
+  static inline void write(uint16_t) {}
+};
+
+template <uint8_t... Pins> struct FastPinGroup {
+  static void output() {
+    const uint8_t pins[] = {Pins...};
+    for (uint8_t pin : pins) pinMode(pin, OUTPUT);
+  }
+  static inline void write(uint16_t bits) {
+    uint8_t sreg = SREG;
+    cli();
+    FastGpioGroupWriter<0, Pins...>::write(bits);
+    SREG = sreg;
+  }
+};
+
+#elif FAST_GPIO_ESP32
+
+template <uint8_t Pin> struct FastPin {
+  static_assert(Pin < 34, "GPIO 34-39 are input only");
+  static constexpr uint32_t mask = 1UL << (Pin & 31);
+
+  static void output() { pinMode(Pin, OUTPUT); }
+  static void input() { pinMode(Pin, INPUT); }
+  static void inputPullup() { pinMode(Pin, INPUT_PULLUP); }
+
+  static inline void high() {
+    REG_WRITE(Pin < 32 ? GPIO_OUT_W1TS_REG : GPIO_OUT1_W1TS_REG, mask);
+  }
+  static inline void low() {
+    REG_WRITE(Pin < 32 ? GPIO_OUT_W1TC_REG : GPIO_OUT1_W1TC_REG, mask);
+  }
+  static inline void write(bool level) { level ? high() : low(); }
+  static inline bool latched() { return REG_READ(Pin < 32 ? GPIO_OUT_REG : GPIO_OUT1_REG) & mask; }
+  static inline void toggle() { latched() ? low() : high(); }
+  static inline bool read() { return REG_READ(Pin < 32 ? GPIO_IN_REG : GPIO_IN1_REG) & mask; }
+};
+
+// Bits of a group value that land in one GPIO bank (0 = GPIO 0-31, 1 = 32-33)
+template <uint8_t Bank, uint8_t Index, uint8_t... Pins> struct FastGpioBankBits {
+  static constexpr uint32_t mask = 0;
+  static inline uint32_t value(uint16_t) { return 0; }
+};
+
+template <uint8_t Bank, uint8_t Index, uint8_t Pin, uint8_t... Rest>
+struct FastGpioBankBits<Bank, Index, Pin, Rest...> {
+  typedef FastGpioBankBits<Bank, Index + 1, Rest...> Next;
+  static constexpr uint32_t bit = (Pin >> 5) == Bank ? 1UL << (Pin & 31) : 0;
+  static constexpr uint32_t mask = bit | Next::mask;
+  static inline uint32_t value(uint16_t bits) { return ((bits >> Index) & 1 ? (uint32_t)bit : 0) | Next::value(bits); }
+};
+
+template <uint8_t... Pins> struct FastPinGroup {
+  static void output() {
+    const uint8_t pins[] = {Pins...};
+    for (uint8_t pin : pins) pinMode(pin, OUTPUT);
+  }
+  static inline void write(uint16_t bits) {
+    typedef FastGpioBankBits<0, 0, Pins...> Bank0;
+    typedef FastGpioBankBits<1, 0, Pins...> Bank1;
+    uint32_t set0 = Bank0::value(bits), set1 = Bank1::value(bits);
+    if (Bank0::mask) {
+      REG_WRITE(GPIO_OUT_W1TS_REG, set0);
+      REG_WRITE(GPIO_OUT_W1TC_REG, Bank0::mask & ~set0);
+    }
+    if (Bank1::mask) {
+      REG_WRITE(GPIO_OUT1_W1TS_REG, set1);
+      REG_WRITE(GPIO_OUT1_W1TC_REG, Bank1::mask & ~set1);
+    }
+  }
+};
+
+#else
+
+// Portable fallback
+template <uint8_t Pin> struct FastPin {
+  static void output() { pinMode(Pin, OUTPUT); }
+  static void input() { pinMode(Pin, INPUT); }
+  static void inputPullup() { pinMode(Pin, INPUT_PULLUP); }
+  static inline void high() { digitalWrite(Pin, HIGH); }
+  static inline void low() { digitalWrite(Pin, LOW); }
+  static inline void write(bool level) { digitalWrite(Pin, level ? HIGH : LOW); }
+  static inline bool latched() { return digitalRead(Pin) == HIGH; }
+  static inline void toggle() { write(!latched()); }
+  static inline bool read() { return digitalRead(Pin) == HIGH; }
+};
+
+template <uint8_t... Pins> struct FastPinGroup {
+  static void output() {
+    const uint8_t pins[] = {Pins...};
+    for (uint8_t pin : pins) pinMode(pin, OUTPUT);
+  }
+  static inline void write(uint16_t bits) {
+    const uint8_t pins[] = {Pins...};
+    for (uint8_t i = 0; i < sizeof(pins); i++) {
+      digitalWrite(pins[i], (bits >> i) & 1 ? HIGH : LOW);
+    }
+  }
+};
+
+#endif
+
+#endif
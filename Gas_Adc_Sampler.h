@@ -0,0 +1,201 @@
+// Background gas sensor sampling for the ESP32 Transmitter
+//
+// The ADC runs in continuous (DMA) mode over all gas channels. Each
+// adcSamplerPoll() folds the conversion frames collected since the last
+// one into a per-channel decimator, so the sketch only reads the latest
+// filtered value.
+//
+// Decimation per channel:
+//   1. Oversample: sum 4^bits raw samples and shift right by bits, giving
+//      `bits` extra effective bits (noise must be >= 1 LSB, which MQ
+//      sensors easily provide).
+//   2. Smooth: first-order IIR on the oversampled values
+//      (y += (x - y) >> smoothShift).
+
+#ifndef GAS_ADC_SAMPLER_H
+#define GAS_ADC_SAMPLER_H
+
+#include <stdint.h>
+
+#define ADC_SAMPLER_CHANNELS   4
+#define ADC_SAMPLE_RATE_HZ     5000  // per channel; ESP32 DMA needs >= 20 kHz in total
+#define ADC_RAW_BITS           12
+
+// Channel order used by the sampler
+#define ADC_CH_MQ7    0
+#define ADC_CH_MQ5    1
+#define ADC_CH_MQ135  2
+#define ADC_CH_O2     3
+
+struct AdcChannelConfig {
+  uint8_t pin;
+  uint8_t oversampleBits;  // 4^bits samples per decimated output
+  uint8_t smoothShift;     // IIR time constant, 0 = no smoothing
+};
+
+struct AdcDecimator {
+  uint8_t oversampleBits;
+  uint8_t smoothShift;
+  uint16_t count;              // samples in the current oversampling block
+  uint32_t sum;
+  volatile uint32_t filtered;  // (ADC_RAW_BITS + oversampleBits)-bit value << 8
+  volatile uint32_t outputs;   // decimated outputs produced so far
+};
+
+inline void adcDecimatorInit(AdcDecimator &d, uint8_t oversampleBits, uint8_t smoothShift) {
+  d.oversampleBits = oversampleBits;
+  d.smoothShift = smoothShift;
+  d.count = 0;
+  d.sum = 0;
+  d.filtered = 0;
+  d.outputs = 0;
+}
+
+// Add one raw conversion
+inline void adcDecimatorAdd(AdcDecimator &d, uint16_t raw) {
+  d.sum += raw;
+  if (++d.count < (1u << (2 * d.oversampleBits))) {
+    return;
+  }
+  // Keep 8 fractional bits in the IIR state so small steps are not lost
+  uint32_t x = (d.sum >> d.oversampleBits) << 8;
+  if (d.outputs == 0 || d.smoothShift == 0) {
+    d.filtered = x;
+  } else {
+    int32_t y = (int32_t)d.filtered;
+    d.filtered = (uint32_t)(y + (((int32_t)x - y) >> d.smoothShift));
+  }
+  d.outputs++;
+  d.count = 0;
+  d.sum = 0;
+}
+
+// Latest value rounded back to raw ADC counts (ADC_RAW_BITS)
+inline uint16_t adcDecimatorRead(const AdcDecimator &d) {
+  uint8_t shift = d.oversampleBits + 8;
+  return (uint16_t)((d.filtered + (1u << (shift - 1))) >> shift);
+}
+
+AdcDecimator adcDecimators[ADC_SAMPLER_CHANNELS];
+
+#if defined(ESP32)
+
+// The IDF 4.4 DMA driver of the arduino-esp32 2.x core that the
+// espressif32 platform ships (IDF 5 replaced it with esp_adc/adc_continuous.h)
+#include <driver/adc.h>
+
+#define ADC_DMA_FRAME_BYTES    256
+#define ADC_DMA_POOL_BYTES     8192  // ~200 ms of conversions, two sample periods
+
+uint8_t adcChannelMap[SOC_ADC_MAX_CHANNEL_NUM];  // ADC1 channel -> sampler index + 1
+uint32_t adcFrames = 0;
+bool adcOverrun = false;   // the pool filled up between polls and conversions were lost
+
+// Configure and start DMA sampling of all channels. Returns false on driver errors.
+bool adcSamplerBegin(const AdcChannelConfig *channels) {
+  adc_digi_pattern_config_t pattern[ADC_SAMPLER_CHANNELS] = {};
+  uint16_t mask = 0;
+  for (int i = 0; i < ADC_SAMPLER_CHANNELS; i++) {
+    int8_t channel = digitalPinToAnalogChannel(channels[i].pin);
+    if (channel < 0 || channel >= ADC1_CHANNEL_MAX) {
+      return false;  // continuous mode only supports ADC1 pins (GPIO 32-39)
+    }
+    adcDecimatorInit(adcDecimators[i], channels[i].oversampleBits, channels[i].smoothShift);
+    adcChannelMap[channel] = i + 1;
+    mask |= 1 << channel;
+    pattern[i].atten = ADC_ATTEN_DB_11;
+    pattern[i].channel = channel;
+    pattern[i].unit = 0;   // ADC1
+    pattern[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+  }
+
+  adc_digi_init_config_t initConfig = {};
+  initConfig.max_store_buf_size = ADC_DMA_POOL_BYTES;
+  initConfig.conv_num_each_intr = ADC_DMA_FRAME_BYTES;
+  initConfig.adc1_chan_mask = mask;
+  if (adc_digi_initialize(&initConfig) != ESP_OK) {
+    return false;
+  }
+
+  adc_digi_configuration_t config = {};
+  config.conv_limit_en = true;   // required on the ESP32
+  config.conv_limit_num = 250;
+  config.pattern_num = ADC_SAMPLER_CHANNELS;
+  config.adc_pattern = pattern;
+  config.sample_freq_hz = ADC_SAMPLE_RATE_HZ * ADC_SAMPLER_CHANNELS;
+  config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+  config.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+  if (adc_digi_controller_configure(&config) != ESP_OK) {
+    return false;
+  }
+  return adc_digi_start() == ESP_OK;
+}
+
+// Fold the DMA frames converted since the last call into the decimators
+void adcSamplerPoll() {
+  uint8_t frame[ADC_DMA_FRAME_BYTES];
+  uint32_t length;
+  for (;;) {
+    esp_err_t err = adc_digi_read_bytes(frame, sizeof(frame), &length, 0);
+    if (err == ESP_ERR_INVALID_STATE) {
+      adcOverrun = true;   // still returns the data it has
+    } else if (err != ESP_OK) {
+      return;              // ESP_ERR_TIMEOUT: nothing more yet
+    }
+    for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= length; i += SOC_ADC_DIGI_RESULT_BYTES) {
+      const adc_digi_output_data_t *p = (const adc_digi_output_data_t *)&frame[i];
+      if (p->type1.channel >= SOC_ADC_MAX_CHANNEL_NUM) {
+        continue;
+      }
+      uint8_t idx = adcChannelMap[p->type1.channel];
+      if (idx != 0) {
+        adcDecimatorAdd(adcDecimators[idx - 1], p->type1.data);
+      }
+    }
+    adcFrames++;
+  }
+}
+
+#else
+
+// Other targets (the native simulator): no DMA, so adcSamplerPoll() reads
+// one oversampling block per channel with analogRead()
+uint8_t adcSamplerPins[ADC_SAMPLER_CHANNELS];
+uint32_t adcFrames = 0;
+
+bool adcSamplerBegin(const AdcChannelConfig *channels) {
+  for (int i = 0; i < ADC_SAMPLER_CHANNELS; i++) {
+    adcSamplerPins[i] = channels[i].pin;
+    adcDecimatorInit(adcDecimators[i], channels[i].oversampleBits, channels[i].smoothShift);
+  }
+  return true;
+}
+
+void adcSamplerPoll() {
+  for (int i = 0; i < ADC_SAMPLER_CHANNELS; i++) {
+    AdcDecimator &d = adcDecimators[i];
+    for (uint32_t n = 0; n < (1u << (2 * d.oversampleBits)); n++) {
+      adcDecimatorAdd(d, analogRead(adcSamplerPins[i]));
+    }
+  }
+  adcFrames++;
+}
+
+#endif
+
+// Latest filtered reading of a sampler channel in raw ADC counts
+inline uint16_t adcSamplerRead(uint8_t channel) {
+  return adcDecimatorRead(adcDecimators[channel]);
+}
+
+// True once every channel has produced at least one decimated output
+inline bool adcSamplerReady() {
+  for (int i = 0; i < ADC_SAMPLER_CHANNELS; i++) {
+    if (adcDecimators[i].outputs == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+#endif
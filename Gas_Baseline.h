@@ -0,0 +1,187 @@
+// Learned clean-air baseline of the MQ sensors, kept across restarts so a
+// transmitter can tell when its sensors have settled again instead of
+// always waiting out the full warmup
+//
+//   gasBaselineBegin(baseline);                  // setup(): load the saved one
+//   while warming, per reading:
+//     if (gasBaselineSettled(baseline, adc, now)) -> ready early
+//     after the full warmup instead:  gasBaselineReset(baseline, adc, now)
+//   once warm, per sample:  gasBaselineTrack(baseline, adc, now)
+//
+// adc[] holds the raw MQ7, MQ5 and MQ135 readings.
+//
+// Settled means every channel has stayed within 1/GAS_BASELINE_BAND of
+// its baseline, and moved less than 1/GAS_BASELINE_DRIFT of it, for
+// GAS_BASELINE_SETTLE_MS. A cold sensor only passes through the band on
+// its way down, so it doesn't qualify; after a short power blip the heater
+// is still warm and the readings are back within seconds.
+//
+// While warm, readings within 1/GAS_BASELINE_TRACK of the baseline are
+// folded into a slow average (time constant 2^GAS_BASELINE_SHIFT samples),
+// so a gas event doesn't become the new normal. The average is saved at
+// most every GAS_BASELINE_SAVE_MS, and only when it has moved, to spare the
+// flash: NVS (Preferences) on the ESP32, EEPROM elsewhere.
+
+#ifndef GAS_BASELINE_H
+#define GAS_BASELINE_H
+
+#include "Gas_Link_Protocol.h"
+#if defined(ESP32)
+#include <Preferences.h>
+#else
+#include <EEPROM.h>
+#endif
+
+#define GAS_BASELINE_CHANNELS 3
+#define GAS_BASELINE_BAND 16           // settled: within 1/16 (~6%) of the baseline
+#define GAS_BASELINE_DRIFT 64          // ... and moved less than 1/64 meanwhile
+#define GAS_BASELINE_SETTLE_MS 3000
+#define GAS_BASELINE_TRACK 4           // only readings within 1/4 are learned
+#define GAS_BASELINE_SHIFT 8           // ~13 minutes at one sample per 3 s
+#define GAS_BASELINE_SAVE_MS 1800000UL // 30 minutes
+#define GAS_BASELINE_MAGIC 0x4C534247UL  // "GBSL"
+#ifndef GAS_BASELINE_EEPROM_ADDR
+#define GAS_BASELINE_EEPROM_ADDR 0
+#endif
+
+struct GasBaseline {
+  uint16_t adc[GAS_BASELINE_CHANNELS];       // 0 = nothing saved yet
+  uint16_t saved[GAS_BASELINE_CHANNELS];     // what the flash holds
+  uint32_t average[GAS_BASELINE_CHANNELS];   // slow average (Q8)
+  uint16_t bandStart[GAS_BASELINE_CHANNELS]; // readings when they entered the band
+  unsigned long inBandSince;
+  bool inBand;
+  unsigned long lastSave;
+};
+
+// Stored layout: uint32 magic | 3 x uint16 readings | uint16 CRC-16 of the readings
+#define GAS_BASELINE_RECORD_LEN (4 + 2 * GAS_BASELINE_CHANNELS + 2)
+
+inline bool gasBaselineValid(const GasBaseline &b) {
+  for (uint8_t i = 0; i < GAS_BASELINE_CHANNELS; i++) {
+    if (b.adc[i] == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+inline bool gasBaselineReadRecord(uint8_t *record) {
+#if defined(ESP32)
+  Preferences prefs;
+  prefs.begin("gasbase", true);
+  size_t len = prefs.getBytes("r", record, GAS_BASELINE_RECORD_LEN);
+  prefs.end();
+  return len == GAS_BASELINE_RECORD_LEN;
+#else
+  for (uint8_t i = 0; i < GAS_BASELINE_RECORD_LEN; i++) {
+    record[i] = EEPROM.read(GAS_BASELINE_EEPROM_ADDR + i);
+  }
+  return true;
+#endif
+}
+
+inline void gasBaselineWriteRecord(const uint8_t *record) {
+#if defined(ESP32)
+  Preferences prefs;
+  prefs.begin("gasbase", false);
+  prefs.putBytes("r", record, GAS_BASELINE_RECORD_LEN);
+  prefs.end();
+#else
+  for (uint8_t i = 0; i < GAS_BASELINE_RECORD_LEN; i++) {
+    EEPROM.update(GAS_BASELINE_EEPROM_ADDR + i, record[i]);
+  }
+#endif
+}
+
+// Load the saved baseline. Returns false if there is none (first start,
+// or the stored copy is damaged).
+inline bool gasBaselineBegin(GasBaseline &b) {
+  memset(&b, 0, sizeof(b));
+  uint8_t record[GAS_BASELINE_RECORD_LEN];
+  if (!gasBaselineReadRecord(record) || gasLinkGet32(record) != GAS_BASELINE_MAGIC ||
+      gasLinkGet16(record + 4 + 2 * GAS_BASELINE_CHANNELS) !=
+        gasLinkCrc16(record + 4, 2 * GAS_BASELINE_CHANNELS)) {
+    return false;
+  }
+  for (uint8_t i = 0; i < GAS_BASELINE_CHANNELS; i++) {
+    b.adc[i] = b.saved[i] = gasLinkGet16(record + 4 + 2 * i);
+    b.average[i] = (uint32_t)b.adc[i] << 8;
+  }
+  return gasBaselineValid(b);
+}
+
+inline void gasBaselineSave(GasBaseline &b, unsigned long now) {
+  uint8_t record[GAS_BASELINE_RECORD_LEN];
+  gasLinkPut32(record, GAS_BASELINE_MAGIC);
+  for (uint8_t i = 0; i < GAS_BASELINE_CHANNELS; i++) {
+    gasLinkPut16(record + 4 + 2 * i, b.adc[i]);
+    b.saved[i] = b.adc[i];
+  }
+  gasLinkPut16(record + 4 + 2 * GAS_BASELINE_CHANNELS,
+               gasLinkCrc16(record + 4, 2 * GAS_BASELINE_CHANNELS));
+  gasBaselineWriteRecord(record);
+  b.lastSave = now;
+}
+
+inline uint16_t gasBaselineDiff(uint16_t a, uint16_t b) {
+  return a > b ? a - b : b - a;
+}
+
+// Feed one reading while warming up; true once the sensors have settled
+// back to the saved baseline
+inline bool gasBaselineSettled(GasBaseline &b, const uint16_t *adc, unsigned long now) {
+  if (!gasBaselineValid(b)) {
+    return false;
+  }
+  bool enteredNow = !b.inBand;
+  for (uint8_t i = 0; i < GAS_BASELINE_CHANNELS; i++) {
+    if ((uint32_t)gasBaselineDiff(adc[i], b.adc[i]) * GAS_BASELINE_BAND > b.adc[i] ||
+        (!enteredNow && (uint32_t)gasBaselineDiff(adc[i], b.bandStart[i]) * GAS_BASELINE_DRIFT > b.adc[i])) {
+      b.inBand = false;
+      return false;
+    }
+  }
+  if (enteredNow) {
+    b.inBand = true;
+    b.inBandSince = now;
+    memcpy(b.bandStart, adc, sizeof(b.bandStart));
+    return false;
+  }
+  return now - b.inBandSince >= GAS_BASELINE_SETTLE_MS;
+}
+
+// The sensors didn't settle to the saved baseline (or there was none):
+// start again from the readings at the end of the full warmup
+inline void gasBaselineReset(GasBaseline &b, const uint16_t *adc, unsigned long now) {
+  for (uint8_t i = 0; i < GAS_BASELINE_CHANNELS; i++) {
+    b.adc[i] = adc[i] ? adc[i] : 1;
+    b.average[i] = (uint32_t)b.adc[i] << 8;
+  }
+  b.inBand = false;
+  gasBaselineSave(b, now);
+}
+
+// Learn from one sample taken while warm; saves now and then
+inline void gasBaselineTrack(GasBaseline &b, const uint16_t *adc, unsigned long now) {
+  bool moved = false;
+  for (uint8_t i = 0; i < GAS_BASELINE_CHANNELS; i++) {
+    if ((uint32_t)gasBaselineDiff(adc[i], b.adc[i]) * GAS_BASELINE_TRACK > b.adc[i]) {
+      continue;  // gas or a changed room, not the baseline
+    }
+    int32_t error = ((int32_t)adc[i] << 8) - (int32_t)b.average[i];
+    b.average[i] += error / (1 << GAS_BASELINE_SHIFT);
+    b.adc[i] = (b.average[i] + 128) >> 8;
+    if (b.adc[i] == 0) {
+      b.adc[i] = 1;
+    }
+    if ((uint32_t)gasBaselineDiff(b.adc[i], b.saved[i]) * GAS_BASELINE_DRIFT > b.saved[i]) {
+      moved = true;
+    }
+  }
+  if (moved && now - b.lastSave >= GAS_BASELINE_SAVE_MS) {
+    gasBaselineSave(b, now);
+  }
+}
+
+#endif
@@ -0,0 +1,196 @@
+// Raw MQ sensor readings to ppm, without pow()/log() on the board
+//
+// An MQ sensor is a resistor Rs in series with the module's load resistor
+// RL, read at their junction, so
+//   Rs/RL = (ADC max - adc) / adc
+// R0 is Rs in clean air. The datasheet plots ppm against Rs/R0 as a
+// straight line on log-log axes, ppm = a * (Rs/R0)^b. That curve is stored
+// as a table of ppm at log-spaced Rs/R0 points (generated by
+// tools/gas_curves.py), and a reading is the linear interpolation between
+// the two entries around it. `python3 tools/gas_curves.py --check` compares
+// this integer lookup with the exact curves.
+//
+// Rs/R0 is Q10 fixed point (1024 = 1.0); Rs/RL and R0/RL are Q16 so a low
+// R0/RL (the MQ5's is ~0.08) keeps its precision. Only integer maths is
+// used, so the conversion is cheap on the Uno too.
+//
+//   GasSensor mq7 = {&GAS_CURVE_MQ7, 0};
+//   gasSensorBegin(mq7, cleanAirAdc);    // sets R0 from a clean-air reading
+//   uint16_t ppm = gasSensorPpm(mq7, analogRead(MQ7_PIN));
+//
+// Within each datasheet's range the result stays within ~1.5% of the
+// curve (plus 1 ppm of rounding); far above it, a Q10 Rs/R0 gets coarse.
+//
+// Readings outside the table (Rs/R0 below 1/16 or above 32) are clamped to
+// its ends; values above 65535 ppm read as 65535.
+
+#ifndef GAS_CALIBRATION_H
+#define GAS_CALIBRATION_H
+
+#include <stdint.h>
+
+// Full-scale ADC count; sketches may define their own before including
+#ifndef GAS_ADC_MAX
+#if defined(ESP32)
+#define GAS_ADC_MAX 4095
+#else
+#define GAS_ADC_MAX 1023
+#endif
+#endif
+
+#define GAS_RATIO_ONE 1024    // 1.0 in Q10
+
+struct GasCurve {
+  const uint16_t *ppm;        // GAS_CURVE_POINTS entries in PROGMEM
+  uint16_t cleanAirRatio;     // Rs/R0 in clean air (Q10), from the datasheet
+};
+
+struct GasSensor {
+  const GasCurve *curve;
+  uint32_t r0;                // R0/RL (Q16)
+};
+
+// --- generated by tools/gas_curves.py, do not edit ---
+#define GAS_CURVE_POINTS 145
+
+// Rs/R0 at each table entry, Q10 (2^(k/16) from 1/16 to 32)
+const uint16_t gasRatioPoints[GAS_CURVE_POINTS] PROGMEM = {
+  64, 67, 70, 73, 76, 79, 83, 87, 91, 95, 99, 103,
+  108, 112, 117, 123, 128, 134, 140, 146, 152, 159, 166, 173,
+  181, 189, 197, 206, 215, 225, 235, 245, 256, 267, 279, 292,
+  304, 318, 332, 347, 362, 378, 395, 412, 431, 450, 470, 490,
+  512, 535, 558, 583, 609, 636, 664, 693, 724, 756, 790, 825,
+  861, 899, 939, 981, 1024, 1069, 1117, 1166, 1218, 1272, 1328, 1387,
+  1448, 1512, 1579, 1649, 1722, 1798, 1878, 1961, 2048, 2139, 2233, 2332,
+  2435, 2543, 2656, 2774, 2896, 3025, 3158, 3298, 3444, 3597, 3756, 3922,
+  4096, 4277, 4467, 4664, 4871, 5087, 5312, 5547, 5793, 6049, 6317, 6597,
+  6889, 7194, 7512, 7845, 8192, 8555, 8933, 9329, 9742, 10173, 10624, 11094,
+  11585, 12098, 12634, 13193, 13777, 14387, 15024, 15689, 16384, 17109, 17867, 18658,
+  19484, 20347, 21247, 22188, 23170, 24196, 25268, 26386, 27554, 28774, 30048, 31379,
+  32768,
+};
+
+// MQ7, CO: ppm = 99.042 * (Rs/R0)^-1.518, Rs/R0 = 27.5 in clean air
+const uint16_t gasCurveMq7Ppm[GAS_CURVE_POINTS] PROGMEM = {
+  6663, 6239, 5842, 5470, 5122, 4796, 4491, 4205, 3937, 3687, 3452, 3232,
+  3027, 2834, 2654, 2485, 2327, 2178, 2040, 1910, 1788, 1675, 1568, 1468,
+  1375, 1287, 1205, 1129, 1057, 990, 927, 868, 812, 761, 712, 667,
+  624, 585, 548, 513, 480, 449, 421, 394, 369, 346, 324, 303,
+  284, 266, 249, 233, 218, 204, 191, 179, 168, 157, 147, 138,
+  129, 121, 113, 106, 99, 93, 87, 81, 76, 71, 67, 63,
+  59, 55, 51, 48, 45, 42, 39, 37, 35, 32, 30, 28,
+  27, 25, 23, 22, 20, 19, 18, 17, 16, 15, 14, 13,
+  12, 11, 11, 10, 9, 9, 8, 8, 7, 7, 6, 6,
+  5, 5, 5, 5, 4, 4, 4, 3, 3, 3, 3, 3,
+  2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  1,
+};
+const GasCurve GAS_CURVE_MQ7 = {gasCurveMq7Ppm, 28160};
+
+// MQ5, CH4: ppm = 177.65 * (Rs/R0)^-2.56, Rs/R0 = 6.5 in clean air
+const uint16_t gasCurveMq5Ppm[GAS_CURVE_POINTS] PROGMEM = {
+  65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 63431,
+  56772, 50812, 45478, 40704, 36431, 32607, 29184, 26120, 23378, 20924, 18728, 16762,
+  15002, 13427, 12018, 10756, 9627, 8617, 7712, 6902, 6178, 5529, 4949, 4429,
+  3964, 3548, 3176, 2842, 2544, 2277, 2038, 1824, 1633, 1461, 1308, 1170,
+  1048, 938, 839, 751, 672, 602, 539, 482, 431, 386, 346, 309,
+  277, 248, 222, 198, 178, 159, 142, 127, 114, 102, 91, 82,
+  73, 65, 59, 52, 47, 42, 38, 34, 30, 27, 24, 22,
+  19, 17, 15, 14, 12, 11, 10, 9, 8, 7, 6, 6,
+  5, 5, 4, 4, 3, 3, 3, 2, 2, 2, 2, 2,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0,
+};
+const GasCurve GAS_CURVE_MQ5 = {gasCurveMq5Ppm, 6656};
+
+// MQ135, NH3: ppm = 102.2 * (Rs/R0)^-2.473, Rs/R0 = 3.6 in clean air
+const uint16_t gasCurveMq135Ppm[GAS_CURVE_POINTS] PROGMEM = {
+  65535, 65535, 65535, 65535, 63260, 56833, 51059, 45872, 41211, 37024, 33263, 29884,
+  26848, 24120, 21669, 19468, 17490, 15713, 14117, 12683, 11394, 10237, 9197, 8262,
+  7423, 6669, 5991, 5383, 4836, 4344, 3903, 3506, 3150, 2830, 2543, 2284,
+  2052, 1844, 1656, 1488, 1337, 1201, 1079, 969, 871, 782, 703, 632,
+  567, 510, 458, 411, 370, 332, 298, 268, 241, 216, 194, 175,
+  157, 141, 127, 114, 102, 92, 82, 74, 67, 60, 54, 48,
+  43, 39, 35, 31, 28, 25, 23, 20, 18, 17, 15, 13,
+  12, 11, 10, 9, 8, 7, 6, 6, 5, 5, 4, 4,
+  3, 3, 3, 2, 2, 2, 2, 2, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0,
+};
+const GasCurve GAS_CURVE_MQ135 = {gasCurveMq135Ppm, 3686};
+// --- end of generated tables ---
+
+// Rs/RL (Q16) for an ADC reading. A reading of 0 (sensor open) saturates.
+inline uint32_t gasRsRl(uint16_t adc) {
+  if (adc == 0) {
+    return 0xFFFFFFFFUL;
+  }
+  if (adc >= GAS_ADC_MAX) {
+    return 0;
+  }
+  return ((uint32_t)(GAS_ADC_MAX - adc) << 16) / adc;
+}
+
+// a * 1024 / b in 32 bits; a / b must be below 2^22
+inline uint32_t gasQ10Div(uint32_t a, uint32_t b) {
+  uint32_t q = a / b, rem = a % b;
+  while (b >= (1UL << 22)) {  // keep rem << 10 in range, rem < b
+    rem >>= 1;
+    b >>= 1;
+  }
+  return (q << 10) + (rem << 10) / b;
+}
+
+// Set R0 from a reading taken in clean air
+inline void gasSensorBegin(GasSensor &s, uint16_t cleanAirAdc) {
+  s.r0 = gasQ10Div(gasRsRl(cleanAirAdc), s.curve->cleanAirRatio);
+  if (s.r0 == 0) {
+    s.r0 = 1;
+  }
+}
+
+// Rs/R0 (Q10) for an ADC reading, saturated to 16 bits
+inline uint16_t gasRatio(const GasSensor &s, uint16_t adc) {
+  uint32_t rs = gasRsRl(adc);
+  if (rs / s.r0 >= 64) {
+    return 0xFFFF;
+  }
+  return gasQ10Div(rs, s.r0);
+}
+
+// ppm for a ratio (Q10): binary search for the table entry below it, then
+// interpolate to the next one
+inline uint16_t gasCurvePpm(const GasCurve &curve, uint16_t ratio) {
+  uint8_t lo = 0, hi = GAS_CURVE_POINTS - 1;
+  if (ratio <= pgm_read_word(&gasRatioPoints[lo])) {
+    return pgm_read_word(&curve.ppm[lo]);
+  }
+  if (ratio >= pgm_read_word(&gasRatioPoints[hi])) {
+    return pgm_read_word(&curve.ppm[hi]);
+  }
+  while (hi - lo > 1) {
+    uint8_t mid = (lo + hi) / 2;
+    if (pgm_read_word(&gasRatioPoints[mid]) <= ratio) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  uint16_t r0 = pgm_read_word(&gasRatioPoints[lo]);
+  uint16_t span = pgm_read_word(&gasRatioPoints[hi]) - r0;
+  uint16_t p0 = pgm_read_word(&curve.ppm[lo]);
+  uint16_t p1 = pgm_read_word(&curve.ppm[hi]);
+  // Rs/R0 rises as the gas falls, so p1 <= p0
+  return p0 - ((uint32_t)(p0 - p1) * (ratio - r0) + span / 2) / span;
+}
+
+inline uint16_t gasSensorPpm(const GasSensor &s, uint16_t adc) {
+  return gasCurvePpm(*s.curve, gasRatio(s, adc));
+}
+
+#endif
@@ -0,0 +1,106 @@
+// Temperature/humidity compensation for the MQ gas readings
+//
+// An MQ sensor's resistance drifts with the air around it: on a hot, humid
+// day Rs falls and the sensor reads high, which is how summer false alarms
+// happen. The ppm curves (Gas_Calibration.h) hold at 20 °C / 65% RH, so
+// each gas has a table of correction factors over a temperature x humidity
+// grid, generated by tools/gas_curves.py from the datasheets' drift plots.
+//
+//   gasCompensateSample(sample);   // ppm fields corrected in place
+//
+// Between grid points the factor is interpolated bilinearly in integer
+// maths (a handful of multiplies and one divide); outside the grid the
+// nearest edge is used. Samples without GAS_FLAG_HAS_CLIMATE are left as
+// they are.
+
+#ifndef GAS_COMPENSATION_H
+#define GAS_COMPENSATION_H
+
+#include <stdint.h>
+#include "Gas_Link_Protocol.h"
+
+// --- generated by tools/gas_curves.py, do not edit ---
+#define GAS_CLIMATE_T_POINTS 7
+#define GAS_CLIMATE_T_FIRST -100    // 0.1 °C
+#define GAS_CLIMATE_T_STEP 100
+#define GAS_CLIMATE_RH_POINTS 5
+#define GAS_CLIMATE_RH_FIRST 200   // 0.1 %RH
+#define GAS_CLIMATE_RH_STEP 200
+
+// MQ7: ppm factor (Q10), rows 20..100 %RH, columns -10..50 °C
+const uint16_t gasClimateMq7[GAS_CLIMATE_RH_POINTS][GAS_CLIMATE_T_POINTS] PROGMEM = {
+  {1390, 1299, 1207, 1155, 1104, 1070, 1037},
+  {1320, 1231, 1147, 1096, 1046, 1013, 980},
+  {1251, 1164, 1088, 1038, 989, 957, 925},
+  {1184, 1099, 1031, 982, 933, 902, 870},
+  {1118, 1035, 974, 926, 879, 848, 817},
+};
+
+// MQ5: ppm factor (Q10), rows 20..100 %RH, columns -10..50 °C
+const uint16_t gasClimateMq5[GAS_CLIMATE_RH_POINTS][GAS_CLIMATE_T_POINTS] PROGMEM = {
+  {1963, 1713, 1450, 1283, 1152, 1057, 1001},
+  {1777, 1556, 1321, 1164, 1051, 971, 918},
+  {1602, 1408, 1199, 1051, 955, 890, 840},
+  {1438, 1269, 1084, 945, 865, 813, 766},
+  {1285, 1139, 976, 846, 781, 741, 696},
+};
+
+// MQ135: ppm factor (Q10), rows 20..100 %RH, columns -10..50 °C
+const uint16_t gasClimateMq135[GAS_CLIMATE_RH_POINTS][GAS_CLIMATE_T_POINTS] PROGMEM = {
+  {4645, 2906, 1832, 1248, 998, 920, 1018},
+  {4417, 2716, 1702, 1145, 899, 825, 927},
+  {4197, 2533, 1578, 1048, 805, 737, 841},
+  {3983, 2358, 1460, 955, 718, 654, 760},
+  {3775, 2191, 1347, 868, 637, 577, 684},
+};
+// --- end of generated tables ---
+
+// Grid cell and position within it for a reading, clamped to the grid
+inline uint8_t gasClimateCell(int16_t value, int16_t first, int16_t step, uint8_t points,
+                              uint16_t &frac) {
+  int32_t offset = (int32_t)value - first;
+  if (offset <= 0) {
+    frac = 0;
+    return 0;
+  }
+  uint8_t cell = offset / step;
+  if (cell >= points - 1) {
+    frac = step;
+    return points - 2;
+  }
+  frac = offset - cell * step;
+  return cell;
+}
+
+// Correction factor (Q10) at a temperature (0.1 °C) and humidity (0.1 %RH)
+inline uint16_t gasClimateFactor(const uint16_t table[][GAS_CLIMATE_T_POINTS],
+                                 int16_t temperature, int16_t humidity) {
+  uint16_t ft, fh;
+  uint8_t t = gasClimateCell(temperature, GAS_CLIMATE_T_FIRST, GAS_CLIMATE_T_STEP,
+                             GAS_CLIMATE_T_POINTS, ft);
+  uint8_t h = gasClimateCell(humidity, GAS_CLIMATE_RH_FIRST, GAS_CLIMATE_RH_STEP,
+                             GAS_CLIMATE_RH_POINTS, fh);
+  uint32_t low = (uint32_t)pgm_read_word(&table[h][t]) * (GAS_CLIMATE_T_STEP - ft)
+               + (uint32_t)pgm_read_word(&table[h][t + 1]) * ft;
+  uint32_t high = (uint32_t)pgm_read_word(&table[h + 1][t]) * (GAS_CLIMATE_T_STEP - ft)
+                + (uint32_t)pgm_read_word(&table[h + 1][t + 1]) * ft;
+  const uint32_t scale = (uint32_t)GAS_CLIMATE_T_STEP * GAS_CLIMATE_RH_STEP;
+  return (low * (GAS_CLIMATE_RH_STEP - fh) + high * fh + scale / 2) / scale;
+}
+
+inline uint16_t gasCompensatePpm(uint16_t ppm, uint16_t factor) {
+  uint32_t corrected = ((uint32_t)ppm * factor + 512) >> 10;
+  return corrected > 0xFFFF ? 0xFFFF : corrected;
+}
+
+// Correct a sample's ppm readings for its temperature and humidity
+inline void gasCompensateSample(GasSample &s) {
+  if (!(s.flags & GAS_FLAG_HAS_CLIMATE)) {
+    return;
+  }
+  s.mq7Ppm = gasCompensatePpm(s.mq7Ppm, gasClimateFactor(gasClimateMq7, s.temperature, s.humidity));
+  s.mq5Ppm = gasCompensatePpm(s.mq5Ppm, gasClimateFactor(gasClimateMq5, s.temperature, s.humidity));
+  s.mq135Ppm = gasCompensatePpm(s.mq135Ppm, gasClimateFactor(gasClimateMq135, s.temperature, s.humidity));
+}
+
+#endif
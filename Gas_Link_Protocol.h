@@ -0,0 +1,388 @@
+// Binary UART frame shared by the gas Transmitter/Receiver sketches
+// (Transmitter.cpp <-> Receiver.cpp and SS_25_T.cpp <-> SS_25_R.cpp)
+//
+// Frame layout (multi-byte fields are little-endian):
+//   [0]     SYNC      0xA5
+//   [1]     VER/TYPE  high nibble = protocol version, low nibble = frame type
+//   [2]     LEN       payload length in bytes
+//   [3]     NODE      sender's node ID (several transmitters may share a bus)
+//   [4..5]  SEQ       sample frames: incremented per sample (used for loss
+//                     counting); replies echo the request's SEQ
+//   [6..]   PAYLOAD   LEN bytes
+//   [last2] CRC       CRC-16/CCITT-FALSE over VER/TYPE .. end of payload
+//
+// Sample payload (21 bytes):
+//   uint32 acquisition time (sender's millis())
+//   int16  temperature (0.1 °C)      int16 humidity (0.1 %RH)
+//   4 x 12-bit ADC counts packed in 6 bytes: MQ7, MQ5, MQ135, O2 raw
+//   uint8  flags (which optional fields are valid)
+//   3 x uint16 gas concentration (ppm): MQ7, MQ5, MQ135, converted by the
+//          sender, which knows its ADC range and sensor calibration
+//          (Gas_Calibration.h); not yet corrected for temperature and
+//          humidity (Gas_Compensation.h)
+//
+// A full sample frame is 29 bytes on the wire instead of ~73 ASCII characters.
+//
+// Clock-offset handshake (NTP style), addressed by NODE:
+//   TIME_REQ  receiver -> node: uint32 t0 = receiver millis() when sent
+//   TIME_RESP node -> receiver: t0 echoed, t1 = node millis() when the
+//             request arrived, t2 = node millis() when the reply was sent
+//   With t3 = receiver millis() on arrival:
+//     offset (node - receiver) = ((t1 - t0) + (t2 - t3)) / 2
+//     round trip               = (t3 - t0) - (t2 - t1)
+//
+// Store-and-forward (transmitters with a backlog):
+//   ACK   receiver -> node: uint8 type of the frame acknowledged, header
+//         SEQ = that frame's SEQ. Sent for every SAMPLE and BATCH frame.
+//   BATCH node -> receiver: up to GAS_BATCH_MAX_RECORDS records of
+//         uint16 original sample SEQ + sample payload, oldest first.
+//         Header SEQ is the sender's batch counter.
+//
+// On a shared bus (e.g. RS-485 transceivers) transmitters are not
+// arbitrated; a collision just shows up as a CRC error on the receiver.
+//
+// GasLinkReader reassembles frames from a byte stream without blocking or
+// allocating: push whatever the UART has buffered, then pull complete frames.
+
+#ifndef GAS_LINK_PROTOCOL_H
+#define GAS_LINK_PROTOCOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define GAS_LINK_SYNC         0xA5
+#define GAS_LINK_VERSION      4
+#define GAS_LINK_HEADER_LEN   6
+#define GAS_LINK_CRC_LEN      2
+// Large enough for a BATCH frame. Sketches that never receive batches may
+// define a smaller one before including this header to save RAM.
+#ifndef GAS_LINK_MAX_PAYLOAD
+#define GAS_LINK_MAX_PAYLOAD  128
+#endif
+#define GAS_LINK_MAX_FRAME    (GAS_LINK_HEADER_LEN + GAS_LINK_MAX_PAYLOAD + GAS_LINK_CRC_LEN)
+
+// Receive ring size, must be a power of two and hold at least one
+// GAS_LINK_MAX_FRAME. Sketches on small boards may define a smaller one
+// before including this header.
+#ifndef GAS_LINK_RX_RING
+#define GAS_LINK_RX_RING      256
+#endif
+
+// Frame types
+#define GAS_LINK_TYPE_SAMPLE     1
+#define GAS_LINK_TYPE_TIME_REQ   2
+#define GAS_LINK_TYPE_TIME_RESP  3
+#define GAS_LINK_TYPE_ACK        4
+#define GAS_LINK_TYPE_BATCH      5
+
+// Sample flags
+#define GAS_FLAG_HAS_CLIMATE  0x01  // temperature/humidity are valid
+#define GAS_FLAG_HAS_O2       0x02  // O2 raw reading is valid
+#define GAS_FLAG_WARMING      0x04  // MQ sensors still warming up, gas readings unreliable
+
+#define GAS_SAMPLE_PAYLOAD_LEN     21
+#define GAS_TIME_REQ_PAYLOAD_LEN   4
+#define GAS_TIME_RESP_PAYLOAD_LEN  12
+#define GAS_ACK_PAYLOAD_LEN        1
+#define GAS_RECORD_LEN             (2 + GAS_SAMPLE_PAYLOAD_LEN)
+#define GAS_BATCH_MAX_RECORDS      (GAS_LINK_MAX_PAYLOAD / GAS_RECORD_LEN)
+
+struct GasSample {
+  uint32_t timestamp;    // acquisition time, sender's millis()
+  int16_t temperature;   // 0.1 °C
+  int16_t humidity;      // 0.1 %RH
+  uint16_t mq7;          // raw ADC counts (12 bits max)
+  uint16_t mq5;
+  uint16_t mq135;
+  uint16_t o2raw;
+  uint8_t flags;
+  uint16_t mq7Ppm;       // CO
+  uint16_t mq5Ppm;       // CH4
+  uint16_t mq135Ppm;     // NH3 equivalent
+};
+
+// A sample together with the SEQ it was (or would have been) sent with
+struct GasLinkRecord {
+  uint16_t seq;
+  GasSample sample;
+};
+
+struct GasTimeSync {
+  uint32_t t0;  // receiver, request sent
+  uint32_t t1;  // node, request received
+  uint32_t t2;  // node, reply sent
+};
+
+// View of a received frame; payload points into the caller's buffer
+struct GasLinkFrame {
+  uint8_t version;
+  uint8_t type;
+  uint8_t length;
+  uint8_t node;
+  uint16_t seq;
+  const uint8_t *payload;
+};
+
+// CRC-16/CCITT-FALSE (poly 0x1021), byte-wise without a lookup table.
+// Pass the previous result as crc to continue over several chunks.
+inline uint16_t gasLinkCrc16(const uint8_t *data, size_t len, uint16_t crc = 0xFFFF) {
+  for (size_t i = 0; i < len; i++) {
+    uint8_t x = (crc >> 8) ^ data[i];
+    x ^= x >> 4;
+    crc = (crc << 8) ^ ((uint16_t)x << 12) ^ ((uint16_t)x << 5) ^ x;
+  }
+  return crc;
+}
+
+inline void gasLinkPut16(uint8_t *p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+inline uint16_t gasLinkGet16(const uint8_t *p) {
+  return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+}
+
+inline void gasLinkPut32(uint8_t *p, uint32_t v) {
+  gasLinkPut16(p, v & 0xFFFF);
+  gasLinkPut16(p + 2, v >> 16);
+}
+
+inline uint32_t gasLinkGet32(const uint8_t *p) {
+  return (uint32_t)gasLinkGet16(p) | ((uint32_t)gasLinkGet16(p + 2) << 16);
+}
+
+// Wrap a payload already written at buf[GAS_LINK_HEADER_LEN] into a frame.
+// Returns the total frame length.
+inline size_t gasLinkFinishFrame(uint8_t *buf, uint8_t type, uint8_t node, uint16_t seq,
+                                 uint8_t payloadLen) {
+  buf[0] = GAS_LINK_SYNC;
+  buf[1] = (GAS_LINK_VERSION << 4) | (type & 0x0F);
+  buf[2] = payloadLen;
+  buf[3] = node;
+  gasLinkPut16(buf + 4, seq);
+  size_t end = GAS_LINK_HEADER_LEN + payloadLen;
+  gasLinkPut16(buf + end, gasLinkCrc16(buf + 1, end - 1));
+  return end + GAS_LINK_CRC_LEN;
+}
+
+// Write the GAS_SAMPLE_PAYLOAD_LEN byte sample payload at p
+inline void gasLinkPackSample(uint8_t *p, const GasSample &s) {
+  gasLinkPut32(p, s.timestamp);
+  p += 4;
+  gasLinkPut16(p, (uint16_t)s.temperature);
+  gasLinkPut16(p + 2, (uint16_t)s.humidity);
+  // Two 12-bit readings per 3 bytes
+  p[4] = s.mq7 & 0xFF;
+  p[5] = ((s.mq7 >> 8) & 0x0F) | ((s.mq5 & 0x0F) << 4);
+  p[6] = (s.mq5 >> 4) & 0xFF;
+  p[7] = s.mq135 & 0xFF;
+  p[8] = ((s.mq135 >> 8) & 0x0F) | ((s.o2raw & 0x0F) << 4);
+  p[9] = (s.o2raw >> 4) & 0xFF;
+  p[10] = s.flags;
+  gasLinkPut16(p + 11, s.mq7Ppm);
+  gasLinkPut16(p + 13, s.mq5Ppm);
+  gasLinkPut16(p + 15, s.mq135Ppm);
+}
+
+inline void gasLinkUnpackSample(const uint8_t *p, GasSample &s) {
+  s.timestamp = gasLinkGet32(p);
+  p += 4;
+  s.temperature = (int16_t)gasLinkGet16(p);
+  s.humidity = (int16_t)gasLinkGet16(p + 2);
+  s.mq7 = p[4] | ((uint16_t)(p[5] & 0x0F) << 8);
+  s.mq5 = (p[5] >> 4) | ((uint16_t)p[6] << 4);
+  s.mq135 = p[7] | ((uint16_t)(p[8] & 0x0F) << 8);
+  s.o2raw = (p[8] >> 4) | ((uint16_t)p[9] << 4);
+  s.flags = p[10];
+  s.mq7Ppm = gasLinkGet16(p + 11);
+  s.mq5Ppm = gasLinkGet16(p + 13);
+  s.mq135Ppm = gasLinkGet16(p + 15);
+}
+
+// Records use the same layout in BATCH frames and in the flash sample log
+inline void gasLinkPackRecord(uint8_t *p, const GasLinkRecord &r) {
+  gasLinkPut16(p, r.seq);
+  gasLinkPackSample(p + 2, r.sample);
+}
+
+inline void gasLinkUnpackRecord(const uint8_t *p, GasLinkRecord &r) {
+  r.seq = gasLinkGet16(p);
+  gasLinkUnpackSample(p + 2, r.sample);
+}
+
+// Encode a sample frame into buf (at least GAS_LINK_MAX_FRAME bytes).
+// Returns the number of bytes to send.
+inline size_t gasLinkEncodeSample(uint8_t *buf, uint8_t node, uint16_t seq, const GasSample &s) {
+  gasLinkPackSample(buf + GAS_LINK_HEADER_LEN, s);
+  return gasLinkFinishFrame(buf, GAS_LINK_TYPE_SAMPLE, node, seq, GAS_SAMPLE_PAYLOAD_LEN);
+}
+
+// Validate a complete frame (sync, version, length and CRC) and fill in the view.
+inline bool gasLinkParseFrame(const uint8_t *buf, size_t len, GasLinkFrame &frame) {
+  if (len < GAS_LINK_HEADER_LEN + GAS_LINK_CRC_LEN || buf[0] != GAS_LINK_SYNC) {
+    return false;
+  }
+  uint8_t payloadLen = buf[2];
+  size_t end = GAS_LINK_HEADER_LEN + payloadLen;
+  if (payloadLen > GAS_LINK_MAX_PAYLOAD || len != end + GAS_LINK_CRC_LEN) {
+    return false;
+  }
+  if (gasLinkGet16(buf + end) != gasLinkCrc16(buf + 1, end - 1)) {
+    return false;
+  }
+  frame.version = buf[1] >> 4;
+  frame.type = buf[1] & 0x0F;
+  frame.length = payloadLen;
+  frame.node = buf[3];
+  frame.seq = gasLinkGet16(buf + 4);
+  frame.payload = buf + GAS_LINK_HEADER_LEN;
+  return frame.version == GAS_LINK_VERSION;
+}
+
+inline bool gasLinkDecodeSample(const GasLinkFrame &frame, GasSample &s) {
+  if (frame.type != GAS_LINK_TYPE_SAMPLE || frame.length != GAS_SAMPLE_PAYLOAD_LEN) {
+    return false;
+  }
+  gasLinkUnpackSample(frame.payload, s);
+  return true;
+}
+
+inline size_t gasLinkEncodeTimeRequest(uint8_t *buf, uint8_t node, uint16_t seq, uint32_t t0) {
+  gasLinkPut32(buf + GAS_LINK_HEADER_LEN, t0);
+  return gasLinkFinishFrame(buf, GAS_LINK_TYPE_TIME_REQ, node, seq, GAS_TIME_REQ_PAYLOAD_LEN);
+}
+
+inline bool gasLinkDecodeTimeRequest(const GasLinkFrame &frame, uint32_t &t0) {
+  if (frame.type != GAS_LINK_TYPE_TIME_REQ || frame.length != GAS_TIME_REQ_PAYLOAD_LEN) {
+    return false;
+  }
+  t0 = gasLinkGet32(frame.payload);
+  return true;
+}
+
+inline size_t gasLinkEncodeTimeResponse(uint8_t *buf, uint8_t node, uint16_t seq, const GasTimeSync &t) {
+  uint8_t *p = buf + GAS_LINK_HEADER_LEN;
+  gasLinkPut32(p, t.t0);
+  gasLinkPut32(p + 4, t.t1);
+  gasLinkPut32(p + 8, t.t2);
+  return gasLinkFinishFrame(buf, GAS_LINK_TYPE_TIME_RESP, node, seq, GAS_TIME_RESP_PAYLOAD_LEN);
+}
+
+inline bool gasLinkDecodeTimeResponse(const GasLinkFrame &frame, GasTimeSync &t) {
+  if (frame.type != GAS_LINK_TYPE_TIME_RESP || frame.length != GAS_TIME_RESP_PAYLOAD_LEN) {
+    return false;
+  }
+  t.t0 = gasLinkGet32(frame.payload);
+  t.t1 = gasLinkGet32(frame.payload + 4);
+  t.t2 = gasLinkGet32(frame.payload + 8);
+  return true;
+}
+
+inline size_t gasLinkEncodeAck(uint8_t *buf, uint8_t node, uint16_t seq, uint8_t ackedType) {
+  buf[GAS_LINK_HEADER_LEN] = ackedType;
+  return gasLinkFinishFrame(buf, GAS_LINK_TYPE_ACK, node, seq, GAS_ACK_PAYLOAD_LEN);
+}
+
+inline bool gasLinkDecodeAck(const GasLinkFrame &frame, uint8_t &ackedType) {
+  if (frame.type != GAS_LINK_TYPE_ACK || frame.length != GAS_ACK_PAYLOAD_LEN) {
+    return false;
+  }
+  ackedType = frame.payload[0];
+  return true;
+}
+
+// count must be 1..GAS_BATCH_MAX_RECORDS
+inline size_t gasLinkEncodeBatch(uint8_t *buf, uint8_t node, uint16_t seq,
+                                 const GasLinkRecord *records, uint8_t count) {
+  for (uint8_t i = 0; i < count; i++) {
+    gasLinkPackRecord(buf + GAS_LINK_HEADER_LEN + i * GAS_RECORD_LEN, records[i]);
+  }
+  return gasLinkFinishFrame(buf, GAS_LINK_TYPE_BATCH, node, seq, count * GAS_RECORD_LEN);
+}
+
+// Returns the number of records unpacked into out (0 if not a valid batch)
+inline uint8_t gasLinkDecodeBatch(const GasLinkFrame &frame, GasLinkRecord *out, uint8_t maxRecords) {
+  if (frame.type != GAS_LINK_TYPE_BATCH || frame.length == 0 || frame.length % GAS_RECORD_LEN != 0) {
+    return 0;
+  }
+  uint8_t count = frame.length / GAS_RECORD_LEN;
+  if (count > maxRecords) {
+    return 0;
+  }
+  for (uint8_t i = 0; i < count; i++) {
+    gasLinkUnpackRecord(frame.payload + i * GAS_RECORD_LEN, out[i]);
+  }
+  return count;
+}
+
+// --- Incremental frame reassembly ---
+
+struct GasLinkReader {
+  uint8_t ring[GAS_LINK_RX_RING];
+  uint16_t head;                  // free-running write index
+  uint16_t tail;                  // free-running read index
+  uint8_t frame[GAS_LINK_MAX_FRAME];  // linear copy of the frame being checked
+  uint32_t frames;                // valid frames delivered
+  uint32_t overflows;             // bytes dropped because the ring was full
+  uint32_t resyncs;               // garbage bytes skipped while hunting for sync
+  uint32_t crcErrors;             // candidate frames rejected by the CRC
+};
+
+inline uint16_t gasLinkReaderCount(const GasLinkReader &r) {
+  return (uint16_t)(r.head - r.tail);
+}
+
+inline uint8_t gasLinkReaderPeek(const GasLinkReader &r, uint16_t offset) {
+  return r.ring[(uint16_t)(r.tail + offset) & (GAS_LINK_RX_RING - 1)];
+}
+
+// Queue one received byte. Returns false (and counts an overflow) when full.
+inline bool gasLinkReaderPush(GasLinkReader &r, uint8_t b) {
+  if (gasLinkReaderCount(r) >= GAS_LINK_RX_RING) {
+    r.overflows++;
+    return false;
+  }
+  r.ring[r.head & (GAS_LINK_RX_RING - 1)] = b;
+  r.head++;
+  return true;
+}
+
+// Pull the next complete, CRC-checked frame out of the ring. The returned
+// view points into r.frame and stays valid until the next call.
+inline bool gasLinkReaderNext(GasLinkReader &r, GasLinkFrame &frame) {
+  while (gasLinkReaderCount(r) > 0) {
+    if (gasLinkReaderPeek(r, 0) != GAS_LINK_SYNC) {
+      r.tail++;
+      r.resyncs++;
+      continue;
+    }
+    if (gasLinkReaderCount(r) < GAS_LINK_HEADER_LEN) {
+      return false;  // wait for the rest of the header
+    }
+    uint8_t payloadLen = gasLinkReaderPeek(r, 2);
+    if ((gasLinkReaderPeek(r, 1) >> 4) != GAS_LINK_VERSION || payloadLen > GAS_LINK_MAX_PAYLOAD) {
+      r.tail++;  // not a real header, keep hunting
+      r.resyncs++;
+      continue;
+    }
+    uint16_t frameLen = GAS_LINK_HEADER_LEN + payloadLen + GAS_LINK_CRC_LEN;
+    if (gasLinkReaderCount(r) < frameLen) {
+      return false;  // wait for payload + CRC
+    }
+    for (uint16_t i = 0; i < frameLen; i++) {
+      r.frame[i] = gasLinkReaderPeek(r, i);
+    }
+    if (gasLinkParseFrame(r.frame, frameLen, frame)) {
+      r.tail += frameLen;
+      r.frames++;
+      return true;
+    }
+    // Bad CRC: the sync byte was probably data, rescan from the next byte
+    r.crcErrors++;
+    r.tail++;
+  }
+  return false;
+}
+
+#endif
@@ -0,0 +1,134 @@
+// Send-on-delta reporting for the gas transmitters: sample fast, but only
+// put a frame on the link when it tells the receiver something new
+//
+//   ReportPolicy policy;                          // zero-initialised
+//   per reading:
+//     uint8_t reason = reportCheck(policy, sample, now);
+//     if (reason != REPORT_NONE) { send; reportSent(policy, sample, now, reason); }
+//
+// A sample is sent
+//   - at once when a gas rises above one of its band edges (e.g. the
+//     receivers' alarm thresholds) or the flags change (climate/O2 data,
+//     warming);
+//   - when a gas falls back below an edge, or a channel has moved by at
+//     least its delta since the last frame (and 1/2^REPORT_DELTA_SHIFT of
+//     its value, so small noise on a high reading doesn't count), but at
+//     most every REPORT_MIN_INTERVAL_MS, so noise on an edge can't flood
+//     the link;
+//   - otherwise as a heartbeat every REPORT_HEARTBEAT_MS, so the receiver
+//     still knows the node is alive.
+// Gases are compared in ppm as the receiver will see them: corrected for
+// the sample's temperature and humidity (Gas_Compensation.h) when it has
+// them, since that is the value the receiver alarms on. O2 is compared in
+// raw counts. Sketches may define any of the settings below before
+// including this header.
+
+#ifndef GAS_REPORT_POLICY_H
+#define GAS_REPORT_POLICY_H
+
+#include "Gas_Link_Protocol.h"
+#include "Gas_Compensation.h"
+
+#ifndef REPORT_HEARTBEAT_MS
+#define REPORT_HEARTBEAT_MS 5000
+#endif
+#ifndef REPORT_MIN_INTERVAL_MS
+#define REPORT_MIN_INTERVAL_MS 200     // delta frames, at most 5 per second
+#endif
+#ifndef REPORT_DELTA_SHIFT
+#define REPORT_DELTA_SHIFT 3           // and at least 1/8 of the last value
+#endif
+#ifndef REPORT_DELTA_MQ7
+#define REPORT_DELTA_MQ7 5             // ppm CO
+#endif
+#ifndef REPORT_DELTA_MQ5
+#define REPORT_DELTA_MQ5 100           // ppm CH4
+#endif
+#ifndef REPORT_DELTA_MQ135
+#define REPORT_DELTA_MQ135 3           // ppm NH3
+#endif
+#ifndef REPORT_DELTA_O2
+#define REPORT_DELTA_O2 20             // raw counts, ~0.5% O2
+#endif
+#ifndef REPORT_BANDS_MQ7
+#define REPORT_BANDS_MQ7 25, 50, 100, 200, 400
+#endif
+#ifndef REPORT_BANDS_MQ5
+#define REPORT_BANDS_MQ5 500, 1000, 5000
+#endif
+#ifndef REPORT_BANDS_MQ135
+#define REPORT_BANDS_MQ135 10, 25, 50, 100
+#endif
+
+// Why a sample was sent
+enum ReportReason { REPORT_NONE, REPORT_HEARTBEAT, REPORT_DELTA, REPORT_CROSSING, REPORT_REASONS };
+
+const uint16_t reportBandsMq7[] = {REPORT_BANDS_MQ7};
+const uint16_t reportBandsMq5[] = {REPORT_BANDS_MQ5};
+const uint16_t reportBandsMq135[] = {REPORT_BANDS_MQ135};
+
+struct ReportPolicy {
+  GasSample last;                     // what the receiver has now (compensated)
+  unsigned long lastSentAt;
+  bool sentOnce;
+  uint32_t sent[REPORT_REASONS];      // frames per reason
+};
+
+// Number of band edges below a value (the receivers alarm above a threshold)
+template <uint8_t N> inline uint8_t reportBand(uint16_t value, const uint16_t (&edges)[N]) {
+  uint8_t band = 0;
+  while (band < N && value > edges[band]) {
+    band++;
+  }
+  return band;
+}
+
+inline bool reportMoved(uint16_t value, uint16_t last, uint16_t delta) {
+  uint16_t diff = value > last ? value - last : last - value;
+  uint16_t relative = last >> REPORT_DELTA_SHIFT;
+  return diff >= delta && diff >= relative;
+}
+
+// -1, 0 or 1 as a value has fallen, stayed or risen across band edges
+template <uint8_t N> inline int8_t reportCrossed(uint16_t value, uint16_t last,
+                                                 const uint16_t (&edges)[N]) {
+  uint8_t now = reportBand(value, edges), before = reportBand(last, edges);
+  return now > before ? 1 : now < before ? -1 : 0;
+}
+
+// A sample as the receiver will judge it
+inline GasSample reportView(const GasSample &sample) {
+  GasSample s = sample;
+  gasCompensateSample(s);
+  return s;
+}
+
+// Whether (and why) this sample should be sent now
+inline uint8_t reportCheck(const ReportPolicy &p, const GasSample &sample, unsigned long now) {
+  GasSample s = reportView(sample);
+  int8_t mq7 = reportCrossed(s.mq7Ppm, p.last.mq7Ppm, reportBandsMq7);
+  int8_t mq5 = reportCrossed(s.mq5Ppm, p.last.mq5Ppm, reportBandsMq5);
+  int8_t mq135 = reportCrossed(s.mq135Ppm, p.last.mq135Ppm, reportBandsMq135);
+  if (!p.sentOnce || s.flags != p.last.flags || mq7 > 0 || mq5 > 0 || mq135 > 0) {
+    return REPORT_CROSSING;
+  }
+  unsigned long since = now - p.lastSentAt;
+  if (since >= REPORT_MIN_INTERVAL_MS &&
+      (mq7 < 0 || mq5 < 0 || mq135 < 0 ||
+       reportMoved(s.mq7Ppm, p.last.mq7Ppm, REPORT_DELTA_MQ7) ||
+       reportMoved(s.mq5Ppm, p.last.mq5Ppm, REPORT_DELTA_MQ5) ||
+       reportMoved(s.mq135Ppm, p.last.mq135Ppm, REPORT_DELTA_MQ135) ||
+       ((s.flags & GAS_FLAG_HAS_O2) && reportMoved(s.o2raw, p.last.o2raw, REPORT_DELTA_O2)))) {
+    return REPORT_DELTA;
+  }
+  return since >= REPORT_HEARTBEAT_MS ? REPORT_HEARTBEAT : REPORT_NONE;
+}
+
+inline void reportSent(ReportPolicy &p, const GasSample &s, unsigned long now, uint8_t reason) {
+  p.last = reportView(s);
+  p.lastSentAt = now;
+  p.sentOnce = true;
+  p.sent[reason]++;
+}
+
+#endif
@@ -0,0 +1,121 @@
+// Rate-of-rise detector for one gas channel: an early warning for a fast
+// leak, before the concentration has climbed to the alarm threshold
+//
+//   GasRiseDetector d;
+//   riseReset(d);
+//   per sample:  if (riseUpdate(d, limit, timestampMs, ppm)) -> pre-alarm
+//
+// Each reading first goes through a median of the last three, so a single
+// bad frame can't fake a rise. The filtered values and their timestamps go
+// into a ring of the last RISE_WINDOW samples, and the slope is the
+// least-squares fit over the ring. Its sums are kept up to date in O(1)
+// per sample: the new point is added and the evicted one subtracted.
+// Times are relative to the newest sample, so each update also shifts the
+// sums along by the time that passed (again O(1)). That keeps them small
+// and exact in 64-bit integers, with no drift however long it runs.
+//
+// The pre-alarm comes on when the slope reaches limit.ppmPerMinute with the
+// level at least limit.minPpm, and goes off again below half that slope.
+// A gap longer than RISE_MAX_GAP_MS, or time going backwards (the
+// transmitter restarted), starts the window again.
+
+#ifndef GAS_RISE_DETECTOR_H
+#define GAS_RISE_DETECTOR_H
+
+#include <stdint.h>
+
+#ifndef RISE_WINDOW
+#define RISE_WINDOW 8             // samples in the fit (~35 s of heartbeats, less while gas moves)
+#endif
+#define RISE_MAX_GAP_MS 30000
+
+struct GasRiseLimit {
+  uint16_t ppmPerMinute;    // pre-alarm slope
+  uint16_t minPpm;          // ... only at or above this level
+};
+
+struct GasRiseDetector {
+  uint16_t raw[3];          // last readings, for the median
+  uint8_t rawCount;
+  uint32_t time[RISE_WINDOW];
+  uint16_t value[RISE_WINDOW];
+  uint8_t oldest;
+  uint8_t count;
+  int64_t sumT, sumY, sumTT, sumTY;   // t in ms relative to the newest sample
+  int32_t slope;            // ppm per minute, once the window is full
+  bool rising;
+};
+
+inline void riseReset(GasRiseDetector &d) {
+  d.rawCount = 0;
+  d.oldest = 0;
+  d.count = 0;
+  d.sumT = d.sumY = d.sumTT = d.sumTY = 0;
+  d.slope = 0;
+  d.rising = false;
+}
+
+inline uint16_t riseMedian(GasRiseDetector &d, uint16_t ppm) {
+  d.raw[0] = d.raw[1];
+  d.raw[1] = d.raw[2];
+  d.raw[2] = ppm;
+  if (d.rawCount < 3) {
+    d.rawCount++;
+    return ppm;
+  }
+  uint16_t a = d.raw[0], b = d.raw[1], c = d.raw[2];
+  if (a > b) { uint16_t t = a; a = b; b = t; }
+  return c < a ? a : c > b ? b : c;
+}
+
+// Add one sample to the fit (timestampMs from the sender's clock)
+inline void riseAdd(GasRiseDetector &d, uint32_t timestampMs, uint16_t ppm) {
+  if (d.count > 0) {
+    uint8_t newest = (d.oldest + d.count - 1) % RISE_WINDOW;
+    int32_t dt = (int32_t)(timestampMs - d.time[newest]);
+    if (dt <= 0 || dt > RISE_MAX_GAP_MS) {
+      riseReset(d);
+    } else {
+      // Every stored t moves back by dt
+      d.sumTT += -2 * dt * d.sumT + (int64_t)d.count * dt * dt;
+      d.sumTY -= dt * d.sumY;
+      d.sumT -= (int64_t)d.count * dt;
+    }
+  }
+  uint16_t y = riseMedian(d, ppm);
+  if (d.count == RISE_WINDOW) {
+    int64_t t = -(int32_t)(timestampMs - d.time[d.oldest]);
+    d.sumT -= t;
+    d.sumY -= d.value[d.oldest];
+    d.sumTT -= t * t;
+    d.sumTY -= t * d.value[d.oldest];
+    d.oldest = (d.oldest + 1) % RISE_WINDOW;
+    d.count--;
+  }
+  uint8_t slot = (d.oldest + d.count) % RISE_WINDOW;
+  d.time[slot] = timestampMs;
+  d.value[slot] = y;
+  d.count++;
+  d.sumY += y;              // t = 0 adds nothing to the other sums
+
+  d.slope = 0;
+  int64_t den = d.count * d.sumTT - d.sumT * d.sumT;
+  if (d.count == RISE_WINDOW && den > 0) {
+    d.slope = (int32_t)((d.count * d.sumTY - d.sumT * d.sumY) * 60000 / den);
+  }
+}
+
+// Add a sample and update the pre-alarm; returns whether it is on
+inline bool riseUpdate(GasRiseDetector &d, const GasRiseLimit &limit, uint32_t timestampMs,
+                       uint16_t ppm) {
+  riseAdd(d, timestampMs, ppm);
+  uint16_t level = d.value[(d.oldest + d.count - 1) % RISE_WINDOW];
+  if (d.rising) {
+    d.rising = d.slope >= limit.ppmPerMinute / 2;
+  } else {
+    d.rising = d.slope >= limit.ppmPerMinute && level >= limit.minPpm;
+  }
+  return d.rising;
+}
+
+#endif
@@ -0,0 +1,261 @@
+// Flash-backed circular sample log for store-and-forward (ESP32 + LittleFS)
+//
+// Samples the receiver did not acknowledge are appended here while the link
+// is down and drained oldest-first once it is back.
+//
+// Layout:
+//   - New records collect in one RAM page (SAMPLE_LOG_PAGE_BYTES).
+//   - A full page is written to flash as its own file in a single write
+//     the size of one LittleFS block, so it is never rewritten in place.
+//   - Drained pages are deleted. LittleFS's allocator then reuses blocks
+//     evenly (wear levelling), and there is no cursor file to rewrite on
+//     every drain.
+//   - At most SAMPLE_LOG_MAX_PAGES page files are kept. When the log is
+//     full, the oldest page is dropped.
+//
+// Page: uint32 magic | uint16 record count | uint16 CRC-16 of the records |
+//       count x GAS_RECORD_LEN records (see Gas_Link_Protocol.h)
+//
+// RAM use is one page buffer plus a few counters. The records still in the
+// RAM page are lost on a reset; only full pages survive power loss. The
+// drain position isn't persisted either, so after a reset a partly drained
+// page is replayed from its start (the receiver sees a few repeats).
+
+#ifndef GAS_SAMPLE_LOG_H
+#define GAS_SAMPLE_LOG_H
+
+#include <FS.h>
+#include <LittleFS.h>
+#include "Gas_Link_Protocol.h"
+
+#define SAMPLE_LOG_DIR           "/samplelog"
+#define SAMPLE_LOG_PAGE_BYTES    4096   // = LittleFS block size on ESP32
+#define SAMPLE_LOG_HEADER_BYTES  8
+#define SAMPLE_LOG_PAGE_RECORDS  ((SAMPLE_LOG_PAGE_BYTES - SAMPLE_LOG_HEADER_BYTES) / GAS_RECORD_LEN)
+#define SAMPLE_LOG_MAX_PAGES     32     // 128 KB of flash, ~7.9 h of 5 s heartbeats
+#define SAMPLE_LOG_MAGIC         0x4C534732UL  // "2GSL", bumped with the record layout
+
+struct SampleLog {
+  bool mounted;
+  uint32_t firstPage;     // oldest page file still on flash
+  uint32_t nextPage;      // number the next full page will be written as
+  uint16_t firstCount;    // records in the oldest page, 0 = not checked yet
+  uint16_t drainOffset;   // records of the oldest page already drained
+  uint8_t ram[SAMPLE_LOG_PAGE_BYTES];
+  uint16_t ramStart, ramCount;  // undrained records are ram[ramStart..ramCount)
+  uint32_t stored;        // records in the log (flash + RAM)
+  uint8_t peeked;         // records handed out by the last peek, not yet consumed
+  uint32_t pagesWritten, dropped, corruptPages;
+};
+
+SampleLog sampleLog;
+
+inline void sampleLogPagePath(char *path, uint32_t page) {
+  snprintf(path, 32, SAMPLE_LOG_DIR "/%08lu", (unsigned long)page);
+}
+
+inline uint8_t *sampleLogRamRecord(uint16_t i) {
+  return sampleLog.ram + SAMPLE_LOG_HEADER_BYTES + i * GAS_RECORD_LEN;
+}
+
+// Read a page header (and optionally check the CRC of its records).
+// Returns the record count, or 0 if the page is missing or unusable.
+uint16_t sampleLogCheckPage(uint32_t page, bool verifyCrc) {
+  char path[32];
+  sampleLogPagePath(path, page);
+  File f = LittleFS.open(path, "r");
+  if (!f) {
+    return 0;
+  }
+  uint8_t header[SAMPLE_LOG_HEADER_BYTES];
+  uint16_t count = 0;
+  if (f.read(header, sizeof(header)) == sizeof(header) && gasLinkGet32(header) == SAMPLE_LOG_MAGIC) {
+    count = gasLinkGet16(header + 4);
+  }
+  if (count > SAMPLE_LOG_PAGE_RECORDS) {
+    count = 0;
+  }
+  if (verifyCrc && count > 0) {
+    // Stream the records through the CRC one at a time
+    uint16_t crc = 0xFFFF;
+    uint8_t record[GAS_RECORD_LEN];
+    for (uint16_t i = 0; i < count; i++) {
+      if (f.read(record, GAS_RECORD_LEN) != GAS_RECORD_LEN) {
+        crc = ~gasLinkGet16(header + 6);  // truncated
+        break;
+      }
+      crc = gasLinkCrc16(record, GAS_RECORD_LEN, crc);
+    }
+    if (crc != gasLinkGet16(header + 6)) {
+      count = 0;
+    }
+  }
+  f.close();
+  return count;
+}
+
+// Mount LittleFS (formatting it if needed) and pick up pages left by a previous run
+bool sampleLogBegin() {
+  sampleLog.mounted = LittleFS.begin(true);
+  if (!sampleLog.mounted) {
+    return false;
+  }
+  LittleFS.mkdir(SAMPLE_LOG_DIR);
+  File dir = LittleFS.open(SAMPLE_LOG_DIR);
+  bool any = false;
+  for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+    uint32_t page = strtoul(f.name(), NULL, 10);
+    if (!any || page < sampleLog.firstPage) sampleLog.firstPage = page;
+    if (!any || page >= sampleLog.nextPage) sampleLog.nextPage = page + 1;
+    any = true;
+  }
+  // Verify every page once here (power may have been lost mid-write), so
+  // draining later only needs the headers
+  for (uint32_t page = sampleLog.firstPage; page < sampleLog.nextPage; page++) {
+    uint16_t count = sampleLogCheckPage(page, true);
+    if (count == 0) {
+      char path[32];
+      sampleLogPagePath(path, page);
+      LittleFS.remove(path);
+      sampleLog.corruptPages++;
+    }
+    sampleLog.stored += count;
+  }
+  return true;
+}
+
+inline uint32_t sampleLogCount() {
+  return sampleLog.stored;
+}
+
+inline uint32_t sampleLogFlashPages() {
+  return sampleLog.nextPage - sampleLog.firstPage;
+}
+
+// Remove the oldest flash page, counting whatever was left in it
+void sampleLogDropFirstPage(uint16_t remaining) {
+  char path[32];
+  sampleLogPagePath(path, sampleLog.firstPage);
+  LittleFS.remove(path);
+  sampleLog.firstPage++;
+  sampleLog.firstCount = 0;
+  sampleLog.drainOffset = 0;
+  sampleLog.stored -= remaining;
+  sampleLog.peeked = 0;  // whatever was peeked from it is gone
+}
+
+// Write the undrained part of the RAM page to flash as one block-sized file
+void sampleLogFlushRam() {
+  uint16_t count = sampleLog.ramCount - sampleLog.ramStart;
+  if (count == 0) {
+    return;
+  }
+  if (sampleLogFlashPages() >= SAMPLE_LOG_MAX_PAGES) {
+    // Full: the oldest data goes
+    uint16_t first = sampleLog.firstCount ? sampleLog.firstCount : sampleLogCheckPage(sampleLog.firstPage, false);
+    uint16_t remaining = first - sampleLog.drainOffset;
+    sampleLog.dropped += remaining;
+    sampleLogDropFirstPage(remaining);
+  }
+  if (sampleLog.ramStart > 0) {
+    memmove(sampleLogRamRecord(0), sampleLogRamRecord(sampleLog.ramStart), count * GAS_RECORD_LEN);
+  }
+  uint8_t *header = sampleLog.ram;
+  gasLinkPut32(header, SAMPLE_LOG_MAGIC);
+  gasLinkPut16(header + 4, count);
+  gasLinkPut16(header + 6, gasLinkCrc16(sampleLogRamRecord(0), count * GAS_RECORD_LEN));
+
+  char path[32];
+  sampleLogPagePath(path, sampleLog.nextPage);
+  File f = LittleFS.open(path, "w");
+  // Always a whole block, so the file occupies exactly one and is never appended to
+  bool ok = f && f.write(sampleLog.ram, SAMPLE_LOG_PAGE_BYTES) == SAMPLE_LOG_PAGE_BYTES;
+  if (f) f.close();
+  if (ok) {
+    sampleLog.nextPage++;
+    sampleLog.pagesWritten++;
+  } else {
+    LittleFS.remove(path);
+    sampleLog.dropped += count;
+    sampleLog.stored -= count;
+  }
+  sampleLog.ramStart = 0;
+  sampleLog.ramCount = 0;
+}
+
+// Queue one record; flushes the RAM page to flash when it fills up
+void sampleLogAppend(const GasLinkRecord &r) {
+  if (!sampleLog.mounted) {
+    sampleLog.dropped++;
+    return;
+  }
+  if (sampleLog.ramCount >= SAMPLE_LOG_PAGE_RECORDS) {
+    sampleLogFlushRam();
+  }
+  gasLinkPackRecord(sampleLogRamRecord(sampleLog.ramCount++), r);
+  sampleLog.stored++;
+}
+
+// Copy up to max of the oldest records into out without removing them.
+// Flash pages come first, then the RAM page.
+uint8_t sampleLogPeek(GasLinkRecord *out, uint8_t max) {
+  while (sampleLogFlashPages() > 0) {
+    if (sampleLog.firstCount == 0) {
+      sampleLog.firstCount = sampleLogCheckPage(sampleLog.firstPage, false);
+      if (sampleLog.firstCount == 0) {
+        sampleLogDropFirstPage(0);  // removed as corrupt at startup
+        continue;
+      }
+    }
+    uint16_t left = sampleLog.firstCount - sampleLog.drainOffset;
+    uint8_t n = left < max ? left : max;
+    char path[32];
+    sampleLogPagePath(path, sampleLog.firstPage);
+    File f = LittleFS.open(path, "r");
+    if (!f || !f.seek(SAMPLE_LOG_HEADER_BYTES + sampleLog.drainOffset * GAS_RECORD_LEN)) {
+      if (f) f.close();
+      return 0;
+    }
+    uint8_t buf[GAS_RECORD_LEN];
+    uint8_t got = 0;
+    while (got < n && f.read(buf, GAS_RECORD_LEN) == GAS_RECORD_LEN) {
+      gasLinkUnpackRecord(buf, out[got++]);
+    }
+    f.close();
+    sampleLog.peeked = got;
+    return got;
+  }
+
+  uint16_t left = sampleLog.ramCount - sampleLog.ramStart;
+  uint8_t n = left < max ? left : max;
+  for (uint8_t i = 0; i < n; i++) {
+    gasLinkUnpackRecord(sampleLogRamRecord(sampleLog.ramStart + i), out[i]);
+  }
+  sampleLog.peeked = n;
+  return n;
+}
+
+// Remove the first n records returned by the last sampleLogPeek() (fewer if
+// the log overflowed and dropped them in the meantime)
+void sampleLogConsume(uint8_t n) {
+  if (n > sampleLog.peeked) {
+    n = sampleLog.peeked;
+  }
+  sampleLog.peeked = 0;
+  if (sampleLogFlashPages() > 0) {
+    sampleLog.drainOffset += n;
+    sampleLog.stored -= n;
+    if (sampleLog.drainOffset >= sampleLog.firstCount) {
+      sampleLogDropFirstPage(0);
+    }
+    return;
+  }
+  sampleLog.ramStart += n;
+  sampleLog.stored -= n;
+  if (sampleLog.ramStart >= sampleLog.ramCount) {
+    sampleLog.ramStart = 0;
+    sampleLog.ramCount = 0;
+  }
+}
+
+#endif
@@ -0,0 +1,151 @@
+// Lightweight loop-latency profiler with per-region log2 histograms
+//
+// Declare a region per piece of code to time and open a scope in it:
+//
+//   ProfileRegion profParse("parse");
+//   void processIncomingData() {
+//     PROFILE_SCOPE(profParse);
+//     ...
+//   }
+//
+// Each scope exit adds the elapsed time to the region's histogram:
+//   bucket 0 = under 1 us, bucket i = [2^(i-1), 2^i) us, the last bucket
+//   also collects everything longer.
+// profileDump() prints every region (count, average, max and the non-empty
+// buckets) and starts a new measurement window.
+//
+// Timing source:
+//   ESP32: the CPU cycle counter. One probe is a register read plus a few
+//   adds, well under 1 us at 240 MHz. The counter wraps after ~17 s, so
+//   longer scopes are not measured correctly.
+//   Other boards: micros(), which takes a few us on a 16 MHz AVR and has a
+//   4 us resolution there.
+//
+// A region must only be timed from one task. Define LOOP_PROFILE 0 before
+// including this file to compile all probes out.
+
+#ifndef LOOP_PROFILER_H
+#define LOOP_PROFILER_H
+
+#ifndef LOOP_PROFILE
+#define LOOP_PROFILE 1
+#endif
+
+#define PROFILE_BUCKETS 22   // last bucket starts at 2^20 us (~1 s)
+
+#if defined(ESP32)
+#define PROFILE_TICKS_PER_US (F_CPU / 1000000)
+inline uint32_t profileTicks() { return ESP.getCycleCount(); }
+#else
+#define PROFILE_TICKS_PER_US 1
+inline uint32_t profileTicks() { return micros(); }
+#endif
+
+struct ProfileRegion {
+  const char *name;
+  uint32_t count;
+  uint32_t maxTicks;
+  uint64_t totalTicks;
+  uint32_t buckets[PROFILE_BUCKETS];
+  ProfileRegion *next;
+
+  // Regions add themselves to a list so profileDump() finds all of them
+  explicit ProfileRegion(const char *regionName);
+};
+
+ProfileRegion *profileRegions = NULL;
+ProfileRegion *profileRegionsTail = NULL;
+unsigned long profileWindowStart = 0;
+
+inline ProfileRegion::ProfileRegion(const char *regionName)
+    : name(regionName), count(0), maxTicks(0), totalTicks(0), buckets(), next(NULL) {
+  if (profileRegionsTail) {
+    profileRegionsTail->next = this;
+  } else {
+    profileRegions = this;
+  }
+  profileRegionsTail = this;
+}
+
+// Histogram bucket of a duration. __builtin_clz() takes an unsigned int,
+// which is 16 bits on AVR, so count on unsigned long at whatever width it has
+inline uint8_t profileBucket(uint32_t us) {
+  uint8_t bucket = us ? sizeof(unsigned long) * 8 - __builtin_clzl(us) : 0;
+  return bucket < PROFILE_BUCKETS ? bucket : PROFILE_BUCKETS - 1;
+}
+
+inline void profileRecord(ProfileRegion &r, uint32_t ticks) {
+  uint32_t us = ticks / PROFILE_TICKS_PER_US;
+  r.buckets[profileBucket(us)]++;
+  r.count++;
+  r.totalTicks += ticks;
+  if (ticks > r.maxTicks) {
+    r.maxTicks = ticks;
+  }
+}
+
+// Times the enclosing block
+struct ProfileScope {
+  ProfileRegion &region;
+  uint32_t start;
+  explicit ProfileScope(ProfileRegion &r) : region(r), start(profileTicks()) {}
+  ~ProfileScope() { profileRecord(region, profileTicks() - start); }
+};
+
+#if LOOP_PROFILE
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(region) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(region)
+#else
+#define PROFILE_SCOPE(region)
+#endif
+
+// Print all regions to Serial, then clear them for the next window
+void profileDump() {
+  Serial.print("=== LOOP PROFILE (last ");
+  Serial.print((millis() - profileWindowStart) / 1000);
+  Serial.println(" s) ===");
+  for (ProfileRegion *r = profileRegions; r; r = r->next) {
+    Serial.print(r->name);
+    Serial.print(": ");
+    Serial.print(r->count);
+    if (r->count == 0) {
+      Serial.println(" calls");
+      continue;
+    }
+    Serial.print(" calls, avg ");
+    Serial.print((double)r->totalTicks / r->count / PROFILE_TICKS_PER_US, 1);
+    Serial.print(" us, max ");
+    Serial.print(r->maxTicks / PROFILE_TICKS_PER_US);
+    Serial.println(" us");
+    for (uint8_t i = 0; i < PROFILE_BUCKETS; i++) {
+      if (r->buckets[i] == 0) {
+        continue;
+      }
+      char line[48];
+      if (i == 0) {
+        snprintf(line, sizeof(line), "  %8s < 1 us", "");
+      } else if (i == 1) {
+        snprintf(line, sizeof(line), "  %8u us   ", 1u);
+      } else if (i == PROFILE_BUCKETS - 1) {
+        snprintf(line, sizeof(line), "  %8lu+ us   ", 1UL << (i - 1));
+      } else {
+        snprintf(line, sizeof(line), "  %8lu-%lu us", 1UL << (i - 1), (1UL << i) - 1);
+      }
+      Serial.print(line);
+      Serial.print(": ");
+      Serial.print(r->buckets[i]);
+      Serial.print(" (");
+      Serial.print(100.0 * r->buckets[i] / r->count, 1);
+      Serial.println("%)");
+    }
+    memset(r->buckets, 0, sizeof(r->buckets));
+    r->count = 0;
+    r->maxTicks = 0;
+    r->totalTicks = 0;
+  }
+  Serial.println("========================");
+  profileWindowStart = millis();
+}
+
+#endif
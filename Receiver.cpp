@@ -1,10 +1,34 @@
+#include "Gas_Link_Protocol.h"
+#include "Gas_Compensation.h"
+#include "Gas_Rise_Detector.h"
+#include "Alert_Sequencer.h"
+#include "Button_Events.h"
+#include "Fast_Gpio.h"
+#include "Loop_Profiler.h"
+#include "Spsc_Queue.h"
+
+#define LOG_RING_SIZE 2048
+#include "Deferred_Log.h"
+
 #define RXD2 16
 #define TXD2 17
 
-// Gas sensor thresholds - ADJUST THESE BASED ON YOUR BASELINE READINGS
-#define MQ135_THRESHOLD 220   // Air quality/H2S
-#define MQ7_THRESHOLD   500   // Carbon Monoxide
-#define MQ5_THRESHOLD   3200  // Methane - INCREASED because your baseline is ~2700
+// Rate-of-rise pre-alarm (Gas_Rise_Detector.h): a gas climbing faster than
+// this many ppm per minute (fitted over the last ~20 s), from at least the
+// given level, warns before its threshold is reached
+#define MQ135_RISE_PPM_MIN 15
+#define MQ135_RISE_FLOOR   10
+#define MQ7_RISE_PPM_MIN   20
+#define MQ7_RISE_FLOOR     15
+#define MQ5_RISE_PPM_MIN   400
+#define MQ5_RISE_FLOOR     200
+
+// Gas alarm thresholds in ppm. The transmitters convert their readings
+// with each sensor's datasheet curve (Gas_Calibration.h) and the receiver
+// corrects them for temperature and humidity (Gas_Compensation.h).
+#define MQ135_THRESHOLD 25    // Air quality, as NH3
+#define MQ7_THRESHOLD   50    // Carbon Monoxide
+#define MQ5_THRESHOLD   1000  // Methane
 
 // O2 thresholds
 #define O2_SAFE_THRESHOLD     19.5  // >19.5% = Green (Safe)
@@ -12,6 +36,7 @@
                                     // <16% = Red (Danger)
 
 // O2 Calibration constants - CALIBRATED FOR YOUR SENSOR
+// (the O2 cell's output is linear in concentration, so one factor is enough)
 #define O2_CALIBRATION_FACTOR 0.025  // Calibrated: 21% at ~840 raw reading
 #define O2_ZERO_OFFSET        0      // Baseline offset
 
@@ -33,6 +58,22 @@
 #define MQ5_BUTTON   18
 #define MQ5_STATUS   15
 
+// Alert patterns, one per gas: {duration ms, buzzer/LED level}, 0 = repeat
+const AlertStep PATTERN_MQ135[] PROGMEM = {  // fast blink - Air Quality/H2S
+  {200, HIGH}, {200, LOW}, {0, LOW}
+};
+const AlertStep PATTERN_MQ7[] PROGMEM = {    // double short beep - Carbon Monoxide
+  {100, HIGH}, {100, LOW}, {100, HIGH}, {600, LOW}, {0, LOW}
+};
+const AlertStep PATTERN_MQ5[] PROGMEM = {    // slow long beep - Methane
+  {1000, HIGH}, {1000, LOW}, {0, LOW}
+};
+
+// Rate-of-rise pre-alarm, the same for every gas: a short chirp every 3 s
+const AlertStep PATTERN_RISING[] PROGMEM = {
+  {60, HIGH}, {2940, LOW}, {0, LOW}
+};
+
 // RGB LED pins for O2 status (Common Anode)
 #define RGB_RED_PIN   5
 #define RGB_GREEN_PIN 23  
@@ -41,7 +82,26 @@
 // Data reception status LED
 #define STATUS_LED_PIN 14
 #define STATUS_BLINK_MS 300
-#define DATA_TIMEOUT_MS 10000  // 10 seconds timeout
+#define DATA_TIMEOUT_MS 10000  // 10 seconds timeout (per node)
+
+// Pins written on every frame or blink, with direct register writes
+typedef FastPinGroup<RGB_RED_PIN, RGB_GREEN_PIN, RGB_BLUE_PIN> RgbPins;
+typedef FastPin<STATUS_LED_PIN> StatusLed;
+
+// Multi-node operation: each transmitter tags its frames with a node ID
+#define MAX_NODES 32
+
+// Decoded samples waiting to go from the link task (core 0) to loop() (core 1)
+#define SAMPLE_QUEUE_LEN 16   // power of two
+
+// Link telemetry
+#define SEQ_WINDOW 32                 // late frames within this many count as out-of-order
+#define TIME_SYNC_TICK_MS 1000        // one clock-sync request per tick, round-robin over nodes
+#define TIME_SYNC_INTERVAL_MS 30000   // re-sync each node this often (crystals drift ~50 ppm)
+#define TIME_SYNC_MAX_RTT_MS 500      // replies slower than this give a poor offset estimate
+#define TELEMETRY_INTERVAL_MS 60000
+#define TELEMETRY_QUERY_CHAR 't'      // send on the debug console for an immediate report
+#define PROFILE_QUERY_CHAR 'p'        // send for the loop timing histograms
 
 // Connection loss warning pattern
 #define WARNING_BLINK_COUNT 5
@@ -49,19 +109,124 @@
 #define WARNING_BLINK_OFF_MS 200
 #define WARNING_PAUSE_MS 10000
 
-// Global variables to store current sensor values
-int currentMQ135 = 0, currentMQ7 = 0, currentMQ5 = 0;
+// Gas channels that drive alerts
+enum GasChannel { GAS_MQ135, GAS_MQ7, GAS_MQ5, GAS_CHANNELS };
+
+// O2 level of a node, in increasing severity (O2_NONE = node has no O2 sensor)
+enum O2Level { O2_NONE, O2_SAFE, O2_WARNING, O2_DANGER, O2_LEVELS };
+
+// Console messages, sent as deferred binary records (decode with tools/log_decode.py)
+#define RECEIVER_LOG(X) \
+  X(LOG_NEW_NODE,            "New node %u (%u/%d)") \
+  X(LOG_NODE_TABLE_FULL,     "Node table full - ignoring node %u") \
+  X(LOG_IGNORED_FRAME,       "Ignoring frame #%u of type %u") \
+  X(LOG_DUPLICATE_FRAME,     "Duplicate frame #%u from node %u") \
+  X(LOG_RECEIVED_FRAME,      "Received frame #%u from node %u") \
+  X(LOG_NODE_HEADER,         "=== NODE %u SENSOR DATA ===") \
+  X(LOG_WARMING,             "Sensors warming up - gas alarms held") \
+  X(LOG_CLIMATE,             "Temperature: %.1f°C\nHumidity: %.1f%%") \
+  X(LOG_CLIMATE_ERROR,       "Temperature/Humidity: sensor error") \
+  X(LOG_MQ7_OK,              "MQ7 (CO): %u ppm (raw %u) OK") \
+  X(LOG_MQ7_ALERT,           "MQ7 (CO): %u ppm (raw %u) ALERT!") \
+  X(LOG_MQ5_OK,              "MQ5 (CH4): %u ppm (raw %u) OK") \
+  X(LOG_MQ5_ALERT,           "MQ5 (CH4): %u ppm (raw %u) ALERT!") \
+  X(LOG_MQ135_OK,            "MQ135 (Air): %u ppm (raw %u) OK") \
+  X(LOG_MQ135_ALERT,         "MQ135 (Air): %u ppm (raw %u) ALERT!") \
+  X(LOG_O2_SAFE,             "O2 Raw: %d | O2: %.2f%% SAFE (Green)") \
+  X(LOG_O2_WARNING,          "O2 Raw: %d | O2: %.2f%% WARNING (Yellow)") \
+  X(LOG_O2_DANGER,           "O2 Raw: %d | O2: %.2f%% DANGER (Red)") \
+  X(LOG_NODE_SUMMARY,        "Nodes: %u active, %u lost | in alarm: MQ7=%u MQ5=%u MQ135=%u") \
+  X(LOG_LINK_COUNTERS,       "Link: %lu frames, %lu CRC errors, %lu resync bytes, %lu overflows") \
+  X(LOG_NODE_FOOTER,         "=======================") \
+  X(LOG_BACKLOG_HEADER,      "=== NODE %u BACKLOG (%u samples) ===") \
+  X(LOG_BACKLOG_SAMPLE,      "#%u %lds ago: CO:%u CH4:%u NH3:%u ppm") \
+  X(LOG_BACKLOG_SAMPLE_NODE_TIME, "#%u at node time %lus: CO:%u CH4:%u NH3:%u ppm") \
+  X(LOG_BACKLOG_O2,          "  O2:%.2f%%") \
+  X(LOG_BACKLOG_ALERT,       "  ALERT (past)") \
+  X(LOG_CONNECTION_RESTORED, "Node %u: connection restored") \
+  X(LOG_NODE_TIMEOUT,        "Node %u: no data for %d s") \
+  X(LOG_CONNECTION_LOST,     "CONNECTION LOST (%u node(s)) - Starting warning blinks") \
+  X(LOG_RISING,              "Node %u: MQ%u rising %ld ppm/min - PRE-ALARM") \
+  X(LOG_ALERTS_ENABLED,      "MQ%u alerts ENABLED") \
+  X(LOG_ALERTS_DISABLED,     "MQ%u alerts DISABLED")
+LOG_CATALOG(RECEIVER_LOG)
+
+// Link quality of one transmitter, from sequence numbers and timestamps
+struct LinkStats {
+  bool seqValid;
+  uint16_t highestSeq;
+  uint32_t seqWindow;       // bit i set = frame (highestSeq - i) received
+  uint32_t received, lost, duplicates, outOfOrder, restarts;
+  uint32_t recovered;       // replayed from the node's flash backlog
+  uint16_t lastBatchSeq;    // to spot a BATCH resent because our ACK was lost
+  bool batchSeen;
+  bool transitValid;
+  int32_t lastTransit;      // arrival - acquisition in ms, includes the clock offset
+  int32_t jitterQ4;         // RFC 3550 inter-arrival jitter, ms * 16
+  bool clockSynced;
+  int32_t clockOffset;      // node millis() - receiver millis()
+  uint32_t rtt;             // round trip of the last accepted clock sync
+  unsigned long lastSync;
+  uint32_t syncRejects;
+  uint32_t latencyLast, latencyMax, latencySum, latencyCount;  // acquisition -> handled, ms
+};
+
+// Link side of one transmitter, owned by linkTask (core 0)
+struct NodeState {
+  uint8_t id;
+  GasSample latest;
+  LinkStats link;
+};
+
+// Alert side of one transmitter, owned by loop() (core 1)
+struct NodeAlerts {
+  std::atomic<uint8_t> linkLost;  // also read by linkTask
+  unsigned long lastSeen;
+  uint8_t alarmMask;  // bit per GasChannel currently over threshold
+  uint8_t riseMask;   // bit per GasChannel rising fast (pre-alarm)
+  uint8_t o2Level;
+  GasRiseDetector rise[GAS_CHANNELS];
+};
+
+// A new (not duplicate) live sample, passed from linkTask to loop()
+struct RxSample {
+  uint8_t slot;       // index in nodes[] and nodeAlerts[]
+  GasSample sample;
+};
+
+// Fixed-capacity node table, indexed directly by node ID so each frame is O(1)
+NodeState nodes[MAX_NODES];
+int8_t nodeSlot[256];            // node ID -> index in nodes[], -1 = not seen yet
+uint8_t nodeCount = 0;
+uint32_t nodeTableFullDrops = 0;
+NodeAlerts nodeAlerts[MAX_NODES];  // same index as nodes[]
+uint8_t alertNodeCount = 0;        // slots loop() has had a sample for
+uint8_t nodeTimeoutCursor = 0;     // link-loss check visits one node per loop()
+
+// Samples go from core 0 to core 1 through this queue: wait-free, no locks
+SpscQueue<RxSample, SAMPLE_QUEUE_LEN> rxSamples;
+volatile uint32_t rxSampleDrops = 0;     // loop() fell behind
+
+// Aggregates updated per frame so alerts follow the worst node without a scan.
+// Only loop() writes them; the atomic ones (and NodeAlerts::linkLost) are
+// also read by linkTask on core 0 for its reports and time-sync choices.
+std::atomic<uint8_t> alarmNodes[GAS_CHANNELS];  // nodes currently over each gas threshold
+uint8_t riseNodes[GAS_CHANNELS];   // nodes in rate-of-rise pre-alarm per gas
+uint8_t o2LevelNodes[O2_LEVELS];   // nodes at each O2 level
+std::atomic<uint8_t> lostNodes(0);
 
 // Button states
-bool alertsEnabled_MQ135 = true, alertsEnabled_MQ7 = true, alertsEnabled_MQ5 = true;
-bool lastButtonState_MQ135 = HIGH, lastButtonState_MQ7 = HIGH, lastButtonState_MQ5 = HIGH;
-
-// Independent timing for each sensor pattern
-unsigned long statusLedOffTime = 0;
-unsigned long prevMillis135 = 0, prevMillis7 = 0, prevMillis5 = 0;
-unsigned long lastDataReceived = 0;
-bool dataReceivedOnce = false;
-int mq7PatternStep = 0;   // for MQ7 double-beep sequence
+bool alertsEnabled[GAS_CHANNELS] = {true, true, true};
+const uint8_t gasStatusPins[GAS_CHANNELS] = {MQ135_STATUS, MQ7_STATUS, MQ5_STATUS};
+const uint8_t gasSensorNumbers[GAS_CHANNELS] = {135, 7, 5};  // MQ-xxx, for messages
+const AlertStep *const gasPatterns[GAS_CHANNELS] = {PATTERN_MQ135, PATTERN_MQ7, PATTERN_MQ5};
+const GasRiseLimit riseLimits[GAS_CHANNELS] = {
+  {MQ135_RISE_PPM_MIN, MQ135_RISE_FLOOR},
+  {MQ7_RISE_PPM_MIN, MQ7_RISE_FLOOR},
+  {MQ5_RISE_PPM_MIN, MQ5_RISE_FLOOR},
+};
+
+unsigned long statusLedOffTime = 0;  // data reception blink
 
 // Connection loss warning variables
 unsigned long warningBlinkTimer = 0;
@@ -70,22 +235,43 @@ bool warningBlinkState = false;
 enum WarningState { WAITING, BLINKING, PAUSING };
 WarningState warningState = WAITING;
 
+// UART frame reassembly (fixed-size ring, no heap)
+GasLinkReader linkReader;
+
+// Clock-sync requests and telemetry reports
+uint16_t timeSyncSeq = 0;
+uint8_t timeSyncCursor = 0;
+unsigned long lastTimeSyncTick = 0;
+unsigned long lastTelemetryPrint = 0;
+
+// Loop timing, dumped on PROFILE_QUERY_CHAR
+ProfileRegion profLoop("loop");
+ProfileRegion profButtons("buttons");
+ProfileRegion profAlerts("alert patterns");
+ProfileRegion profParse("parse (link task)");
+
 void setup() {
   Serial.begin(115200);
   Serial2.begin(9600, SERIAL_8N1, RXD2, TXD2);
 
   // Initialize gas sensor pins
-  pinMode(MQ135_BUZZER, OUTPUT); pinMode(MQ135_LED, OUTPUT); pinMode(MQ135_STATUS, OUTPUT); pinMode(MQ135_BUTTON, INPUT_PULLUP);
-  pinMode(MQ7_BUZZER, OUTPUT);   pinMode(MQ7_LED, OUTPUT);   pinMode(MQ7_STATUS, OUTPUT);   pinMode(MQ7_BUTTON, INPUT_PULLUP);
-  pinMode(MQ5_BUZZER, OUTPUT);   pinMode(MQ5_LED, OUTPUT);   pinMode(MQ5_STATUS, OUTPUT);   pinMode(MQ5_BUTTON, INPUT_PULLUP);
+  pinMode(MQ135_BUZZER, OUTPUT); pinMode(MQ135_LED, OUTPUT); pinMode(MQ135_STATUS, OUTPUT);
+  pinMode(MQ7_BUZZER, OUTPUT);   pinMode(MQ7_LED, OUTPUT);   pinMode(MQ7_STATUS, OUTPUT);
+  pinMode(MQ5_BUZZER, OUTPUT);   pinMode(MQ5_LED, OUTPUT);   pinMode(MQ5_STATUS, OUTPUT);
+
+  // One alert sequencer channel and button per gas, in GasChannel order
+  alertAddChannel(PATTERN_MQ135, MQ135_BUZZER, MQ135_LED);
+  alertAddChannel(PATTERN_MQ7, MQ7_BUZZER, MQ7_LED);
+  alertAddChannel(PATTERN_MQ5, MQ5_BUZZER, MQ5_LED);
+  buttonAdd(MQ135_BUTTON);
+  buttonAdd(MQ7_BUTTON);
+  buttonAdd(MQ5_BUTTON);
 
   // Initialize RGB LED pins
-  pinMode(RGB_RED_PIN, OUTPUT);
-  pinMode(RGB_GREEN_PIN, OUTPUT);
-  pinMode(RGB_BLUE_PIN, OUTPUT);
+  RgbPins::output();
 
   // Initialize status LED
-  pinMode(STATUS_LED_PIN, OUTPUT);
+  StatusLed::output();
 
   // Set initial status LED states
   digitalWrite(MQ135_STATUS, HIGH);
@@ -95,133 +281,479 @@ void setup() {
   // Set RGB to off initially (all pins HIGH for common anode)
   setRGBColor(0, 0, 0);
 
+  // No nodes known yet
+  for (int i = 0; i < 256; i++) {
+    nodeSlot[i] = -1;
+  }
+
+  // Frame reception, parsing and the console on core 0; loop() runs the
+  // alerts and outputs on core 1
+  xTaskCreatePinnedToCore(linkTask, "link", 8192, NULL, 2, NULL, 0);
+
   Serial.println("=== Gas Detection Receiver Started ===");
-  Serial.println("Listening for sensor data...");
+  Serial.printf("Listening for sensor data from up to %d nodes...\n", MAX_NODES);
   Serial.println("DISPLAYS: Temperature, Humidity, O2, MQ7, MQ5, MQ135");
   Serial.println("ALERTS: Only MQ7, MQ5, MQ135 (buzzer + LED)");
   Serial.println("O2 RGB: >19.5%(Green) 16-19.5%(Yellow) <16%(Red)");
 }
 
 void loop() {
+  PROFILE_SCOPE(profLoop);
+
   // Handle button controls
-  handleButton(MQ135_BUTTON, alertsEnabled_MQ135, lastButtonState_MQ135, MQ135_STATUS, "MQ135");
-  handleButton(MQ7_BUTTON, alertsEnabled_MQ7, lastButtonState_MQ7, MQ7_STATUS, "MQ7");
-  handleButton(MQ5_BUTTON, alertsEnabled_MQ5, lastButtonState_MQ5, MQ5_STATUS, "MQ5");
+  {
+    PROFILE_SCOPE(profButtons);
+    ButtonEvent press;
+    while (buttonNextEvent(press)) {
+      toggleAlerts(press.button);
+    }
+  }
+
+  // Samples decoded by the link task
+  RxSample rx;
+  while (rxSamples.pop(rx)) {
+    applySample(rx);
+  }
 
   // Handle status LED timeout
   if (statusLedOffTime != 0 && millis() > statusLedOffTime) {
-    digitalWrite(STATUS_LED_PIN, LOW);
+    StatusLed::low();
     statusLedOffTime = 0;
   }
 
   // Check for data timeout (communication loss)
   checkDataTimeout();
 
-  // Process incoming UART data
-  if (Serial2.available()) {
-    processIncomingData();
+  // Alert patterns run independently, each while a node is over that
+  // gas threshold (or, with a short chirp, rising fast towards it) and its
+  // alerts are enabled
+  PROFILE_SCOPE(profAlerts);
+  for (uint8_t ch = 0; ch < GAS_CHANNELS; ch++) {
+    alertSetPattern(ch, alarmNodes[ch] > 0 ? gasPatterns[ch] : PATTERN_RISING);
+    alertSetActive(ch, alertsEnabled[ch] && (alarmNodes[ch] > 0 || riseNodes[ch] > 0));
   }
+  alertRun();
+}
+
+// Core 0: UART reception and parsing, ACKs, clock sync and every report on
+// the debug console. Only decoded samples cross to loop() on core 1, so a
+// slow print here can never hold up a buzzer pattern.
+void linkTask(void *) {
+  for (;;) {
+    if (Serial2.available()) {
+      processIncomingData();
+    }
+    requestTimeSync();
+    logDrain();
+
+    // Reports: link telemetry periodically, or either report on request
+    // from the debug console. These print directly, after the queued log.
+    int request = Serial.available() ? Serial.read() : -1;
+    if (request == TELEMETRY_QUERY_CHAR || millis() - lastTelemetryPrint >= TELEMETRY_INTERVAL_MS) {
+      logFlush();
+      printLinkTelemetry();
+    }
+    if (request == PROFILE_QUERY_CHAR) {
+      logFlush();
+      profileDump();  // (loop()'s regions keep counting meanwhile; good enough for a report)
+    }
 
-  // Run independent alert patterns (can run simultaneously)
-  if (alertsEnabled_MQ135) patternMQ135();
-  if (alertsEnabled_MQ7)   patternMQ7();
-  if (alertsEnabled_MQ5)   patternMQ5();
+    vTaskDelay(1);  // ~1 byte arrives per ms at 9600 baud; the UART buffers the rest
+  }
 }
 
+// Drain whatever the UART has buffered and handle every complete frame.
+// Never waits for the rest of a frame, so loop() timing is unaffected.
 void processIncomingData() {
-  String data = Serial2.readStringUntil('\n');
-  data.trim();
-  Serial.println("Received: " + data);
+  PROFILE_SCOPE(profParse);
+  while (Serial2.available()) {
+    gasLinkReaderPush(linkReader, Serial2.read());
+  }
 
-  // Blink status LED to show data reception
-  digitalWrite(STATUS_LED_PIN, HIGH);
-  statusLedOffTime = millis() + STATUS_BLINK_MS;
-  lastDataReceived = millis();
-  dataReceivedOnce = true;
-  
-  // Reset warning state when data is received
-  warningState = WAITING;
-  warningBlinkCount = 0;
-
-  // Clean up data for parsing
-  data.replace(" ", "");   // Remove spaces
-  data.replace("°C", "");  // Remove degree symbol
-  data.replace("%", "");   // Remove percent symbol
-
-  // Parse the transmitter format: Temp:X,Humidity:X,MQ7:X,MQ5:X,MQ135:X,O2Raw:X
-  float temp, hum, o2val;
-  int mq7, mq5, mq135, o2raw;
-
-  int parsed = sscanf(data.c_str(),
-                      "Temp:%f,Humidity:%f,MQ7:%d,MQ5:%d,MQ135:%d,O2Raw:%d,O2:%f",
-                      &temp, &hum, &mq7, &mq5, &mq135, &o2raw, &o2val);
-
-  if (parsed >= 5) {  // At least need Temp, Humidity, MQ7, MQ5, MQ135
-    // Store MQ sensor values for alert patterns
-    currentMQ135 = mq135;
-    currentMQ7 = mq7;
-    currentMQ5 = mq5;
-
-    // Calculate O2 percentage from raw value (for display and RGB LED)
-    float o2percent = 0.0;
-    if (parsed >= 6) {  // If O2Raw field exists
-      o2percent = (o2raw * O2_CALIBRATION_FACTOR) + O2_ZERO_OFFSET;
-      o2percent = constrain(o2percent, 0.0, 30.0);
-      
-      // Handle O2 RGB LED indication
-      handleOxygenStatus(o2percent);
+  GasLinkFrame frame;
+  while (gasLinkReaderNext(linkReader, frame)) {
+    GasSample sample;
+    GasTimeSync sync;
+    GasLinkRecord records[GAS_BATCH_MAX_RECORDS];
+    uint8_t count;
+    if (gasLinkDecodeSample(frame, sample)) {
+      gasCompensateSample(sample);
+      handleSample(frame.node, frame.seq, sample);
+    } else if ((count = gasLinkDecodeBatch(frame, records, GAS_BATCH_MAX_RECORDS)) > 0) {
+      for (uint8_t i = 0; i < count; i++) {
+        gasCompensateSample(records[i].sample);
+      }
+      handleBatch(frame.node, frame.seq, records, count);
+    } else if (gasLinkDecodeTimeResponse(frame, sync)) {
+      handleTimeResponse(frame.node, sync);
+    } else if (frame.type != GAS_LINK_TYPE_TIME_REQ && frame.type != GAS_LINK_TYPE_ACK) {
+      // (our own requests and ACKs echo on a shared bus)
+      LOG(LOG_IGNORED_FRAME, frame.seq, frame.type);
+    }
+  }
+}
+
+// Find (or assign) the table slot for a node ID. NULL when the table is full.
+NodeState *lookupNode(uint8_t id) {
+  int8_t slot = nodeSlot[id];
+  if (slot >= 0) {
+    return &nodes[slot];
+  }
+  if (nodeCount >= MAX_NODES) {
+    return NULL;
+  }
+  NodeState &n = nodes[nodeCount];
+  n = NodeState();
+  n.id = id;
+  nodeSlot[id] = nodeCount++;
+  LOG(LOG_NEW_NODE, id, nodeCount, MAX_NODES);
+  return &n;
+}
+
+// Refresh a node's alarm bits and O2 level, keeping the aggregates in step
+void updateNodeAlerts(NodeAlerts &n, uint8_t alarmMask, uint8_t riseMask, uint8_t o2Level) {
+  uint8_t changed = alarmMask ^ n.alarmMask;
+  uint8_t riseChanged = riseMask ^ n.riseMask;
+  for (int ch = 0; ch < GAS_CHANNELS; ch++) {
+    if (changed & (1 << ch)) {
+      if (alarmMask & (1 << ch)) alarmNodes[ch]++;
+      else                       alarmNodes[ch]--;
+    }
+    if (riseChanged & (1 << ch)) {
+      if (riseMask & (1 << ch)) riseNodes[ch]++;
+      else                      riseNodes[ch]--;
     }
+  }
+  n.alarmMask = alarmMask;
+  n.riseMask = riseMask;
 
-    // Display ALL sensor data
-    Serial.println("=== ALL SENSOR DATA ===");
-    Serial.printf("Temperature: %.1f°C\n", temp);
-    Serial.printf("Humidity: %.1f%%\n", hum);
-    Serial.printf("MQ7 (CO): %d %s\n", mq7, (mq7 > MQ7_THRESHOLD) ? "ALERT!" : "OK");
-    Serial.printf("MQ5 (CH4): %d %s\n", mq5, (mq5 > MQ5_THRESHOLD) ? "ALERT!" : "OK");
-    Serial.printf("MQ135 (Air): %d %s\n", mq135, (mq135 > MQ135_THRESHOLD) ? "ALERT!" : "OK");
-    if (parsed >= 6) {
-      Serial.printf("O2 Raw: %d | O2: %.2f%% %s\n", o2raw, o2percent, getO2Status(o2percent).c_str());
+  o2LevelNodes[n.o2Level]--;
+  o2LevelNodes[o2Level]++;
+  n.o2Level = o2Level;
+}
+
+// Loss/duplicate/reordering accounting for one sample SEQ. Replayed samples
+// fill gaps that were counted as lost. Returns false for a duplicate.
+bool updateSequence(LinkStats &l, uint16_t seq, bool replayed) {
+  int16_t delta = (int16_t)(seq - l.highestSeq);
+  if (!l.seqValid || (delta <= -SEQ_WINDOW && !replayed)) {
+    // First frame, or the node restarted and its sequence began again
+    if (l.seqValid) {
+      l.restarts++;
+    }
+    l.seqValid = true;
+    l.highestSeq = seq;
+    l.seqWindow = 1;
+    l.transitValid = false;
+  } else if (delta > 0) {
+    l.lost += delta - 1;  // provisional, undone if a missing frame turns up late
+    l.seqWindow = delta < 32 ? (l.seqWindow << delta) | 1 : 1;
+    l.highestSeq = seq;
+  } else if (delta > -SEQ_WINDOW) {
+    uint32_t bit = 1UL << -delta;
+    if (l.seqWindow & bit) {
+      l.duplicates++;
+      return false;
     }
-    Serial.println("=======================");
-    
+    l.seqWindow |= bit;
+    if (l.lost > 0) l.lost--;
+    if (!replayed) l.outOfOrder++;
+  } else if (l.lost > 0) {
+    l.lost--;  // replayed from before the window: it was counted as lost
+  }
+  if (replayed) l.recovered++;
+  else          l.received++;
+  return true;
+}
+
+// Account for one live sample frame: sequence, plus jitter and latency from
+// the acquisition timestamp. Returns false for a duplicate, which should not
+// be processed again.
+bool updateLinkStats(LinkStats &l, uint16_t seq, uint32_t acquired, unsigned long arrival) {
+  if (!updateSequence(l, seq, false)) {
+    return false;
+  }
+
+  // Jitter (RFC 3550): smoothed change in transit time; a constant clock
+  // offset cancels out, so no sync is needed for this
+  int32_t transit = (int32_t)(arrival - acquired);
+  if (l.transitValid) {
+    int32_t d = transit - l.lastTransit;
+    if (d < 0) d = -d;
+    l.jitterQ4 += d - ((l.jitterQ4 + 8) >> 4);
+  }
+  l.lastTransit = transit;
+  l.transitValid = true;
+
+  // One-way latency needs the node's clock mapped onto ours
+  if (l.clockSynced) {
+    int32_t latency = transit + l.clockOffset;
+    l.latencyLast = latency > 0 ? latency : 0;
+    if (l.latencyLast > l.latencyMax) l.latencyMax = l.latencyLast;
+    l.latencySum += l.latencyLast;
+    l.latencyCount++;
+  }
+  return true;
+}
+
+void handleSample(uint8_t node, uint16_t seq, const GasSample &sample) {
+  NodeState *n = lookupNode(node);
+  if (n == NULL) {
+    nodeTableFullDrops++;
+    LOG(LOG_NODE_TABLE_FULL, node);
+    return;
+  }
+  sendAck(node, seq, GAS_LINK_TYPE_SAMPLE);
+  if (!updateLinkStats(n->link, seq, sample.timestamp, millis())) {
+    LOG(LOG_DUPLICATE_FRAME, seq, node);
+    return;
+  }
+  LOG(LOG_RECEIVED_FRAME, seq, node);
+  n->latest = sample;
+
+  // Alerts are loop()'s job
+  RxSample rx = {(uint8_t)nodeSlot[node], sample};
+  if (!rxSamples.push(rx)) {
+    rxSampleDrops++;
+  }
+
+  // Display ALL sensor data
+  LOG(LOG_NODE_HEADER, node);
+  if (sample.flags & GAS_FLAG_WARMING) {
+    LOG(LOG_WARMING);
+  }
+  if (sample.flags & GAS_FLAG_HAS_CLIMATE) {
+    LOG(LOG_CLIMATE, sample.temperature / 10.0, sample.humidity / 10.0);
   } else {
-    Serial.println("Parse Error! Expected at least 5 fields, got " + String(parsed));
+    LOG(LOG_CLIMATE_ERROR);
   }
+  if (sample.mq7Ppm > MQ7_THRESHOLD)     LOG(LOG_MQ7_ALERT, sample.mq7Ppm, sample.mq7);
+  else                                   LOG(LOG_MQ7_OK, sample.mq7Ppm, sample.mq7);
+  if (sample.mq5Ppm > MQ5_THRESHOLD)     LOG(LOG_MQ5_ALERT, sample.mq5Ppm, sample.mq5);
+  else                                   LOG(LOG_MQ5_OK, sample.mq5Ppm, sample.mq5);
+  if (sample.mq135Ppm > MQ135_THRESHOLD) LOG(LOG_MQ135_ALERT, sample.mq135Ppm, sample.mq135);
+  else                                   LOG(LOG_MQ135_OK, sample.mq135Ppm, sample.mq135);
+  if (sample.flags & GAS_FLAG_HAS_O2) {
+    float o2percent = o2Percent(sample);
+    switch (getO2Level(o2percent)) {
+      case O2_SAFE:    LOG(LOG_O2_SAFE, sample.o2raw, o2percent); break;
+      case O2_WARNING: LOG(LOG_O2_WARNING, sample.o2raw, o2percent); break;
+      default:         LOG(LOG_O2_DANGER, sample.o2raw, o2percent); break;
+    }
+  }
+  // (the counts are loop()'s and may not include this frame yet)
+  LOG(LOG_NODE_SUMMARY, nodeCount, lostNodes.load(std::memory_order_relaxed),
+      alarmNodes[GAS_MQ7].load(std::memory_order_relaxed), alarmNodes[GAS_MQ5].load(std::memory_order_relaxed),
+      alarmNodes[GAS_MQ135].load(std::memory_order_relaxed));
+  LOG(LOG_LINK_COUNTERS, (unsigned long)linkReader.frames, (unsigned long)linkReader.crcErrors,
+      (unsigned long)linkReader.resyncs, (unsigned long)linkReader.overflows);
+  LOG(LOG_NODE_FOOTER);
 }
 
-// Button toggle with sensor name for debugging
-void handleButton(int buttonPin, bool &alertsEnabled, bool &lastButtonState, int statusLED, String sensorName) {
-  bool state = digitalRead(buttonPin);
-  if (lastButtonState == HIGH && state == LOW) {
-    alertsEnabled = !alertsEnabled;
-    digitalWrite(statusLED, alertsEnabled ? HIGH : LOW);
-    
-    // Turn OFF buzzer and LED when disabling alerts
-    if (!alertsEnabled) {
-      if (sensorName == "MQ135") {
-        digitalWrite(MQ135_BUZZER, LOW);
-        digitalWrite(MQ135_LED, LOW);
-      } else if (sensorName == "MQ7") {
-        digitalWrite(MQ7_BUZZER, LOW);
-        digitalWrite(MQ7_LED, LOW);
-        mq7PatternStep = 0;  // Reset pattern step
-      } else if (sensorName == "MQ5") {
-        digitalWrite(MQ5_BUZZER, LOW);
-        digitalWrite(MQ5_LED, LOW);
+// Core 1: act on a sample from the link task
+void applySample(const RxSample &rx) {
+  while (alertNodeCount <= rx.slot) {
+    // (slots start zeroed and are never reused)
+    nodeAlerts[alertNodeCount++].o2Level = O2_NONE;
+    o2LevelNodes[O2_NONE]++;
+  }
+  NodeAlerts &a = nodeAlerts[rx.slot];
+  const GasSample &sample = rx.sample;
+
+  // Blink status LED to show data reception
+  StatusLed::high();
+  statusLedOffTime = millis() + STATUS_BLINK_MS;
+  a.lastSeen = millis();
+  if (a.linkLost.load(std::memory_order_relaxed)) {
+    a.linkLost.store(false, std::memory_order_relaxed);
+    lostNodes.fetch_sub(1, std::memory_order_relaxed);
+    LOG(LOG_CONNECTION_RESTORED, nodes[rx.slot].id);
+  }
+
+  // Which gas thresholds this node is over, and which gases are rising
+  // fast towards them (neither while its sensors warm up)
+  uint8_t alarmMask = 0, riseMask = 0;
+  if (!(sample.flags & GAS_FLAG_WARMING)) {
+    if (sample.mq135Ppm > MQ135_THRESHOLD) alarmMask |= 1 << GAS_MQ135;
+    if (sample.mq7Ppm > MQ7_THRESHOLD)     alarmMask |= 1 << GAS_MQ7;
+    if (sample.mq5Ppm > MQ5_THRESHOLD)     alarmMask |= 1 << GAS_MQ5;
+    const uint16_t ppm[GAS_CHANNELS] = {sample.mq135Ppm, sample.mq7Ppm, sample.mq5Ppm};
+    for (uint8_t ch = 0; ch < GAS_CHANNELS; ch++) {
+      if (riseUpdate(a.rise[ch], riseLimits[ch], sample.timestamp, ppm[ch])) {
+        riseMask |= 1 << ch;
+        if (!(a.riseMask & (1 << ch))) {
+          LOG(LOG_RISING, nodes[rx.slot].id, gasSensorNumbers[ch], (long)a.rise[ch].slope);
+        }
       }
     }
-    
-    Serial.println(sensorName + " alerts " + (alertsEnabled ? "ENABLED" : "DISABLED"));
-    delay(200);
+  } else {
+    for (uint8_t ch = 0; ch < GAS_CHANNELS; ch++) {
+      riseReset(a.rise[ch]);
+    }
+  }
+
+  uint8_t o2Level = O2_NONE;
+  if (sample.flags & GAS_FLAG_HAS_O2) {
+    o2Level = getO2Level(o2Percent(sample));
+  }
+  updateNodeAlerts(a, alarmMask, riseMask, o2Level);
+
+  // RGB LED follows the worst O2 level across all nodes
+  handleOxygenStatus();
+}
+
+void sendAck(uint8_t node, uint16_t seq, uint8_t ackedType) {
+  uint8_t frame[GAS_LINK_MAX_FRAME];
+  size_t frameLen = gasLinkEncodeAck(frame, node, seq, ackedType);
+  Serial2.write(frame, frameLen);
+}
+
+// Samples a node buffered to flash while the link was down. They are shown
+// as history and fill the loss statistics, but are too old to drive alerts.
+void handleBatch(uint8_t node, uint16_t batchSeq, const GasLinkRecord *records, uint8_t count) {
+  NodeState *n = lookupNode(node);
+  if (n == NULL) {
+    nodeTableFullDrops++;
+    return;
+  }
+  sendAck(node, batchSeq, GAS_LINK_TYPE_BATCH);
+  LinkStats &l = n->link;
+  if (l.batchSeen && batchSeq == l.lastBatchSeq) {
+    return;  // resent because our ACK was lost
+  }
+  l.batchSeen = true;
+  l.lastBatchSeq = batchSeq;
+
+  unsigned long now = millis();
+  LOG(LOG_BACKLOG_HEADER, node, count);
+  for (uint8_t i = 0; i < count; i++) {
+    const GasLinkRecord &r = records[i];
+    if (!updateSequence(l, r.seq, true)) {
+      continue;
+    }
+    const GasSample &s = r.sample;
+    bool alert = !(s.flags & GAS_FLAG_WARMING) &&
+                 (s.mq135Ppm > MQ135_THRESHOLD || s.mq7Ppm > MQ7_THRESHOLD || s.mq5Ppm > MQ5_THRESHOLD);
+    if (l.clockSynced) {
+      // Age in our clock: now - (acquired - offset)
+      long age = (long)(now - s.timestamp + l.clockOffset) / 1000;
+      LOG(LOG_BACKLOG_SAMPLE, r.seq, age, s.mq7Ppm, s.mq5Ppm, s.mq135Ppm);
+    } else {
+      LOG(LOG_BACKLOG_SAMPLE_NODE_TIME, r.seq, (unsigned long)(s.timestamp / 1000), s.mq7Ppm, s.mq5Ppm, s.mq135Ppm);
+    }
+    if (s.flags & GAS_FLAG_HAS_O2) {
+      LOG(LOG_BACKLOG_O2, o2Percent(s));
+    }
+    if (alert) {
+      LOG(LOG_BACKLOG_ALERT);
+    }
+  }
+}
+
+// Send a clock-sync request to at most one node per tick, round-robin,
+// skipping nodes that are lost or were synced recently
+void requestTimeSync() {
+  if (nodeCount == 0 || millis() - lastTimeSyncTick < TIME_SYNC_TICK_MS) {
+    return;
+  }
+  lastTimeSyncTick = millis();
+  NodeState &n = nodes[timeSyncCursor];
+  bool linkLost = nodeAlerts[timeSyncCursor].linkLost.load(std::memory_order_relaxed);  // loop()'s view, a hint is enough
+  timeSyncCursor = (timeSyncCursor + 1) % nodeCount;
+  if (linkLost || (n.link.clockSynced && millis() - n.link.lastSync < TIME_SYNC_INTERVAL_MS)) {
+    return;
+  }
+  uint8_t frame[GAS_LINK_MAX_FRAME];
+  size_t frameLen = gasLinkEncodeTimeRequest(frame, n.id, ++timeSyncSeq, millis());
+  Serial2.write(frame, frameLen);
+}
+
+// Clock offset from a TIME_RESP (NTP style, see Gas_Link_Protocol.h)
+void handleTimeResponse(uint8_t node, const GasTimeSync &sync) {
+  int8_t slot = nodeSlot[node];
+  if (slot < 0) {
+    return;
+  }
+  LinkStats &l = nodes[slot].link;
+  uint32_t t3 = millis();
+  uint32_t rtt = (t3 - sync.t0) - (sync.t2 - sync.t1);
+  if (rtt > TIME_SYNC_MAX_RTT_MS) {
+    l.syncRejects++;
+    return;
+  }
+  l.clockOffset = ((int32_t)(sync.t1 - sync.t0) + (int32_t)(sync.t2 - t3)) / 2;
+  l.rtt = rtt;
+  l.clockSynced = true;
+  l.lastSync = t3;
+}
+
+// Per-node link quality report
+void printLinkTelemetry() {
+  lastTelemetryPrint = millis();
+  Serial.println("=== LINK TELEMETRY ===");
+  for (int i = 0; i < nodeCount; i++) {
+    const NodeState &n = nodes[i];
+    const LinkStats &l = n.link;
+    bool linkLost = nodeAlerts[i].linkLost.load(std::memory_order_relaxed);
+    uint32_t expected = l.received + l.recovered + l.lost;
+    Serial.printf("Node %u%s: %lu received, %lu recovered, %lu lost (%.1f%%), %lu duplicate, "
+                  "%lu out-of-order, %lu restarts\n",
+                  n.id, linkLost ? " (LOST)" : "", (unsigned long)l.received,
+                  (unsigned long)l.recovered, (unsigned long)l.lost,
+                  expected ? 100.0 * l.lost / expected : 0.0, (unsigned long)l.duplicates,
+                  (unsigned long)l.outOfOrder, (unsigned long)l.restarts);
+    Serial.printf("  jitter %.1f ms", l.jitterQ4 / 16.0);
+    if (l.clockSynced) {
+      Serial.printf(", latency %lu ms (avg %lu, max %lu), clock offset %+ld ms, rtt %lu ms\n",
+                    (unsigned long)l.latencyLast,
+                    (unsigned long)(l.latencyCount ? l.latencySum / l.latencyCount : 0),
+                    (unsigned long)l.latencyMax, (long)l.clockOffset, (unsigned long)l.rtt);
+    } else {
+      Serial.printf(", latency unknown (clock not synced, %lu slow replies)\n",
+                    (unsigned long)l.syncRejects);
+    }
+  }
+  Serial.printf("Link: %lu frames, %lu CRC errors, %lu resync bytes, %lu overflows\n",
+                (unsigned long)linkReader.frames, (unsigned long)linkReader.crcErrors,
+                (unsigned long)linkReader.resyncs, (unsigned long)linkReader.overflows);
+  Serial.printf("Core handoff: %u/%d samples queued, %lu dropped\n",
+                (unsigned)rxSamples.count(), SAMPLE_QUEUE_LEN, (unsigned long)rxSampleDrops);
+  Serial.println("======================");
+}
+
+// A button press toggles its gas's alerts
+void toggleAlerts(uint8_t ch) {
+  alertsEnabled[ch] = !alertsEnabled[ch];
+  digitalWrite(gasStatusPins[ch], alertsEnabled[ch] ? HIGH : LOW);
+  // (the alert sequencer silences the buzzer and LED on the next loop)
+  if (alertsEnabled[ch]) LOG(LOG_ALERTS_ENABLED, gasSensorNumbers[ch]);
+  else                   LOG(LOG_ALERTS_DISABLED, gasSensorNumbers[ch]);
+}
+
+// Check one node for link loss per call, so the cost stays O(1) per loop()
+void checkNodeTimeouts() {
+  if (alertNodeCount == 0) {
+    return;
+  }
+  uint8_t slot = nodeTimeoutCursor;
+  NodeAlerts &a = nodeAlerts[slot];
+  nodeTimeoutCursor = (nodeTimeoutCursor + 1) % alertNodeCount;
+  if (!a.linkLost.load(std::memory_order_relaxed) && millis() - a.lastSeen > DATA_TIMEOUT_MS) {
+    a.linkLost.store(true, std::memory_order_relaxed);
+    lostNodes.fetch_add(1, std::memory_order_relaxed);
+    LOG(LOG_NODE_TIMEOUT, nodes[slot].id, DATA_TIMEOUT_MS / 1000);
   }
-  lastButtonState = state;
 }
 
 // Check for communication timeout and handle warning pattern
 void checkDataTimeout() {
-  // Only check timeout if we've received data at least once
-  if (!dataReceivedOnce || (millis() - lastDataReceived <= DATA_TIMEOUT_MS)) {
-    return;  // Connection is OK or never established
+  checkNodeTimeouts();
+
+  // Warning pattern runs while any known node is lost
+  if (lostNodes == 0) {
+    warningState = WAITING;
+    warningBlinkCount = 0;
+    return;
   }
 
   // Connection lost - run warning pattern
@@ -233,9 +765,9 @@ void checkDataTimeout() {
       warningState = BLINKING;
       warningBlinkCount = 0;
       warningBlinkState = true;
-      digitalWrite(STATUS_LED_PIN, HIGH);
+      StatusLed::high();
       warningBlinkTimer = now;
-      Serial.println("CONNECTION LOST - Starting warning blinks");
+      LOG(LOG_CONNECTION_LOST, lostNodes.load(std::memory_order_relaxed));
       
       // Flash RGB LED red for communication error
       setRGBColor(255, 0, 0);
@@ -246,7 +778,7 @@ void checkDataTimeout() {
       if (warningBlinkState) {
         // LED is ON, wait for ON duration
         if (now - warningBlinkTimer >= WARNING_BLINK_ON_MS) {
-          digitalWrite(STATUS_LED_PIN, LOW);
+          StatusLed::low();
           warningBlinkState = false;
           warningBlinkTimer = now;
           warningBlinkCount++;
@@ -256,7 +788,7 @@ void checkDataTimeout() {
         if (now - warningBlinkTimer >= WARNING_BLINK_OFF_MS) {
           if (warningBlinkCount < WARNING_BLINK_COUNT) {
             // Continue blinking
-            digitalWrite(STATUS_LED_PIN, HIGH);
+            StatusLed::high();
             warningBlinkState = true;
             warningBlinkTimer = now;
           } else {
@@ -278,115 +810,38 @@ void checkDataTimeout() {
   }
 }
 
-// Handle oxygen status with RGB LED
-void handleOxygenStatus(float o2percent) {
-  if (o2percent > O2_SAFE_THRESHOLD) {
-    // Green - Safe oxygen levels
-    setRGBColor(0, 255, 0);
-  } else if (o2percent >= O2_WARNING_THRESHOLD) {
-    // Yellow - Warning oxygen levels
-    setRGBColor(255, 255, 0);
-  } else {
-    // Red - Dangerous oxygen levels
-    setRGBColor(255, 0, 0);
-  }
-}
-
-// Set RGB LED color - For COMMON ANODE RGB LED
-void setRGBColor(int red, int green, int blue) {
-  // For common anode RGB LED: LOW = ON, HIGH = OFF
-  digitalWrite(RGB_RED_PIN, (red > 0) ? LOW : HIGH);
-  digitalWrite(RGB_GREEN_PIN, (green > 0) ? LOW : HIGH);
-  digitalWrite(RGB_BLUE_PIN, (blue > 0) ? LOW : HIGH);
+// O2 percentage from a sample's raw reading
+float o2Percent(const GasSample &sample) {
+  float o2percent = (sample.o2raw * O2_CALIBRATION_FACTOR) + O2_ZERO_OFFSET;
+  return constrain(o2percent, 0.0, 30.0);
 }
 
-// Get O2 status string for display
-String getO2Status(float o2percent) {
+// Classify an O2 percentage
+uint8_t getO2Level(float o2percent) {
   if (o2percent > O2_SAFE_THRESHOLD) {
-    return "SAFE (Green)";
+    return O2_SAFE;
   } else if (o2percent >= O2_WARNING_THRESHOLD) {
-    return "WARNING (Yellow)";
-  } else {
-    return "DANGER (Red)";
+    return O2_WARNING;
   }
+  return O2_DANGER;
 }
 
-// --- INDEPENDENT ALERT PATTERNS ---
-
-// MQ135 = Fast blink (200ms) - Air Quality/H2S
-void patternMQ135() {
-  if (currentMQ135 > MQ135_THRESHOLD) {
-    unsigned long now = millis();
-    if (now - prevMillis135 >= 200) {
-      prevMillis135 = now;
-      digitalWrite(MQ135_BUZZER, !digitalRead(MQ135_BUZZER));
-      digitalWrite(MQ135_LED, !digitalRead(MQ135_LED));
-    }
-  } else {
-    digitalWrite(MQ135_BUZZER, LOW);
-    digitalWrite(MQ135_LED, LOW);
-  }
-}
-
-// MQ7 = Double short beep pattern - Carbon Monoxide
-void patternMQ7() {
-  unsigned long now = millis();
-  if (currentMQ7 > MQ7_THRESHOLD) {
-    switch (mq7PatternStep) {
-      case 0: // first beep
-        digitalWrite(MQ7_BUZZER, HIGH);
-        digitalWrite(MQ7_LED, HIGH);
-        prevMillis7 = now;
-        mq7PatternStep = 1;
-        break;
-      case 1: // pause after first beep
-        if (now - prevMillis7 >= 100) {
-          digitalWrite(MQ7_BUZZER, LOW);
-          digitalWrite(MQ7_LED, LOW);
-          prevMillis7 = now;
-          mq7PatternStep = 2;
-        }
-        break;
-      case 2: // second beep
-        if (now - prevMillis7 >= 100) {
-          digitalWrite(MQ7_BUZZER, HIGH);
-          digitalWrite(MQ7_LED, HIGH);
-          prevMillis7 = now;
-          mq7PatternStep = 3;
-        }
-        break;
-      case 3: // pause after second beep
-        if (now - prevMillis7 >= 100) {
-          digitalWrite(MQ7_BUZZER, LOW);
-          digitalWrite(MQ7_LED, LOW);
-          prevMillis7 = now;
-          mq7PatternStep = 4;
-        }
-        break;
-      case 4: // long pause before repeating
-        if (now - prevMillis7 >= 500) {
-          mq7PatternStep = 0;
-        }
-        break;
-    }
-  } else {
-    digitalWrite(MQ7_BUZZER, LOW);
-    digitalWrite(MQ7_LED, LOW);
-    mq7PatternStep = 0;
+// Handle oxygen status with RGB LED, showing the worst node
+void handleOxygenStatus() {
+  if (o2LevelNodes[O2_DANGER] > 0) {
+    // Red - Dangerous oxygen levels
+    setRGBColor(255, 0, 0);
+  } else if (o2LevelNodes[O2_WARNING] > 0) {
+    // Yellow - Warning oxygen levels
+    setRGBColor(255, 255, 0);
+  } else if (o2LevelNodes[O2_SAFE] > 0) {
+    // Green - Safe oxygen levels
+    setRGBColor(0, 255, 0);
   }
 }
 
-// MQ5 = Slow long beep (1000ms) - Methane
-void patternMQ5() {
-  if (currentMQ5 > MQ5_THRESHOLD) {
-    unsigned long now = millis();
-    if (now - prevMillis5 >= 1000) {
-      prevMillis5 = now;
-      digitalWrite(MQ5_BUZZER, !digitalRead(MQ5_BUZZER));
-      digitalWrite(MQ5_LED, !digitalRead(MQ5_LED));
-    }
-  } else {
-    digitalWrite(MQ5_BUZZER, LOW);
-    digitalWrite(MQ5_LED, LOW);
-  }
+// Set RGB LED color - For COMMON ANODE RGB LED
+void setRGBColor(int red, int green, int blue) {
+  // For common anode RGB LED: LOW = ON, HIGH = OFF. All three change together.
+  RgbPins::write((red > 0 ? 0 : 1) | (green > 0 ? 0 : 2) | (blue > 0 ? 0 : 4));
 }
@@ -1,10 +1,14 @@
+#include "Gas_Link_Protocol.h"
+#include "Alert_Sequencer.h"
+#include "Button_Events.h"
+
 #define RXD2 16
 #define TXD2 17
 
-// Gas sensor thresholds
-#define MQ135_THRESHOLD 660   // Air quality/H2S
-#define MQ7_THRESHOLD   660   // Carbon Monoxide
-#define MQ5_THRESHOLD   660   // Methane
+// Gas alarm thresholds in ppm (SS_25_T converts with Gas_Calibration.h)
+#define MQ135_THRESHOLD 25    // Air quality, as NH3
+#define MQ7_THRESHOLD   50    // Carbon Monoxide
+#define MQ5_THRESHOLD   1000  // Methane
 
 // MQ135 pins
 #define MQ135_BUZZER 27
@@ -24,6 +28,20 @@
 #define MQ5_BUTTON   18
 #define MQ5_STATUS   15
 
+// Gas channels: index of the alert pattern, button and status LED
+enum GasChannel { GAS_MQ135, GAS_MQ7, GAS_MQ5, GAS_CHANNELS };
+
+// Alert patterns, one per gas: {duration ms, buzzer/LED level}, 0 = repeat
+const AlertStep PATTERN_MQ135[] PROGMEM = {  // fast blink - Air Quality/H2S
+  {200, HIGH}, {200, LOW}, {0, LOW}
+};
+const AlertStep PATTERN_MQ7[] PROGMEM = {    // double short beep - Carbon Monoxide
+  {100, HIGH}, {100, LOW}, {100, HIGH}, {600, LOW}, {0, LOW}
+};
+const AlertStep PATTERN_MQ5[] PROGMEM = {    // slow long beep - Methane
+  {1000, HIGH}, {1000, LOW}, {0, LOW}
+};
+
 // Data reception status LED
 #define STATUS_LED_PIN 14
 #define STATUS_BLINK_MS 300
@@ -36,18 +54,16 @@
 #define WARNING_PAUSE_MS 10000
 
 // Global variables to store current sensor values
-int currentMQ135 = 0, currentMQ7 = 0, currentMQ5 = 0;
+uint16_t currentMQ135 = 0, currentMQ7 = 0, currentMQ5 = 0;   // ppm
 
 // Button states
-bool alertsEnabled_MQ135 = true, alertsEnabled_MQ7 = true, alertsEnabled_MQ5 = true;
-bool lastButtonState_MQ135 = HIGH, lastButtonState_MQ7 = HIGH, lastButtonState_MQ5 = HIGH;
+bool alertsEnabled[GAS_CHANNELS] = {true, true, true};
+const uint8_t gasStatusPins[GAS_CHANNELS] = {MQ135_STATUS, MQ7_STATUS, MQ5_STATUS};
+const char *const gasNames[GAS_CHANNELS] = {"MQ135", "MQ7", "MQ5"};
 
-// Independent timing for each sensor pattern
-unsigned long statusLedOffTime = 0;
-unsigned long prevMillis135 = 0, prevMillis7 = 0, prevMillis5 = 0;
+unsigned long statusLedOffTime = 0;  // data reception blink
 unsigned long lastDataReceived = 0;
 bool dataReceivedOnce = false;
-int mq7PatternStep = 0;   // for MQ7 double-beep sequence
 
 // Connection loss warning variables
 unsigned long warningBlinkTimer = 0;
@@ -56,14 +72,25 @@ bool warningBlinkState = false;
 enum WarningState { WAITING, BLINKING, PAUSING };
 WarningState warningState = WAITING;
 
+// UART frame reassembly (fixed-size ring, no heap)
+GasLinkReader linkReader;
+
 void setup() {
   Serial.begin(115200);
   Serial2.begin(9600, SERIAL_8N1, RXD2, TXD2);
 
   // Initialize gas sensor pins
-  pinMode(MQ135_BUZZER, OUTPUT); pinMode(MQ135_LED, OUTPUT); pinMode(MQ135_STATUS, OUTPUT); pinMode(MQ135_BUTTON, INPUT_PULLUP);
-  pinMode(MQ7_BUZZER, OUTPUT);   pinMode(MQ7_LED, OUTPUT);   pinMode(MQ7_STATUS, OUTPUT);   pinMode(MQ7_BUTTON, INPUT_PULLUP);
-  pinMode(MQ5_BUZZER, OUTPUT);   pinMode(MQ5_LED, OUTPUT);   pinMode(MQ5_STATUS, OUTPUT);   pinMode(MQ5_BUTTON, INPUT_PULLUP);
+  pinMode(MQ135_BUZZER, OUTPUT); pinMode(MQ135_LED, OUTPUT); pinMode(MQ135_STATUS, OUTPUT);
+  pinMode(MQ7_BUZZER, OUTPUT);   pinMode(MQ7_LED, OUTPUT);   pinMode(MQ7_STATUS, OUTPUT);
+  pinMode(MQ5_BUZZER, OUTPUT);   pinMode(MQ5_LED, OUTPUT);   pinMode(MQ5_STATUS, OUTPUT);
+
+  // One alert sequencer channel and button per gas, in GasChannel order
+  alertAddChannel(PATTERN_MQ135, MQ135_BUZZER, MQ135_LED);
+  alertAddChannel(PATTERN_MQ7, MQ7_BUZZER, MQ7_LED);
+  alertAddChannel(PATTERN_MQ5, MQ5_BUZZER, MQ5_LED);
+  buttonAdd(MQ135_BUTTON);
+  buttonAdd(MQ7_BUTTON);
+  buttonAdd(MQ5_BUTTON);
 
   // Initialize status LED
   pinMode(STATUS_LED_PIN, OUTPUT);
@@ -80,9 +107,10 @@ void setup() {
 
 void loop() {
   // Handle button controls
-  handleButton(MQ135_BUTTON, alertsEnabled_MQ135, lastButtonState_MQ135, MQ135_STATUS, "MQ135");
-  handleButton(MQ7_BUTTON, alertsEnabled_MQ7, lastButtonState_MQ7, MQ7_STATUS, "MQ7");
-  handleButton(MQ5_BUTTON, alertsEnabled_MQ5, lastButtonState_MQ5, MQ5_STATUS, "MQ5");
+  ButtonEvent press;
+  while (buttonNextEvent(press)) {
+    toggleAlerts(press.button);
+  }
 
   // Handle status LED timeout
   if (statusLedOffTime != 0 && millis() > statusLedOffTime) {
@@ -98,16 +126,50 @@ void loop() {
     processIncomingData();
   }
 
-  // Run independent alert patterns (can run simultaneously)
-  if (alertsEnabled_MQ135) patternMQ135();
-  if (alertsEnabled_MQ7)   patternMQ7();
-  if (alertsEnabled_MQ5)   patternMQ5();
+  // Alert patterns run independently, each while its gas is over the
+  // threshold and its alerts are enabled
+  alertSetActive(GAS_MQ135, alertsEnabled[GAS_MQ135] && currentMQ135 > MQ135_THRESHOLD);
+  alertSetActive(GAS_MQ7, alertsEnabled[GAS_MQ7] && currentMQ7 > MQ7_THRESHOLD);
+  alertSetActive(GAS_MQ5, alertsEnabled[GAS_MQ5] && currentMQ5 > MQ5_THRESHOLD);
+  alertRun();
 }
 
+// Drain whatever the UART has buffered and handle every complete frame.
+// Never waits for the rest of a frame, so loop() timing is unaffected.
 void processIncomingData() {
-  String data = Serial2.readStringUntil('\n');
-  data.trim();
-  Serial.println("Received: " + data);
+  while (Serial2.available()) {
+    gasLinkReaderPush(linkReader, Serial2.read());
+  }
+
+  GasLinkFrame frame;
+  while (gasLinkReaderNext(linkReader, frame)) {
+    GasSample sample;
+    GasLinkRecord records[GAS_BATCH_MAX_RECORDS];
+    uint8_t count;
+    if (gasLinkDecodeSample(frame, sample)) {
+      sendAck(frame.node, frame.seq, GAS_LINK_TYPE_SAMPLE);
+      handleSample(frame.node, frame.seq, sample);
+    } else if ((count = gasLinkDecodeBatch(frame, records, GAS_BATCH_MAX_RECORDS)) > 0) {
+      // Backlog a transmitter buffered during an outage: too old for alerts,
+      // acknowledged so it can drain
+      sendAck(frame.node, frame.seq, GAS_LINK_TYPE_BATCH);
+      Serial.printf("Node %u replayed %u buffered samples (#%u..#%u)\n",
+                    frame.node, count, records[0].seq, records[count - 1].seq);
+    } else {
+      Serial.printf("Ignoring frame #%u of type %u\n", frame.seq, frame.type);
+    }
+  }
+}
+
+// Lets store-and-forward transmitters know the frame arrived
+void sendAck(uint8_t node, uint16_t seq, uint8_t ackedType) {
+  uint8_t frame[GAS_LINK_MAX_FRAME];
+  size_t frameLen = gasLinkEncodeAck(frame, node, seq, ackedType);
+  Serial2.write(frame, frameLen);
+}
+
+void handleSample(uint8_t node, uint16_t seq, const GasSample &sample) {
+  Serial.printf("Received frame #%u from node %u\n", seq, node);
 
   // Blink status LED to show data reception
   digitalWrite(STATUS_LED_PIN, HIGH);
@@ -119,60 +181,36 @@ void processIncomingData() {
   warningState = WAITING;
   warningBlinkCount = 0;
 
-  // Clean up data for parsing
-  data.replace(" ", "");
-
-  // Parse the format: MQ7:xxx,MQ5:xxx,MQ135:xxx
-  int mq7, mq5, mq135;
-
-  int parsed = sscanf(data.c_str(),
-                      "MQ7:%d,MQ5:%d,MQ135:%d",
-                      &mq7, &mq5, &mq135);
-
-  if (parsed == 3) {
-    // Store sensor values for alert patterns
-    currentMQ135 = mq135;
-    currentMQ7 = mq7;
-    currentMQ5 = mq5;
-
-    // Display parsed data
-    Serial.println("=== SENSOR DATA ===");
-    Serial.printf("MQ7 (CO): %d %s\n", mq7, (mq7 > MQ7_THRESHOLD) ? "ALERT!" : "OK");
-    Serial.printf("MQ5 (CH4): %d %s\n", mq5, (mq5 > MQ5_THRESHOLD) ? "ALERT!" : "OK");
-    Serial.printf("MQ135 (Air): %d %s\n", mq135, (mq135 > MQ135_THRESHOLD) ? "ALERT!" : "OK");
-    Serial.println("==================");
-    
-  } else {
-    Serial.println("Parse Error! Expected 3 fields, got " + String(parsed));
+  // Store sensor values for alert patterns (held at zero while the
+  // transmitter's sensors warm up)
+  bool warming = sample.flags & GAS_FLAG_WARMING;
+  currentMQ135 = warming ? 0 : sample.mq135Ppm;
+  currentMQ7 = warming ? 0 : sample.mq7Ppm;
+  currentMQ5 = warming ? 0 : sample.mq5Ppm;
+
+  // Display parsed data
+  Serial.println("=== SENSOR DATA ===");
+  if (warming) {
+    Serial.println("Sensors warming up - gas alarms held");
   }
+  Serial.printf("MQ7 (CO): %u ppm (raw %u) %s\n", sample.mq7Ppm, sample.mq7,
+                (sample.mq7Ppm > MQ7_THRESHOLD) ? "ALERT!" : "OK");
+  Serial.printf("MQ5 (CH4): %u ppm (raw %u) %s\n", sample.mq5Ppm, sample.mq5,
+                (sample.mq5Ppm > MQ5_THRESHOLD) ? "ALERT!" : "OK");
+  Serial.printf("MQ135 (Air): %u ppm (raw %u) %s\n", sample.mq135Ppm, sample.mq135,
+                (sample.mq135Ppm > MQ135_THRESHOLD) ? "ALERT!" : "OK");
+  Serial.printf("Link: %lu frames, %lu CRC errors, %lu resync bytes, %lu overflows\n",
+                (unsigned long)linkReader.frames, (unsigned long)linkReader.crcErrors,
+                (unsigned long)linkReader.resyncs, (unsigned long)linkReader.overflows);
+  Serial.println("==================");
 }
 
-// Button toggle with sensor name for debugging
-void handleButton(int buttonPin, bool &alertsEnabled, bool &lastButtonState, int statusLED, String sensorName) {
-  bool state = digitalRead(buttonPin);
-  if (lastButtonState == HIGH && state == LOW) {
-    alertsEnabled = !alertsEnabled;
-    digitalWrite(statusLED, alertsEnabled ? HIGH : LOW);
-    
-    // Turn OFF buzzer and LED when disabling alerts
-    if (!alertsEnabled) {
-      if (sensorName == "MQ135") {
-        digitalWrite(MQ135_BUZZER, LOW);
-        digitalWrite(MQ135_LED, LOW);
-      } else if (sensorName == "MQ7") {
-        digitalWrite(MQ7_BUZZER, LOW);
-        digitalWrite(MQ7_LED, LOW);
-        mq7PatternStep = 0;  // Reset pattern step
-      } else if (sensorName == "MQ5") {
-        digitalWrite(MQ5_BUZZER, LOW);
-        digitalWrite(MQ5_LED, LOW);
-      }
-    }
-    
-    Serial.println(sensorName + " alerts " + (alertsEnabled ? "ENABLED" : "DISABLED"));
-    delay(200);
-  }
-  lastButtonState = state;
+// A button press toggles its gas's alerts
+void toggleAlerts(uint8_t ch) {
+  alertsEnabled[ch] = !alertsEnabled[ch];
+  digitalWrite(gasStatusPins[ch], alertsEnabled[ch] ? HIGH : LOW);
+  // (the alert sequencer silences the buzzer and LED on the next loop)
+  Serial.printf("%s alerts %s\n", gasNames[ch], alertsEnabled[ch] ? "ENABLED" : "DISABLED");
 }
 
 // Check for communication timeout and handle warning pattern
@@ -231,83 +269,3 @@ void checkDataTimeout() {
       break;
   }
 }
-
-// --- INDEPENDENT ALERT PATTERNS ---
-
-// MQ135 = Fast blink (200ms) - Air Quality/H2S
-void patternMQ135() {
-  if (currentMQ135 > MQ135_THRESHOLD) {
-    unsigned long now = millis();
-    if (now - prevMillis135 >= 200) {
-      prevMillis135 = now;
-      digitalWrite(MQ135_BUZZER, !digitalRead(MQ135_BUZZER));
-      digitalWrite(MQ135_LED, !digitalRead(MQ135_LED));
-    }
-  } else {
-    digitalWrite(MQ135_BUZZER, LOW);
-    digitalWrite(MQ135_LED, LOW);
-  }
-}
-
-// MQ7 = Double short beep pattern - Carbon Monoxide
-void patternMQ7() {
-  unsigned long now = millis();
-  if (currentMQ7 > MQ7_THRESHOLD) {
-    switch (mq7PatternStep) {
-      case 0: // first beep
-        digitalWrite(MQ7_BUZZER, HIGH);
-        digitalWrite(MQ7_LED, HIGH);
-        prevMillis7 = now;
-        mq7PatternStep = 1;
-        break;
-      case 1: // pause after first beep
-        if (now - prevMillis7 >= 100) {
-          digitalWrite(MQ7_BUZZER, LOW);
-          digitalWrite(MQ7_LED, LOW);
-          prevMillis7 = now;
-          mq7PatternStep = 2;
-        }
-        break;
-      case 2: // second beep
-        if (now - prevMillis7 >= 100) {
-          digitalWrite(MQ7_BUZZER, HIGH);
-          digitalWrite(MQ7_LED, HIGH);
-          prevMillis7 = now;
-          mq7PatternStep = 3;
-        }
-        break;
-      case 3: // pause after second beep
-        if (now - prevMillis7 >= 100) {
-          digitalWrite(MQ7_BUZZER, LOW);
-          digitalWrite(MQ7_LED, LOW);
-          prevMillis7 = now;
-          mq7PatternStep = 4;
-        }
-        break;
-      case 4: // long pause before repeating
-        if (now - prevMillis7 >= 500) {
-          mq7PatternStep = 0;
-        }
-        break;
-    }
-  } else {
-    digitalWrite(MQ7_BUZZER, LOW);
-    digitalWrite(MQ7_LED, LOW);
-    mq7PatternStep = 0;
-  }
-}
-
-// MQ5 = Slow long beep (1000ms) - Methane
-void patternMQ5() {
-  if (currentMQ5 > MQ5_THRESHOLD) {
-    unsigned long now = millis();
-    if (now - prevMillis5 >= 1000) {
-      prevMillis5 = now;
-      digitalWrite(MQ5_BUZZER, !digitalRead(MQ5_BUZZER));
-      digitalWrite(MQ5_LED, !digitalRead(MQ5_LED));
-    }
-  } else {
-    digitalWrite(MQ5_BUZZER, LOW);
-    digitalWrite(MQ5_LED, LOW);
-  }
-}
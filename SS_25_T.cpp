@@ -1,19 +1,48 @@
+// Only small clock-sync requests come back; keep the receive buffers small
+#define GAS_LINK_RX_RING 64
+#define GAS_LINK_MAX_PAYLOAD 32
+#include "Gas_Link_Protocol.h"
+#include "Gas_Calibration.h"
+#include "Gas_Baseline.h"
+#include "Gas_Report_Policy.h"
+
 // Pin definitions for Arduino Uno
 #define TRANSMIT_LED 12  // Data transmission indicator LED
 #define STATUS_LED 13    // Built-in LED for status
+#define NODE_ID 0        // Unique per sensor pod when several share the receiver bus
 
 // Sensor analog pins
 #define MQ7_PIN A0       // Carbon Monoxide sensor
 #define MQ5_PIN A1       // Methane sensor  
 #define MQ135_PIN A2     // Air quality/H2S sensor
 
+// Clean-air ADC counts (10-bit) that set each MQ sensor's R0 (Gas_Calibration.h).
+// Measure your own: read the sensors outdoors after a full warmup.
+#define MQ7_CLEAN_AIR_ADC 88
+#define MQ5_CLEAN_AIR_ADC 675
+#define MQ135_CLEAN_AIR_ADC 38
+
 // Calibration constants
-#define WARMUP_TIME_MS 60000  // 60 seconds warmup for MQ sensors
+#define WARMUP_TIME_MS 60000  // longest MQ warmup; sooner if the saved baseline matches
+#define SAMPLE_PERIOD_MS 100  // read the sensors this often; Gas_Report_Policy.h decides what is sent
+#define BASELINE_TRACK_MS 3000  // baseline learning cadence (Gas_Baseline.h)
+#define LED_FLASH_MS 50
 
 // Global variables
 unsigned long startTime;
 int transmissionCount = 0;
 bool sensorsWarmedUp = false;
+unsigned long lastSample = 0;
+unsigned long lastBaselineTrack = 0;
+unsigned long transmitLedOn = 0, statusFlashOn = 0;  // 0 = LED not flashing
+uint32_t gasSum[GAS_BASELINE_CHANNELS] = {0};  // readings since the last frame
+uint16_t gasCount = 0;
+GasBaseline baseline;       // clean-air readings, kept in EEPROM
+ReportPolicy reportPolicy;
+GasLinkReader linkReader;   // requests from the receiver (clock sync)
+GasSensor mq7Sensor = {&GAS_CURVE_MQ7, 0};
+GasSensor mq5Sensor = {&GAS_CURVE_MQ5, 0};
+GasSensor mq135Sensor = {&GAS_CURVE_MQ135, 0};
 
 void setup() {
   Serial.begin(9600);  // UART communication with ESP32 (TX/RX only - no debug!)
@@ -21,70 +50,159 @@ void setup() {
   // Initialize pins
   pinMode(STATUS_LED, OUTPUT);
   pinMode(TRANSMIT_LED, OUTPUT);
+  gasSensorBegin(mq7Sensor, MQ7_CLEAN_AIR_ADC);
+  gasSensorBegin(mq5Sensor, MQ5_CLEAN_AIR_ADC);
+  gasSensorBegin(mq135Sensor, MQ135_CLEAN_AIR_ADC);
+  gasBaselineBegin(baseline);
   
   startTime = millis();
   digitalWrite(STATUS_LED, HIGH);  // Power indicator
   
-  // Wait for warmup silently (LED will blink)
+  // Warm up silently (LED will blink); samples are flagged as warming until done
 }
 
+// No long delays here: clock-sync requests must be answered promptly
 void loop() {
-  // Check if sensors are still warming up
+  serviceLinkRequests();
+
+  // Blink status LED during warmup (500ms intervals)
   if (!sensorsWarmedUp) {
-    if (millis() - startTime < WARMUP_TIME_MS) {
-      // Blink status LED during warmup (500ms intervals)
-      digitalWrite(STATUS_LED, (millis() / 500) % 2);
-      delay(1000);
+    digitalWrite(STATUS_LED, (millis() / 500) % 2);
+  }
+  updateLeds();
+
+  // Sample fast; a frame only goes out when the policy says so
+  if (millis() - lastSample >= SAMPLE_PERIOD_MS) {
+    lastSample = millis();
+    readAndTransmitData();
+  }
+}
+
+// End the transmit and status flashes without blocking the loop
+void updateLeds() {
+  if (transmitLedOn && millis() - transmitLedOn >= LED_FLASH_MS) {
+    transmitLedOn = 0;
+    digitalWrite(TRANSMIT_LED, LOW);
+  }
+  if (statusFlashOn && millis() - statusFlashOn >= LED_FLASH_MS) {
+    statusFlashOn = 0;
+    digitalWrite(STATUS_LED, HIGH);
+  }
+}
+
+// Answer TIME_REQ frames addressed to this node so the receiver can
+// estimate our clock offset (see Gas_Link_Protocol.h)
+void serviceLinkRequests() {
+  uint32_t received = millis();
+  while (Serial.available()) {
+    gasLinkReaderPush(linkReader, Serial.read());
+  }
+  GasLinkFrame request;
+  GasTimeSync sync;
+  while (gasLinkReaderNext(linkReader, request)) {
+    if (request.node != NODE_ID || !gasLinkDecodeTimeRequest(request, sync.t0)) {
+      continue;
+    }
+    uint8_t frame[GAS_LINK_MAX_FRAME];
+    sync.t1 = received;
+    sync.t2 = millis();
+    size_t frameLen = gasLinkEncodeTimeResponse(frame, NODE_ID, request.seq, sync);
+    Serial.write(frame, frameLen);
+  }
+}
+
+// Warm once the readings match the saved baseline, or after the full
+// warmup, whose readings then become the new baseline
+void checkWarmup(const uint16_t *mq, unsigned long now) {
+  if (!gasBaselineSettled(baseline, mq, now)) {
+    if (now - startTime < WARMUP_TIME_MS) {
       return;
-    } else {
-      sensorsWarmedUp = true;
-      digitalWrite(STATUS_LED, HIGH);  // Solid when ready
     }
+    gasBaselineReset(baseline, mq, now);
   }
-  
-  // Read and transmit sensor data
-  readAndTransmitData();
-  
-  delay(3000);  // Send data every 3 seconds
+  sensorsWarmedUp = true;
+  digitalWrite(STATUS_LED, HIGH);  // Solid when ready
 }
 
+// Pack readings into a link sample (no climate or O2 sensors on this board)
+void makeSample(GasSample &sample, unsigned long acquired, const uint16_t *mq) {
+  sample.timestamp = acquired;
+  sample.temperature = 0;
+  sample.humidity = 0;
+  sample.mq7 = mq[0];
+  sample.mq5 = mq[1];
+  sample.mq135 = mq[2];
+  sample.o2raw = 0;
+  sample.flags = sensorsWarmedUp ? 0 : GAS_FLAG_WARMING;
+  sample.mq7Ppm = gasSensorPpm(mq7Sensor, sample.mq7);
+  sample.mq5Ppm = gasSensorPpm(mq5Sensor, sample.mq5);
+  sample.mq135Ppm = gasSensorPpm(mq135Sensor, sample.mq135);
+}
+
+// Take one reading and send it if it is news (Gas_Report_Policy.h). A
+// change goes out at once as it was read; a heartbeat carries the average
+// of the readings since the last frame.
 void readAndTransmitData() {
+  unsigned long acquired = millis();
+
   // Read gas sensors (average of 3 readings for stability)
-  int mq7 = getStableReading(MQ7_PIN);
-  int mq5 = getStableReading(MQ5_PIN);
-  int mq135 = getStableReading(MQ135_PIN);
-  
-  // Create data string
-  char dataBuffer[100];
-  snprintf(dataBuffer, sizeof(dataBuffer),
-           "MQ7:%d,MQ5:%d,MQ135:%d",
-           mq7, mq5, mq135);
+  uint16_t mq[GAS_BASELINE_CHANNELS] = {
+    (uint16_t)getStableReading(MQ7_PIN), (uint16_t)getStableReading(MQ5_PIN),
+    (uint16_t)getStableReading(MQ135_PIN)
+  };
+  for (uint8_t i = 0; i < GAS_BASELINE_CHANNELS; i++) {
+    gasSum[i] += mq[i];
+  }
+  gasCount++;
+
+  if (!sensorsWarmedUp) {
+    checkWarmup(mq, acquired);
+  } else if (acquired - lastBaselineTrack >= BASELINE_TRACK_MS) {
+    lastBaselineTrack = acquired;
+    gasBaselineTrack(baseline, mq, acquired);
+  }
+
+  GasSample sample;
+  makeSample(sample, acquired, mq);
+  uint8_t reason = reportCheck(reportPolicy, sample, acquired);
+  if (reason == REPORT_NONE) {
+    return;
+  }
+  if (reason == REPORT_HEARTBEAT) {
+    for (uint8_t i = 0; i < GAS_BASELINE_CHANNELS; i++) {
+      mq[i] = (gasSum[i] + gasCount / 2) / gasCount;
+    }
+    makeSample(sample, acquired, mq);
+  }
+  reportSent(reportPolicy, sample, acquired, reason);
+  for (uint8_t i = 0; i < GAS_BASELINE_CHANNELS; i++) {
+    gasSum[i] = 0;
+  }
+  gasCount = 0;
+
+  uint8_t frame[GAS_LINK_MAX_FRAME];
+  size_t frameLen = gasLinkEncodeSample(frame, NODE_ID, (uint16_t)transmissionCount, sample);
   
-  // Blink transmit LED briefly
+  // Blink transmit LED briefly (turned off by updateLeds)
   digitalWrite(TRANSMIT_LED, HIGH);
-  
-  // Transmit ONLY sensor data via UART (no debug text!)
-  Serial.println(dataBuffer);
-  
-  // Small delay for UART stability
-  delay(50);
-  digitalWrite(TRANSMIT_LED, LOW);
-  
+  transmitLedOn = millis() | 1;
+
+  // Transmit ONLY the sensor frame via UART (no debug text!)
+  Serial.write(frame, frameLen);
+
   // Show transmission count on status LED (brief flash every 10 transmissions)
   transmissionCount++;
-  if (transmissionCount % 10 == 0) {
+  if (transmissionCount % 10 == 0 && sensorsWarmedUp) {
     digitalWrite(STATUS_LED, LOW);
-    delay(50);
-    digitalWrite(STATUS_LED, HIGH);
+    statusFlashOn = millis() | 1;
   }
 }
 
-// Get stable analog reading (average of 3 samples)
+// Get stable analog reading (average of 3 back-to-back samples, ~0.3 ms)
 int getStableReading(int pin) {
   long sum = 0;
   for (int i = 0; i < 3; i++) {
     sum += analogRead(pin);
-    delay(10);
   }
   return sum / 3;
 }
@@ -1,4 +1,25 @@
 #include <TM1637Display.h>
+#include "Loop_Profiler.h"
+#include "Fast_Gpio.h"
+#include "Ultrasonic_Scanner.h"
+#include "Traffic_Demand.h"
+
+#define LOG_RING_SIZE 512
+#include "Deferred_Log.h"
+
+// Actuated control: a green lasts until its counted queue has cleared and
+// vehicles stop arriving (minGreen to maxGreen), and roads nobody waits on
+// are skipped, though never for longer than recallMs. 0 = fixed greens from
+// allocated[]. tools/traffic_compare.py checks it against the fixed plan.
+#ifndef ACTUATED_CONTROL
+#define ACTUATED_CONTROL 1
+#endif
+
+// Fixed greens split by recent demand (Traffic_Demand.h). 0 = by the
+// lifetime vehicleCount[] totals, as before, for comparison on the bench.
+#ifndef RECENT_DEMAND_ALLOCATION
+#define RECENT_DEMAND_ALLOCATION 1
+#endif
 
 // === CONFIG ===
 const int numRoads = 4;
@@ -6,19 +27,42 @@ const int totalGreenPool = 60;  // Total seconds to distribute among all roads
 const int minGreen = 5;         // Minimum green time for any road (even with 0 vehicles)
 const int maxGreen = 40;        // Maximum green time for any road
 const int yellowTime = 2;       // yellow duration seconds
+const unsigned long gapOutMs = 3000;     // actuated: end a green this long after the last vehicle
+const unsigned long recallMs = 90000;    // actuated: a road gets a green at least this often, counted or not
+const int countMarginPct = 25;           // actuated: greens clear this much more than the counted queue
+const unsigned long allRedMs = 1000;     // all red between cycles
+const unsigned long clearanceMs = 500;   // all red after each green
+const unsigned long displayPeriodMs = 100;
+const unsigned long nominalCycleMs =     // all greens from the pool plus the fixed phases
+  totalGreenPool * 1000UL + numRoads * (yellowTime * 1000UL + clearanceMs) + allRedMs;
+const char profileQueryChar = 'p';  // send on Serial for the timing histograms
+const char endGreenChar = 'n';      // send on Serial to end the current green early
 
 // === PINS ===
 // Traffic lights: for each road: {RED, YELLOW, GREEN}
-const int lightPins[numRoads][3] = {
+constexpr int lightPins[numRoads][3] = {  // constexpr: also used as template arguments below
   {2, 3, 4},    // Road A
   {5, 6, 7},    // Road B
   {8, 9, 10},   // Road C
   {11, 12, 13}  // Road D
 };
+const int lightRed = 0, lightYellow = 1, lightGreen = 2;  // index into lightPins[road]
 
-// Ultrasonic (Trig, Echo) per road
+// All 12 light pins as one group (bit 3 * road + light), so a whole
+// intersection state is switched in a single update
+typedef FastPinGroup<lightPins[0][0], lightPins[0][1], lightPins[0][2],
+                     lightPins[1][0], lightPins[1][1], lightPins[1][2],
+                     lightPins[2][0], lightPins[2][1], lightPins[2][2],
+                     lightPins[3][0], lightPins[3][1], lightPins[3][2]> TrafficLights;
+
+// Ultrasonic (Trig, Echo) per road. The echoes share port K (A8-A15) and
+// its pin-change interrupt (Ultrasonic_Scanner.h)
 const int trigPins[numRoads] = {22, 24, 26, 28};
-const int echoPins[numRoads] = {23, 25, 27, 29};
+constexpr int echoPins[numRoads] = {A8, A9, A10, A11};
+constexpr bool echoOnPortK(int i = 0) {
+  return i == numRoads || (echoPins[i] >= A8 && echoPins[i] <= A8 + 7 && echoOnPortK(i + 1));
+}
+static_assert(echoOnPortK(), "echo pins must be on port K (A8-A15)");
 
 // TM1637 displays (CLK, DIO) per road
 const int dispCLK[numRoads] = {30, 32, 34, 36};
@@ -30,45 +74,89 @@ TM1637Display displays[numRoads] = {
   TM1637Display(dispCLK[3], dispDIO[3])
 };
 
+// Console messages, sent as deferred binary records (decode with tools/log_decode.py)
+#define TRAFFIC_LOG(X) \
+  X(LOG_VEHICLE,           "Road %c: Vehicle #%d detected!") \
+  X(LOG_ALLOCATION_HEADER, "\n--- Time Allocation Based on Recent Demand ---\nVehicles per hour (last 5 min): %d") \
+  X(LOG_ALLOCATION_ROAD,   "Road %c: %d/h, %d queued (%d%%) → %d seconds green") \
+  X(LOG_ALLOCATION_EQUAL,  "Road %c: %d/h → %d seconds green") \
+  X(LOG_ALLOCATION_FOOTER, "-----------------------------------------------") \
+  X(LOG_CYCLE_START,       "\n========== NEW TRAFFIC CYCLE ==========") \
+  X(LOG_ALL_RED,           "All roads: RED - Continuous vehicle counting active...\n") \
+  X(LOG_ROAD_TURN,         "\n----------------------------\nRoad %c's Turn:") \
+  X(LOG_NEXT_COUNTS,       "Queued (estimated): A=%d, B=%d, C=%d, D=%d") \
+  X(LOG_WAIT_TIMES,        "Wait times: A=%ds, B=%ds, C=%ds, D=%ds") \
+  X(LOG_YELLOW,            "Road %c: YELLOW (%ds)") \
+  X(LOG_GREEN,             "Road %c: GREEN (%ds) - Counting continues on all roads...") \
+  X(LOG_GREEN_TO_RED,      "Road %c: GREEN -> RED") \
+  X(LOG_GAP_OUT,           "Road %c: gap out after %lus green") \
+  X(LOG_MAX_OUT,           "Road %c: max out at %ds green") \
+  X(LOG_SKIPPED,           "Road %c: nobody waiting - skipped") \
+  X(LOG_MANUAL_END,        "Road %c: green ended by hand after %lus") \
+  X(LOG_CYCLE_END,         "\n========== CYCLE COMPLETE ==========\n" \
+                           "Recent demand will be used for NEXT cycle allocation\n" \
+                           "Vehicles so far: A=%d, B=%d, C=%d, D=%d\n" \
+                           "Phase switches: at most %lu us late")
+LOG_CATALOG(TRAFFIC_LOG)
+static_assert(numRoads == 4, "the per-road count messages list roads A-D");
+
 // === STATE ===
 int vehicleCount[numRoads];      // Total vehicles counted
+TrafficDemand laneDemand[numRoads];  // recent arrivals and queue, for the allocation
 int allocated[numRoads];         // Allocated green time
 unsigned long lastCountCheck[numRoads]; // Last time we checked each sensor
 
-// Measure distance in cm
-int getDistance(int trig, int echo) {
-  digitalWrite(trig, LOW);
-  delayMicroseconds(2);
-  digitalWrite(trig, HIGH);
-  delayMicroseconds(10);
-  digitalWrite(trig, LOW);
-  long duration = pulseIn(echo, HIGH, 20000);
-  int distance = duration * 0.034 / 2;
-  return distance;
-}
+// Controller: one phase at a time, each ending at a deadline
+enum Phase { PHASE_ALL_RED, PHASE_YELLOW, PHASE_GREEN, PHASE_CLEARANCE };
+uint8_t phase = PHASE_CLEARANCE; // a Phase; setup() starts the first cycle from here
+int phaseRoad = numRoads - 1;    // road of a yellow/green/clearance phase, -1 = none
+unsigned long phaseStart = 0;    // micros() when the phase was due to start
+unsigned long phaseLength = 0;   // us
+bool phaseEndedByHand = false;   // endGreenChar cut the current green short
+unsigned long lastGreenEnd[numRoads];  // millis() each road's green last ended, for the recall
+unsigned long cycleMaxLateUs = 0;
+uint32_t cycleCount = 0;
+int shownSeconds[numRoads];      // what each display shows
+unsigned long lastDisplayUpdate = 0;
+
+// Timing of the counting loop, dumped on profileQueryChar
+ProfileRegion profPoll("sensor poll (all roads)");
+ProfileRegion profEcho("ultrasonic trigger");
+ProfileRegion profDisplay("display update");
+ProfileRegion profPhaseLate("phase switch lateness");
 
-// Detect object (returns true if object detected)
-bool detectObject(int roadIndex) {
-  int d = getDistance(trigPins[roadIndex], echoPins[roadIndex]);
+// Detect object at a measured distance in cm (0 = nothing in range)
+bool detectObject(uint16_t d) {
   if (d > 2 && d < 7) {  // valid object in range
     return true;
   }
   return false;
 }
 
-// Check all sensors and update counts (non-blocking with delay protection)
+// Ping the next sensor when due and count vehicles in any new distances; never waits for an echo
 void updateVehicleCounts() {
+  PROFILE_SCOPE(profPoll);
+  {
+    PROFILE_SCOPE(profEcho);
+    ultrasonicService();
+  }
   for (int i = 0; i < numRoads; i++) {
-    // Only check if enough time has passed (300ms debounce per sensor)
+    uint16_t d;
+    if (!ultrasonicTake(i, d)) {
+      continue;
+    }
+    // Only count if enough time has passed (300ms debounce per sensor)
     if (millis() - lastCountCheck[i] > 300) {
-      if (detectObject(i)) {
+      if (detectObject(d)) {
         vehicleCount[i]++;
+        demandArrival(laneDemand[i], millis());
         lastCountCheck[i] = millis();
-        Serial.print("Road ");
-        Serial.print(char('A' + i));
-        Serial.print(": Vehicle #");
-        Serial.print(vehicleCount[i]);
-        Serial.println(" detected!");
+        LOG(LOG_VEHICLE, char('A' + i), vehicleCount[i]);
+#if ACTUATED_CONTROL
+        if (phase == PHASE_GREEN && phaseRoad == i) {
+          extendGreen();
+        }
+#endif
       }
     }
   }
@@ -76,6 +164,7 @@ void updateVehicleCounts() {
 
 // Show a number on a TM1637 display
 void showNumberTM(int idx, int val) {
+  PROFILE_SCOPE(profDisplay);
   if (val < 0) val = 0;
   if (val > 9999) val = 9999;
   displays[idx].showNumberDec(val, false);
@@ -83,26 +172,23 @@ void showNumberTM(int idx, int val) {
 
 void setup() {
   // LEDs
-  for (int i=0; i<numRoads; i++) {
-    for (int j=0; j<3; j++) {
-      pinMode(lightPins[i][j], OUTPUT);
-      digitalWrite(lightPins[i][j], LOW);
-    }
-  }
+  TrafficLights::output();
+  TrafficLights::write(0);
   
-  // Ultrasonic pins
+  // Ultrasonic sensors, pinged in turn
   for (int i=0; i<numRoads; i++) {
-    pinMode(trigPins[i], OUTPUT);
-    pinMode(echoPins[i], INPUT);
-    digitalWrite(trigPins[i], LOW);
+    ultrasonicAdd(trigPins[i], echoPins[i]);
     vehicleCount[i] = 0;
+    demandBegin(laneDemand[i], millis());
     lastCountCheck[i] = 0;
+    lastGreenEnd[i] = millis();
   }
   
   // Displays init
   for (int i=0; i<numRoads; i++) {
     displays[i].setBrightness(6);
     showNumberTM(i, 0);
+    shownSeconds[i] = 0;
   }
   
   // Serial for debug
@@ -116,27 +202,60 @@ void setup() {
   Serial.println("Testing: All RED lights ON for 3 seconds...");
   allRed();
   delay(3000);
+
+  // The first cycle starts on the first loop()
+  phaseStart = micros();
+  phaseLength = 0;
+}
+
+// Send queued log records, and handle the Serial commands: timing
+// histograms, or end the current green early
+void serviceSerial() {
+  logDrain();
+  if (!Serial.available()) {
+    return;
+  }
+  char c = Serial.read();
+  if (c == profileQueryChar) {
+    logFlush();
+    profileDump();
+  } else if (c == endGreenChar && phase == PHASE_GREEN) {
+    endPhaseNow();
+    phaseEndedByHand = true;
+  }
 }
 
-// Compute allocation proportionally to counts
+// Split the green pool between the roads in proportion to their demand
 void computeAllocation() {
-  int totalVehicles = 0;
+  // Demand for the next cycle: the queue left now plus what the recent
+  // arrival rate brings during one cycle (in vehicles x 3600)
+  uint32_t demand[numRoads];
+  uint16_t rate[numRoads];
+  uint32_t totalDemand = 0;
+  int totalRate = 0;
   for (int i=0; i<numRoads; i++) {
-    totalVehicles += vehicleCount[i];
+    rate[i] = demandRatePerHour(laneDemand[i], millis());
+#if RECENT_DEMAND_ALLOCATION
+    demand[i] = laneDemand[i].queue * 3600UL + rate[i] * (nominalCycleMs / 1000);
+#else
+    demand[i] = vehicleCount[i];   // every vehicle since power-up
+#endif
+    totalDemand += demand[i];
+    totalRate += rate[i];
   }
 
-  if (totalVehicles == 0) {
+  if (totalDemand == 0) {
     // No vehicles detected, distribute equally
     for (int i=0; i<numRoads; i++) {
       allocated[i] = totalGreenPool / numRoads;
     }
   } else {
-    // Distribute proportionally based on vehicle count
+    // Distribute proportionally based on recent demand
     for (int i=0; i<numRoads; i++) {
-      if (vehicleCount[i] == 0) {
+      if (demand[i] == 0) {
         allocated[i] = minGreen;
       } else {
-        float proportion = (float)vehicleCount[i] / (float)totalVehicles;
+        float proportion = (float)demand[i] / (float)totalDemand;
         allocated[i] = (int)round(proportion * totalGreenPool);
         
         if (allocated[i] < minGreen) allocated[i] = minGreen;
@@ -146,197 +265,239 @@ void computeAllocation() {
   }
  
   // Debug output
-  Serial.println("\n--- Time Allocation Based on Traffic Density ---");
-  Serial.print("Total Vehicles Detected: ");
-  Serial.println(totalVehicles);
+  LOG(LOG_ALLOCATION_HEADER, totalRate);
   
   for (int i=0; i<numRoads; i++) {
-    Serial.print("Road ");
-    Serial.print(char('A' + i));
-    Serial.print(": ");
-    Serial.print(vehicleCount[i]);
-    Serial.print(" vehicles");
-    
-    if (totalVehicles > 0) {
-      float percentage = ((float)vehicleCount[i] / (float)totalVehicles) * 100.0;
-      Serial.print(" (");
-      Serial.print((int)percentage);
-      Serial.print("%)");
+    if (totalDemand > 0) {
+      float percentage = ((float)demand[i] / (float)totalDemand) * 100.0;
+      LOG(LOG_ALLOCATION_ROAD, char('A' + i), rate[i], laneDemand[i].queue, (int)percentage,
+          allocated[i]);
+    } else {
+      LOG(LOG_ALLOCATION_EQUAL, char('A' + i), rate[i], allocated[i]);
     }
-    
-    Serial.print(" → ");
-    Serial.print(allocated[i]);
-    Serial.println(" seconds green");
   }
-  Serial.println("-----------------------------------------------");
+  LOG(LOG_ALLOCATION_FOOTER);
+}
+
+// Show `light` on road `active` and red on every other road, all at once
+void setLights(int active, int light) {
+  uint16_t bits = 0;
+  for (int i=0; i<numRoads; i++) {
+    bits |= 1 << (3 * i + (i == active ? light : lightRed));
+  }
+  TrafficLights::write(bits);
 }
 
 // Turn all roads red
 void allRed() {
-  for (int i=0; i<numRoads; i++) {
-    digitalWrite(lightPins[i][0], HIGH);  // RED ON
-    digitalWrite(lightPins[i][1], LOW);   // YELLOW OFF
-    digitalWrite(lightPins[i][2], LOW);   // GREEN OFF
+  setLights(-1, lightRed);
+}
+
+// Length of a phase in microseconds
+unsigned long phaseLengthUs(uint8_t p, int road) {
+  switch (p) {
+    case PHASE_ALL_RED:   return allRedMs * 1000UL;
+    case PHASE_YELLOW:    return yellowTime * 1000000UL;
+    case PHASE_GREEN:     return allocated[road] * 1000000UL;
+    case PHASE_CLEARANCE: return clearanceMs * 1000UL;
   }
+  return 0;
 }
 
-void loop() {
-  Serial.println("\n========== NEW TRAFFIC CYCLE ==========");
-  
-  // Compute allocation based on vehicle counts from previous cycle
-  // (First cycle will use count of 0 for all, distributing time equally)
-  computeAllocation();
-  
-  // Start with all roads RED
-  Serial.println("All roads: RED - Continuous vehicle counting active...\n");
-  allRed();
-  delay(1000);
-  
-  // Run traffic cycle for each road
-  for (int r=0; r<numRoads; r++) {
-    int greenTime = allocated[r];
-    
-    Serial.println("\n----------------------------");
-    Serial.print("Road ");
-    Serial.print(char('A' + r));
-    Serial.println("'s Turn:");
-    
-    Serial.print("Vehicle counts for NEXT cycle: ");
-    for (int i=0; i<numRoads; i++) {
-      Serial.print(char('A' + i));
-      Serial.print("=");
-      Serial.print(vehicleCount[i]);
-      Serial.print(i < numRoads-1 ? ", " : "\n");
-    }
-    
-    // Calculate wait times for each road
-    int waitTimes[numRoads];
-    for (int i=0; i<numRoads; i++) {
-      if (i == r) {
-        waitTimes[i] = greenTime; // Current road shows its green countdown
-      } else if (i > r) {
-        // Roads ahead in queue
-        int wait = greenTime + yellowTime;
-        for (int j=r+1; j<i; j++) {
-          wait += allocated[j] + yellowTime;
-        }
-        waitTimes[i] = wait;
+// The phase after (p, road): yellow, green and clearance for each road in
+// turn, then all red while the next cycle is planned
+void nextPhase(uint8_t &p, int &road) {
+  switch (p) {
+    case PHASE_ALL_RED:   p = PHASE_YELLOW; road = 0; break;
+    case PHASE_YELLOW:    p = PHASE_GREEN; break;
+    case PHASE_GREEN:     p = PHASE_CLEARANCE; break;
+    case PHASE_CLEARANCE:
+      if (++road < numRoads) {
+        p = PHASE_YELLOW;
       } else {
-        // Roads that already passed - wait for full cycle
-        int wait = greenTime + yellowTime;
-        for (int j=r+1; j<numRoads; j++) {
-          wait += allocated[j] + yellowTime;
-        }
-        for (int j=0; j<i; j++) {
-          wait += allocated[j] + yellowTime;
-        }
-        waitTimes[i] = wait;
+        p = PHASE_ALL_RED;
+        road = -1;
       }
-    }
-    
-    Serial.print("Wait times: ");
-    for (int i=0; i<numRoads; i++) {
-      Serial.print(char('A' + i));
-      Serial.print("=");
-      Serial.print(waitTimes[i]);
-      Serial.print("s");
-      Serial.print(i < numRoads-1 ? ", " : "\n");
-    }
-    
-    // PHASE 1: YELLOW
-    Serial.print("Road ");
-    Serial.print(char('A' + r));
-    Serial.println(": YELLOW (2s)");
-    
-    for (int i=0; i<numRoads; i++) {
-      if (i == r) {
-        digitalWrite(lightPins[i][0], LOW);
-        digitalWrite(lightPins[i][1], HIGH);
-        digitalWrite(lightPins[i][2], LOW);
-      } else {
-        digitalWrite(lightPins[i][0], HIGH);
-        digitalWrite(lightPins[i][1], LOW);
-        digitalWrite(lightPins[i][2], LOW);
-      }
-    }
-    
-    // Yellow phase with continuous counting
-    unsigned long startTime = millis();
-    while (millis() - startTime < yellowTime * 1000) {
-      updateVehicleCounts();
-      // Update displays every 100ms
-      static unsigned long lastDisplayUpdate = 0;
-      if (millis() - lastDisplayUpdate > 100) {
-        lastDisplayUpdate = millis();
-        for (int i=0; i<numRoads; i++) {
-          showNumberTM(i, waitTimes[i]); // Show wait time
-        }
+      break;
+  }
+}
+
+// Seconds until a road's green starts, or the green left on the active
+// road. Later cycles are assumed to keep the current allocation.
+int secondsUntilGreen(int road) {
+  unsigned long elapsed = micros() - phaseStart;
+  unsigned long us = elapsed < phaseLength ? phaseLength - elapsed : 0;
+  uint8_t p = phase;
+  int r = phaseRoad;
+  if (!(p == PHASE_GREEN && r == road)) {
+    do {
+      nextPhase(p, r);
+      if (p == PHASE_GREEN && r == road) {
+        break;
       }
-    }
-    
-    // Decrement wait times after yellow
-    for (int i=0; i<numRoads; i++) {
-      waitTimes[i] -= yellowTime;
-      if (waitTimes[i] < 0) waitTimes[i] = 0;
-    }
-    
-    // PHASE 2: GREEN
-    Serial.print("Road ");
-    Serial.print(char('A' + r));
-    Serial.print(": GREEN (");
-    Serial.print(greenTime);
-    Serial.println("s) - Counting continues on all roads...");
-    
-    for (int i=0; i<numRoads; i++) {
-      if (i == r) {
-        digitalWrite(lightPins[i][0], LOW);
-        digitalWrite(lightPins[i][1], LOW);
-        digitalWrite(lightPins[i][2], HIGH);
-      } else {
-        digitalWrite(lightPins[i][0], HIGH);
-        digitalWrite(lightPins[i][1], LOW);
-        digitalWrite(lightPins[i][2], LOW);
+      us += phaseLengthUs(p, r);
+    } while (true);
+  }
+  return (us + 999999UL) / 1000000UL;
+}
+
+// Switch the lights and log on entering the current phase
+void enterPhase() {
+  int r = phaseRoad;
+  switch (phase) {
+    case PHASE_ALL_RED:
+      if (cycleCount++ > 0) {
+        LOG(LOG_CYCLE_END, vehicleCount[0], vehicleCount[1], vehicleCount[2], vehicleCount[3],
+            cycleMaxLateUs);
       }
+      cycleMaxLateUs = 0;
+      LOG(LOG_CYCLE_START);
+      // Compute allocation based on vehicle counts from previous cycle
+      // (First cycle will use count of 0 for all, distributing time equally)
+      computeAllocation();
+      LOG(LOG_ALL_RED);
+      allRed();
+      break;
+
+    case PHASE_YELLOW:
+      LOG(LOG_ROAD_TURN, char('A' + r));
+      LOG(LOG_NEXT_COUNTS, laneDemand[0].queue, laneDemand[1].queue, laneDemand[2].queue,
+          laneDemand[3].queue);
+      LOG(LOG_WAIT_TIMES, secondsUntilGreen(0), secondsUntilGreen(1), secondsUntilGreen(2),
+          secondsUntilGreen(3));
+      LOG(LOG_YELLOW, char('A' + r), yellowTime);
+      setLights(r, lightYellow);
+      break;
+
+    case PHASE_GREEN:
+      LOG(LOG_GREEN, char('A' + r), (int)(phaseLength / 1000000UL));
+      setLights(r, lightGreen);
+      break;
+
+    case PHASE_CLEARANCE:
+      LOG(LOG_GREEN_TO_RED, char('A' + r));
+      allRed();
+      break;
+  }
+}
+
+// Advance the phase once its deadline has passed. Each phase is timed from
+// the previous deadline, so a late switch doesn't stretch the cycle.
+void runController() {
+  unsigned long elapsed = micros() - phaseStart;
+  if (elapsed < phaseLength) {
+    return;
+  }
+  unsigned long lateUs = elapsed - phaseLength;
+  profileRecord(profPhaseLate, lateUs * PROFILE_TICKS_PER_US);
+  if (lateUs > cycleMaxLateUs) cycleMaxLateUs = lateUs;
+
+  if (phase == PHASE_GREEN) {
+    demandServed(laneDemand[phaseRoad], phaseLength / 1000);
+    lastGreenEnd[phaseRoad] = millis();
+    if (phaseEndedByHand) {
+      LOG(LOG_MANUAL_END, char('A' + phaseRoad), phaseLength / 1000000UL);
+#if ACTUATED_CONTROL
+    } else if (phaseLength >= maxGreen * 1000000UL) {
+      LOG(LOG_MAX_OUT, char('A' + phaseRoad), maxGreen);
+    } else {
+      LOG(LOG_GAP_OUT, char('A' + phaseRoad), phaseLength / 1000000UL);
+#endif
     }
-    
-    // Green phase with countdown timer and continuous counting
-    for (int sec = greenTime; sec >= 1; sec--) {
-      unsigned long secStart = millis();
-      
-      // Show countdown on green road, wait time on red roads
-      for (int i=0; i<numRoads; i++) {
-        showNumberTM(i, waitTimes[i]);
-      }
-      
-      // Continue counting while showing timers
-      while (millis() - secStart < 1000) {
-        updateVehicleCounts();
-        delay(50); // Small delay to avoid overwhelming the sensors
-      }
-      
-      // Decrement all wait times
-      for (int i=0; i<numRoads; i++) {
-        waitTimes[i]--;
-        if (waitTimes[i] < 0) waitTimes[i] = 0;
-      }
+    phaseEndedByHand = false;
+  }
+  phaseStart += phaseLength;
+#if ACTUATED_CONTROL
+  if (phase == PHASE_ALL_RED && !anyoneWaiting()) {
+    return;  // rest in all red until a vehicle shows up
+  }
+#endif
+  nextPhase(phase, phaseRoad);
+#if ACTUATED_CONTROL
+  while (phase == PHASE_YELLOW && !roadWaiting(phaseRoad)) {
+    LOG(LOG_SKIPPED, char('A' + phaseRoad));
+    phase = PHASE_CLEARANCE;  // as if its turn were over
+    nextPhase(phase, phaseRoad);
+  }
+#endif
+  phaseLength = phaseLengthUs(phase, phaseRoad);
+#if ACTUATED_CONTROL
+  if (phase == PHASE_GREEN) {
+    phaseLength = initialGreenUs(phaseRoad);
+  }
+#endif
+  enterPhase();
+}
+
+#if ACTUATED_CONTROL
+// A road is served when vehicles are counted on it, and anyway once it has
+// been red for recallMs: the sensor misses some, and a missed vehicle
+// must not wait for the next one to be counted
+bool roadWaiting(int road) {
+  return laneDemand[road].queue > 0 || millis() - lastGreenEnd[road] >= recallMs;
+}
+
+bool anyoneWaiting() {
+  for (int i=0; i<numRoads; i++) {
+    if (roadWaiting(i)) {
+      return true;
     }
-    
-    // PHASE 3: Back to RED
-    Serial.print("Road ");
-    Serial.print(char('A' + r));
-    Serial.println(": GREEN -> RED");
-    
-    allRed();
-    delay(500);
   }
-  
-  Serial.println("\n========== CYCLE COMPLETE ==========");
-  Serial.println("Vehicle counts will be used for NEXT cycle allocation");
-  Serial.print("Current counts: ");
+  return false;
+}
+
+// An actuated green starts long enough to clear the estimated queue plus
+// countMarginPct for the vehicles the sensor missed (at least minGreen);
+// vehicles arriving during it extend it from there
+unsigned long initialGreenUs(int road) {
+  unsigned long ms = demandClearMs(laneDemand[road]) +
+                     laneDemand[road].queue * DEMAND_HEADWAY_MS * countMarginPct / 100;
+  if (ms < minGreen * 1000UL) ms = minGreen * 1000UL;
+  if (ms > maxGreen * 1000UL) ms = maxGreen * 1000UL;
+  return ms * 1000UL;
+}
+
+// A vehicle on the green road: it joined the back of the queue, so hold
+// the green until the queue it joined has cleared, and at least gapOutMs
+// after it, up to maxGreen
+void extendGreen() {
+  unsigned long elapsed = micros() - phaseStart;
+  if (elapsed >= phaseLength) {
+    return;  // already over (e.g. ended early)
+  }
+  unsigned long until = elapsed + gapOutMs * 1000UL;
+  if (until < initialGreenUs(phaseRoad)) until = initialGreenUs(phaseRoad);
+  if (until > maxGreen * 1000000UL) until = maxGreen * 1000000UL;
+  if (until > phaseLength) phaseLength = until;
+}
+#endif
+
+// End the current phase now (e.g. a green nobody is using); the next one
+// starts on the following runController()
+void endPhaseNow() {
+  phaseLength = micros() - phaseStart;
+}
+
+// Show each road's countdown, writing only the displays whose number changed
+void updateDisplays() {
+  if (millis() - lastDisplayUpdate < displayPeriodMs) {
+    return;
+  }
+  lastDisplayUpdate = millis();
   for (int i=0; i<numRoads; i++) {
-    Serial.print(char('A' + i));
-    Serial.print("=");
-    Serial.print(vehicleCount[i]);
-    Serial.print(i < numRoads-1 ? ", " : "\n");
+    int seconds = secondsUntilGreen(i);
+    if (seconds != shownSeconds[i]) {
+      shownSeconds[i] = seconds;
+      showNumberTM(i, seconds);
+    }
   }
 }
+
+// Independent tasks, none of which waits: sensing paces itself, the
+// controller acts on phase deadlines, displays refresh on their own period
+void loop() {
+  updateVehicleCounts();
+  runController();
+  updateDisplays();
+  serviceSerial();
+}
@@ -0,0 +1,60 @@
+// Wait-free single-producer/single-consumer ring for handing structs from
+// one task to another, including across the ESP32's two cores
+//
+//   SpscQueue<GasSample, 16> samples;
+//   producer task:  if (!samples.push(s)) drops++;
+//   consumer task:  while (samples.pop(s)) { ... }
+//
+// Exactly one task may push and exactly one task may pop. Neither side
+// blocks or takes a lock: push() fails when the ring is full and pop() when
+// it is empty, each after a fixed handful of instructions.
+//
+// head and tail are free-running counters, each written by one side only.
+// The producer copies the item in and then publishes it by storing head with
+// release ordering; the consumer's acquire load of head therefore sees the
+// whole item. Freeing a slot works the same way with tail in the other
+// direction. Size must be a power of two.
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+
+template <typename T, uint16_t Size> struct SpscQueue {
+  static_assert(Size > 0 && (Size & (Size - 1)) == 0, "SpscQueue size must be a power of two");
+
+  T items[Size];
+  std::atomic<uint16_t> head;   // next slot to fill, written by push() only
+  std::atomic<uint16_t> tail;   // next slot to take, written by pop() only
+
+  SpscQueue() : head(0), tail(0) {}
+
+  // Producer side. Returns false (and copies nothing) when full.
+  bool push(const T &item) {
+    uint16_t h = head.load(std::memory_order_relaxed);
+    if ((uint16_t)(h - tail.load(std::memory_order_acquire)) >= Size) {
+      return false;
+    }
+    items[h & (Size - 1)] = item;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Returns false when empty.
+  bool pop(T &item) {
+    uint16_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) {
+      return false;
+    }
+    item = items[t & (Size - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Items waiting; exact from either side's own task, a snapshot elsewhere
+  uint16_t count() const {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+  }
+};
+
+#endif
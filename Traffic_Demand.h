@@ -0,0 +1,101 @@
+// Recent demand on one approach of the intersection: the arrival rate
+// over a sliding window, and an estimate of the queue at the light
+//
+//   TrafficDemand lane;  demandBegin(lane, now);
+//   each detected vehicle:     demandArrival(lane, now);
+//   when its green ends:       demandServed(lane, greenMs);
+//   demandRatePerHour(lane, now), lane.queue
+//
+// Arrivals are counted in a ring of DEMAND_BUCKETS buckets of
+// DEMAND_BUCKET_MS each, so memory is fixed and old traffic falls out of
+// the window as time moves on. The rate is the arrivals in the ring over
+// the time it covers (at least one bucket, so a single early car doesn't
+// read as a flood).
+//
+// Every arrival joins the queue. A green serves nobody for the first
+// DEMAND_STARTUP_MS (drivers reacting), then one vehicle per
+// DEMAND_HEADWAY_MS, the saturation flow of one lane. What's left waits
+// for the next green.
+
+#ifndef TRAFFIC_DEMAND_H
+#define TRAFFIC_DEMAND_H
+
+#ifndef DEMAND_BUCKETS
+#define DEMAND_BUCKETS 10
+#endif
+#ifndef DEMAND_BUCKET_MS
+#define DEMAND_BUCKET_MS 30000UL   // window: 10 x 30 s = 5 minutes
+#endif
+#ifndef DEMAND_HEADWAY_MS
+#define DEMAND_HEADWAY_MS 2000UL   // one vehicle through the stop line per 2 s of green
+#endif
+#ifndef DEMAND_STARTUP_MS
+#define DEMAND_STARTUP_MS 2000UL   // start-up lost time at the beginning of a green
+#endif
+
+struct TrafficDemand {
+  uint16_t buckets[DEMAND_BUCKETS];   // arrivals per bucket
+  uint8_t current;                    // bucket being filled
+  uint8_t full;                       // buckets before it that count (until the ring fills)
+  unsigned long bucketStart;          // millis() the current bucket began
+  uint16_t queue;                     // vehicles estimated waiting
+};
+
+inline void demandBegin(TrafficDemand &d, unsigned long now) {
+  memset(&d, 0, sizeof(d));
+  d.bucketStart = now;
+}
+
+// Move the window up to now, emptying the buckets it enters
+inline void demandRoll(TrafficDemand &d, unsigned long now) {
+  for (uint8_t i = 0; now - d.bucketStart >= DEMAND_BUCKET_MS; i++) {
+    if (i == DEMAND_BUCKETS) {
+      d.bucketStart = now;   // idle longer than the window: nothing left in it
+      break;
+    }
+    d.current = (d.current + 1) % DEMAND_BUCKETS;
+    d.buckets[d.current] = 0;
+    d.bucketStart += DEMAND_BUCKET_MS;
+    if (d.full < DEMAND_BUCKETS - 1) {
+      d.full++;
+    }
+  }
+}
+
+inline void demandArrival(TrafficDemand &d, unsigned long now) {
+  demandRoll(d, now);
+  if (d.buckets[d.current] < 0xFFFF) {
+    d.buckets[d.current]++;
+  }
+  if (d.queue < 0xFFFF) {
+    d.queue++;
+  }
+}
+
+// A green of greenMs has ended: take off the vehicles it could clear
+inline void demandServed(TrafficDemand &d, unsigned long greenMs) {
+  unsigned long served =
+    greenMs > DEMAND_STARTUP_MS ? (greenMs - DEMAND_STARTUP_MS) / DEMAND_HEADWAY_MS : 0;
+  d.queue = served >= d.queue ? 0 : d.queue - served;
+}
+
+// Green needed to clear the queue as it stands
+inline unsigned long demandClearMs(const TrafficDemand &d) {
+  return DEMAND_STARTUP_MS + d.queue * DEMAND_HEADWAY_MS;
+}
+
+inline uint16_t demandRatePerHour(TrafficDemand &d, unsigned long now) {
+  demandRoll(d, now);
+  uint32_t arrivals = 0;
+  for (uint8_t i = 0; i < DEMAND_BUCKETS; i++) {
+    arrivals += d.buckets[i];
+  }
+  uint32_t spanMs = d.full * DEMAND_BUCKET_MS + (now - d.bucketStart);
+  if (spanMs < DEMAND_BUCKET_MS) {
+    spanMs = DEMAND_BUCKET_MS;
+  }
+  uint32_t rate = arrivals * 3600UL / (spanMs / 1000);
+  return rate > 0xFFFF ? 0xFFFF : rate;
+}
+
+#endif
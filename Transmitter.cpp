@@ -1,12 +1,18 @@
-#include <DHT.h>
+#include "DHT11_Async.h"
+#include "Gas_Link_Protocol.h"
+#include "Gas_Adc_Sampler.h"
+#include "Gas_Sample_Log.h"
+#include "Gas_Calibration.h"
+#include "Gas_Baseline.h"
+#include "Gas_Report_Policy.h"
 
 // Pin definitions
 #define DHTPIN 27        // DHT11 sensor pin
-#define DHTTYPE DHT11
 #define RXD2 16          // UART receive pin
 #define TXD2 17          // UART transmit pin
 #define STATUS_LED 2     // Power/status indicator LED
 #define TRANSMIT_LED 4   // Data transmission indicator LED
+#define NODE_ID 0        // Unique per sensor pod when several share the receiver bus
 
 // Sensor analog pins
 #define MQ7_PIN 35       // Carbon Monoxide sensor
@@ -14,16 +20,89 @@
 #define MQ135_PIN 32     // Air quality/H2S sensor
 #define O2_PIN 33        // Oxygen sensor
 
+// Background ADC channels: {pin, oversample bits, smoothing shift}
+// 4 oversample bits = 256 samples per output (~20 Hz at 5 kHz) with 4 extra bits
+const AdcChannelConfig adcChannels[ADC_SAMPLER_CHANNELS] = {
+  {MQ7_PIN,   4, 2},
+  {MQ5_PIN,   4, 2},
+  {MQ135_PIN, 4, 2},
+  {O2_PIN,    4, 3},  // O2 changes slowly, smooth harder
+};
+
+// Clean-air ADC counts that set each MQ sensor's R0 (Gas_Calibration.h).
+// Measure your own: read the sensors outdoors after a full warmup.
+#define MQ7_CLEAN_AIR_ADC 350
+#define MQ5_CLEAN_AIR_ADC 2700
+#define MQ135_CLEAN_AIR_ADC 150
+
 // Calibration constants (for documentation - receiver does actual calibration)
 #define O2_CALIBRATION_FACTOR 0.087  // To be matched with receiver: converts raw ADC to percentage
 #define O2_ZERO_OFFSET 0             // Baseline offset for O2 sensor
-#define WARMUP_TIME_MS 60000        // 60 seconds warmup for MQ sensors
+#define WARMUP_TIME_MS 60000        // longest MQ warmup; sooner if the saved baseline matches
+
+// Pipeline timing: sample -> filter -> transmit, connected by bounded queues
+#define SAMPLE_PERIOD_MS 100        // acquisition cadence
+#define DHT_PERIOD_MS 2000          // DHT11 can't be read faster than ~1 Hz
+#define BASELINE_TRACK_MS 3000      // baseline learning cadence (Gas_Baseline.h)
+#define SAMPLE_QUEUE_LEN 8
+#define TX_QUEUE_LEN 4
+#define STATS_INTERVAL_MS 30000     // pipeline health report on debug Serial
+
+// Store-and-forward: samples the receiver doesn't acknowledge go to the
+// flash log and are replayed in BATCH frames once acknowledgements return
+#define ACK_TIMEOUT_MS 1000         // ACK round trip is ~30 ms at 9600 baud
+#define DRAIN_INTERVAL_MS 250       // batch cadence while catching up (5 records, 20 samples/s)
+
+// Latest DHT11 result, from climateTask
+struct ClimateReading {
+  float temperature;  // NAN when the last DHT read failed
+  float humidity;
+};
+
+// One acquisition, timestamped when it was taken
+struct SensorReading {
+  unsigned long timestamp;
+  uint16_t gas[ADC_SAMPLER_CHANNELS];
+  float temperature;  // NAN when the last DHT read failed
+  float humidity;
+};
 
 // Global variables
-DHT dht(DHTPIN, DHTTYPE);
 unsigned long startTime;
 int transmissionCount = 0;
-bool sensorsWarmedUp = false;
+volatile bool sensorsWarmedUp = false;
+bool warmedEarly = false;         // readings matched the saved baseline
+unsigned long warmupMs = 0;
+bool readyAnnounced = false;
+GasBaseline baseline;             // owned by filterTask once it runs
+ReportPolicy reportPolicy;        // owned by filterTask
+GasLinkReader linkReader;   // requests and ACKs from the receiver
+GasSensor mq7Sensor = {&GAS_CURVE_MQ7, 0};
+GasSensor mq5Sensor = {&GAS_CURVE_MQ5, 0};
+GasSensor mq135Sensor = {&GAS_CURVE_MQ135, 0};
+uint32_t timeSyncReplies = 0;
+
+// Store-and-forward state, owned by transmitTask
+bool linkUp = false;              // last frame we needed acknowledged was
+GasLinkRecord unacked;            // live sample waiting for its ACK
+bool awaitingAck = false;
+unsigned long unackedSentAt = 0;
+uint16_t batchSeq = 0;
+uint8_t batchCount = 0;           // records in the batch waiting for its ACK, 0 = none
+unsigned long batchSentAt = 0;
+uint32_t samplesLogged = 0, samplesReplayed = 0;
+
+QueueHandle_t sampleQueue;
+QueueHandle_t txQueue;
+QueueHandle_t climateQueue;       // one slot, overwritten by each DHT11 read
+
+// Pipeline health counters
+volatile uint32_t sampleDeadlineMisses = 0;  // sample task woke up late
+volatile uint32_t sampleDrops = 0;           // filter stage fell behind
+volatile uint32_t txDrops = 0;               // UART stage fell behind
+volatile UBaseType_t sampleQueuePeak = 0, txQueuePeak = 0;
+volatile unsigned long maxPipelineLatency = 0;  // acquisition -> on the wire
+unsigned long lastStatsPrint = 0;
 
 void setup() {
   Serial.begin(115200);   
@@ -34,100 +113,379 @@ void setup() {
   pinMode(TRANSMIT_LED, OUTPUT);
   
   // Initialize sensors
-  dht.begin();
+  dht11Begin(DHTPIN);
+  gasSensorBegin(mq7Sensor, MQ7_CLEAN_AIR_ADC);
+  gasSensorBegin(mq5Sensor, MQ5_CLEAN_AIR_ADC);
+  gasSensorBegin(mq135Sensor, MQ135_CLEAN_AIR_ADC);
+  if (gasBaselineBegin(baseline)) {
+    Serial.printf("Saved baseline MQ7:%u MQ5:%u MQ135:%u - ready as soon as the sensors match it\n",
+                  baseline.adc[0], baseline.adc[1], baseline.adc[2]);
+  } else {
+    Serial.println("No saved baseline - full warmup this time");
+  }
+  if (!adcSamplerBegin(adcChannels)) {
+    Serial.println("❌ ADC continuous mode failed to start!");
+  }
+  if (!sampleLogBegin()) {
+    Serial.println("❌ LittleFS mount failed - no buffering during link outages!");
+  } else if (sampleLogCount() > 0) {
+    Serial.printf("Sample log: %lu samples from before the restart to replay\n",
+                  (unsigned long)sampleLogCount());
+  }
   startTime = millis();
   
   digitalWrite(STATUS_LED, HIGH);  // Power indicator
+
+  // Start the pipeline: acquisition and filtering on core 1, UART on core 0
+  sampleQueue = xQueueCreate(SAMPLE_QUEUE_LEN, sizeof(SensorReading));
+  txQueue = xQueueCreate(TX_QUEUE_LEN, sizeof(GasSample));
+  climateQueue = xQueueCreate(1, sizeof(ClimateReading));
+  xTaskCreatePinnedToCore(sampleTask, "sample", 4096, NULL, 3, NULL, 1);
+  xTaskCreatePinnedToCore(climateTask, "climate", 2048, NULL, 4, NULL, 1);
+  xTaskCreatePinnedToCore(filterTask, "filter", 4096, NULL, 2, NULL, 1);
+  xTaskCreatePinnedToCore(transmitTask, "transmit", 4096, NULL, 2, NULL, 0);
   
   Serial.println("=== Gas Sensor Transmitter Started ===");
   Serial.println("Role: Data collection and transmission only");
-  Serial.println("Warming up MQ sensors for 60 seconds...");
+  Serial.println("Warming up MQ sensors (up to 60 seconds, samples flagged as warming)...");
 }
 
+// loop() only does housekeeping; the pipeline tasks do the real work
 void loop() {
-  // Check if sensors are still warming up
+  // Check if sensors are still warming up (the filter stage decides when they're done)
   if (!sensorsWarmedUp) {
     if (millis() - startTime < WARMUP_TIME_MS) {
       unsigned long remaining = (WARMUP_TIME_MS - (millis() - startTime)) / 1000;
       if (remaining % 10 == 0 || remaining < 10) {
-        Serial.println("Sensors warming up... " + String(remaining) + "s remaining");
+        Serial.println("Sensors warming up... at most " + String(remaining) + "s remaining");
       }
-      // Blink status LED during warmup
-      digitalWrite(STATUS_LED, (millis() / 500) % 2);
-      delay(1000);
-      return;
-    } else {
-      sensorsWarmedUp = true;
-      digitalWrite(STATUS_LED, HIGH);
-      Serial.println("✓ Sensors ready! Starting data transmission...");
     }
+    // Blink status LED during warmup
+    digitalWrite(STATUS_LED, (millis() / 500) % 2);
+  } else if (!readyAnnounced) {
+    readyAnnounced = true;
+    digitalWrite(STATUS_LED, HIGH);
+    Serial.printf("✓ Sensors ready after %lus (%s)\n", warmupMs / 1000,
+                  warmedEarly ? "matched the saved baseline" : "full warmup, new baseline saved");
+  }
+
+  if (millis() - lastStatsPrint >= STATS_INTERVAL_MS) {
+    lastStatsPrint = millis();
+    printPipelineStats();
   }
   
-  // Read and transmit sensor data
-  readAndTransmitData();
-  
-  delay(3000);
+  delay(1000);
 }
 
-void readAndTransmitData() {
-  // Read DHT sensor
-  float temperature = dht.readTemperature();
-  float humidity = dht.readHumidity();
-  
-  // Handle DHT errors
-  if (isnan(temperature) || isnan(humidity)) {
-    Serial.println("DHT sensor error - sending error values");
-    temperature = -999;
-    humidity = -999;
+// Stage 1 (core 1): take a timestamped reading every SAMPLE_PERIOD_MS
+void sampleTask(void *) {
+  TickType_t lastWake = xTaskGetTickCount();
+  ClimateReading climate = {NAN, NAN};
+
+  for (;;) {
+    if (xTaskDelayUntil(&lastWake, pdMS_TO_TICKS(SAMPLE_PERIOD_MS)) == pdFALSE) {
+      sampleDeadlineMisses++;  // previous iteration overran its slot
+    }
+
+    SensorReading reading;
+    reading.timestamp = millis();
+    adcSamplerPoll();
+    for (int ch = 0; ch < ADC_SAMPLER_CHANNELS; ch++) {
+      reading.gas[ch] = adcSamplerRead(ch);
+    }
+
+    xQueuePeek(climateQueue, &climate, 0);   // the last DHT11 values until the next read
+    reading.temperature = climate.temperature;
+    reading.humidity = climate.humidity;
+
+    if (xQueueSend(sampleQueue, &reading, 0) != pdTRUE) {
+      sampleDrops++;
+    }
+    UBaseType_t depth = uxQueueMessagesWaiting(sampleQueue);
+    if (depth > sampleQueuePeak) sampleQueuePeak = depth;
   }
-  
-  // Read gas sensors (average of 3 readings for stability)
-  int mq7 = getStableReading(MQ7_PIN);
-  int mq5 = getStableReading(MQ5_PIN);
-  int mq135 = getStableReading(MQ135_PIN);
-  int o2raw = getStableReading(O2_PIN);  // Send RAW value only
-  
-  // Create data string ->> Send O2 raw value only, Receiver will calculate percentage
-  char dataBuffer[200];
-  snprintf(dataBuffer, sizeof(dataBuffer),
-           "Temp:%.1f,Humidity:%.1f,MQ7:%d,MQ5:%d,MQ135:%d,O2Raw:%d,O2:%.2f",
-           temperature, humidity, mq7, mq5, mq135, o2raw, 0.0);  // O2 percentage = 0 (placeholder)
-  
-  // Transmit data via UART with stability delay
-  delay(50);  // Small delay for UART stability and reduce transmission errors
-  Serial.println("TX #" + String(++transmissionCount) + ": " + String(dataBuffer));
-  Serial2.println(dataBuffer);
-  
-  // Show raw readings (no O2 percentage calculation)
-  Serial.printf("Raw readings - T:%.1f H:%.1f MQ7:%d MQ5:%d MQ135:%d O2_Raw:%d\n", 
-                temperature, humidity, mq7, mq5, mq135, o2raw);
 }
 
-// Get stable analog reading (average of 3 samples)
-int getStableReading(int pin) {
-  int sum = 0;
-  for (int i = 0; i < 3; i++) {
-    sum += analogRead(pin);
-    delay(10);
+// Stage 1b (core 1): read the DHT11 every DHT_PERIOD_MS. Sleeping until
+// each step of the read is due keeps the start signal at DHT11_START_LOW_MS
+// instead of a whole sample period.
+void climateTask(void *) {
+  TickType_t lastWake = xTaskGetTickCount();
+  for (;;) {
+    dht11Start();
+    while (!dht11Poll()) {
+      vTaskDelay(pdMS_TO_TICKS(dht11WaitMs()));
+    }
+    bool ok = dht11.lastResult == DHT11_OK;
+    ClimateReading climate = {ok ? dht11.temperature : NAN, ok ? dht11.humidity : NAN};
+    xQueueOverwrite(climateQueue, &climate);
+    xTaskDelayUntil(&lastWake, pdMS_TO_TICKS(DHT_PERIOD_MS));
   }
-  return sum / 3;
+}
+
+// Pack gas readings into a link sample ->> O2 is sent RAW, Receiver will calculate percentage
+void makeSample(GasSample &sample, const SensorReading &reading, const uint16_t *gas) {
+  sample.timestamp = reading.timestamp;
+  sample.flags = GAS_FLAG_HAS_O2;
+  sample.temperature = 0;
+  sample.humidity = 0;
+  if (!isnan(reading.temperature) && !isnan(reading.humidity)) {
+    sample.temperature = (int16_t)round(reading.temperature * 10);
+    sample.humidity = (int16_t)round(reading.humidity * 10);
+    sample.flags |= GAS_FLAG_HAS_CLIMATE;
+  }
+  if (!sensorsWarmedUp) {
+    sample.flags |= GAS_FLAG_WARMING;  // the receiver shows these but holds its alarms
+  }
+  sample.mq7 = gas[ADC_CH_MQ7];
+  sample.mq5 = gas[ADC_CH_MQ5];
+  sample.mq135 = gas[ADC_CH_MQ135];
+  sample.o2raw = gas[ADC_CH_O2];
+  sample.mq7Ppm = gasSensorPpm(mq7Sensor, sample.mq7);
+  sample.mq5Ppm = gasSensorPpm(mq5Sensor, sample.mq5);
+  sample.mq135Ppm = gasSensorPpm(mq135Sensor, sample.mq135);
+}
+
+// Stage 2 (core 1): check every reading against the report policy
+// (Gas_Report_Policy.h). A change goes out at once as it was read; a
+// heartbeat carries the average of the readings since the last frame.
+void filterTask(void *) {
+  uint32_t gasSum[ADC_SAMPLER_CHANNELS] = {0};
+  int count = 0;
+  unsigned long lastBaselineTrack = 0;
+  SensorReading reading;
+
+  for (;;) {
+    xQueueReceive(sampleQueue, &reading, portMAX_DELAY);
+    for (int ch = 0; ch < ADC_SAMPLER_CHANNELS; ch++) {
+      gasSum[ch] += reading.gas[ch];
+    }
+    count++;
+    if (!sensorsWarmedUp) {
+      checkWarmup(reading);
+    } else if (reading.timestamp - lastBaselineTrack >= BASELINE_TRACK_MS) {
+      lastBaselineTrack = reading.timestamp;
+      uint16_t mq[GAS_BASELINE_CHANNELS] = {reading.gas[ADC_CH_MQ7], reading.gas[ADC_CH_MQ5],
+                                            reading.gas[ADC_CH_MQ135]};
+      gasBaselineTrack(baseline, mq, reading.timestamp);
+    }
+
+    GasSample sample;
+    makeSample(sample, reading, reading.gas);
+    uint8_t reason = reportCheck(reportPolicy, sample, reading.timestamp);
+    if (reason == REPORT_NONE) {
+      continue;
+    }
+    if (reason == REPORT_HEARTBEAT) {
+      uint16_t average[ADC_SAMPLER_CHANNELS];
+      for (int ch = 0; ch < ADC_SAMPLER_CHANNELS; ch++) {
+        average[ch] = (gasSum[ch] + count / 2) / count;
+      }
+      makeSample(sample, reading, average);
+    }
+    reportSent(reportPolicy, sample, reading.timestamp, reason);
+    for (int ch = 0; ch < ADC_SAMPLER_CHANNELS; ch++) {
+      gasSum[ch] = 0;
+    }
+    count = 0;
+
+    if (xQueueSend(txQueue, &sample, 0) != pdTRUE) {
+      txDrops++;
+    }
+    UBaseType_t depth = uxQueueMessagesWaiting(txQueue);
+    if (depth > txQueuePeak) txQueuePeak = depth;
+  }
+}
+
+// Warm once the readings match the saved baseline, or after the full
+// warmup, whose readings then become the new baseline
+void checkWarmup(const SensorReading &reading) {
+  if (gasBaselineSettled(baseline, reading.gas, reading.timestamp)) {
+    warmedEarly = true;
+  } else if (reading.timestamp - startTime >= WARMUP_TIME_MS) {
+    gasBaselineReset(baseline, reading.gas, reading.timestamp);
+  } else {
+    return;
+  }
+  warmupMs = reading.timestamp - startTime;
+  sensorsWarmedUp = true;
+}
+
+// Stage 3 (core 0): encode and send; UART backpressure only stalls this task.
+// Also owns the UART receive side (clock sync, ACKs) and the flash log.
+void transmitTask(void *) {
+  GasSample s;
+  uint8_t frame[GAS_LINK_MAX_FRAME];
+
+  for (;;) {
+    serviceLinkRequests();
+    checkAckTimeouts();
+    drainBacklog();
+    // Short wait so requests are answered within ~10 ms
+    if (xQueueReceive(txQueue, &s, pdMS_TO_TICKS(10)) != pdTRUE) {
+      continue;
+    }
+    if (awaitingAck) {
+      logUnacked();  // previous sample never acknowledged
+    }
+    size_t frameLen = gasLinkEncodeSample(frame, NODE_ID, (uint16_t)++transmissionCount, s);
+    unacked.seq = (uint16_t)transmissionCount;
+    unacked.sample = s;
+    awaitingAck = true;
+    unackedSentAt = millis();
+
+    digitalWrite(TRANSMIT_LED, HIGH);
+    Serial2.write(frame, frameLen);
+    Serial2.flush();
+    digitalWrite(TRANSMIT_LED, LOW);
+
+    unsigned long latency = millis() - s.timestamp;
+    if (latency > maxPipelineLatency) maxPipelineLatency = latency;
+
+    if (!(s.flags & GAS_FLAG_HAS_CLIMATE)) {
+      Serial.println("DHT sensor error - sending without climate data");
+    }
+    Serial.printf("TX #%d: %u bytes, %lu ms after acquisition\n",
+                  transmissionCount, (unsigned)frameLen, latency);
+    // Show raw readings (no O2 percentage calculation)
+    Serial.printf("Raw readings - T:%.1f H:%.1f MQ7:%d MQ5:%d MQ135:%d O2_Raw:%d\n",
+                  s.temperature / 10.0, s.humidity / 10.0, s.mq7, s.mq5, s.mq135, s.o2raw);
+    Serial.printf("Gas - CO:%u ppm CH4:%u ppm NH3:%u ppm\n", s.mq7Ppm, s.mq5Ppm, s.mq135Ppm);
+  }
+}
+
+// Keep a sample the receiver didn't acknowledge for later replay
+void logUnacked() {
+  awaitingAck = false;
+  sampleLogAppend(unacked);
+  samplesLogged++;
+  if (linkUp) {
+    linkUp = false;
+    Serial.println("Link down - buffering samples to flash");
+  }
+}
+
+void checkAckTimeouts() {
+  if (awaitingAck && millis() - unackedSentAt >= ACK_TIMEOUT_MS) {
+    logUnacked();
+  }
+  if (batchCount > 0 && millis() - batchSentAt >= ACK_TIMEOUT_MS) {
+    batchCount = 0;   // records stay in the log; resend once the link is confirmed again
+    linkUp = false;
+  }
+}
+
+// Replay the backlog, one batch in flight at a time, while the link is up.
+// Live samples keep going out in between.
+void drainBacklog() {
+  if (!linkUp || batchCount > 0 || sampleLogCount() == 0 || millis() - batchSentAt < DRAIN_INTERVAL_MS) {
+    return;
+  }
+  GasLinkRecord records[GAS_BATCH_MAX_RECORDS];
+  uint8_t count = sampleLogPeek(records, GAS_BATCH_MAX_RECORDS);
+  if (count == 0) {
+    return;
+  }
+  uint8_t frame[GAS_LINK_MAX_FRAME];
+  size_t frameLen = gasLinkEncodeBatch(frame, NODE_ID, ++batchSeq, records, count);
+  Serial2.write(frame, frameLen);
+  batchCount = count;
+  batchSentAt = millis();
+}
+
+void handleAck(uint16_t seq, uint8_t ackedType) {
+  if (ackedType == GAS_LINK_TYPE_SAMPLE && awaitingAck && seq == unacked.seq) {
+    awaitingAck = false;
+  } else if (ackedType == GAS_LINK_TYPE_BATCH && batchCount > 0 && seq == batchSeq) {
+    sampleLogConsume(batchCount);
+    samplesReplayed += batchCount;
+    batchCount = 0;
+    if (sampleLogCount() == 0) {
+      Serial.printf("Backlog drained (%lu samples replayed)\n", (unsigned long)samplesReplayed);
+    }
+  } else {
+    return;  // stale or duplicate ACK
+  }
+  if (!linkUp) {
+    linkUp = true;
+    Serial.printf("Link up - %lu samples to replay\n", (unsigned long)sampleLogCount());
+  }
+}
+
+// Handle frames from the receiver: ACKs for our frames, and TIME_REQ, which
+// gets our receive/send times so the receiver can estimate the clock offset
+// (see Gas_Link_Protocol.h)
+void serviceLinkRequests() {
+  uint32_t received = millis();  // within one poll period of the actual arrival
+  while (Serial2.available()) {
+    gasLinkReaderPush(linkReader, Serial2.read());
+  }
+  GasLinkFrame request;
+  GasTimeSync sync;
+  uint8_t ackedType;
+  while (gasLinkReaderNext(linkReader, request)) {
+    // Other nodes' frames share the bus on multi-drop links
+    if (request.node != NODE_ID) {
+      continue;
+    }
+    if (gasLinkDecodeAck(request, ackedType)) {
+      handleAck(request.seq, ackedType);
+      continue;
+    }
+    if (!gasLinkDecodeTimeRequest(request, sync.t0)) {
+      continue;
+    }
+    uint8_t frame[GAS_LINK_MAX_FRAME];
+    sync.t1 = received;
+    sync.t2 = millis();
+    size_t frameLen = gasLinkEncodeTimeResponse(frame, NODE_ID, request.seq, sync);
+    Serial2.write(frame, frameLen);
+    timeSyncReplies++;
+  }
+}
+
+// Queue depths and deadline misses, to spot a stage that can't keep up
+void printPipelineStats() {
+  Serial.println("--- Pipeline stats ---");
+  Serial.printf("Sample queue: %u/%d now, peak %u, %lu dropped\n",
+                (unsigned)uxQueueMessagesWaiting(sampleQueue), SAMPLE_QUEUE_LEN,
+                (unsigned)sampleQueuePeak, (unsigned long)sampleDrops);
+  Serial.printf("TX queue: %u/%d now, peak %u, %lu dropped\n",
+                (unsigned)uxQueueMessagesWaiting(txQueue), TX_QUEUE_LEN,
+                (unsigned)txQueuePeak, (unsigned long)txDrops);
+  Serial.printf("Sample deadline misses: %lu | max acquisition->TX latency: %lu ms\n",
+                (unsigned long)sampleDeadlineMisses, maxPipelineLatency);
+  Serial.printf("Frames sent: %lu on band crossings, %lu on change, %lu heartbeats\n",
+                (unsigned long)reportPolicy.sent[REPORT_CROSSING],
+                (unsigned long)reportPolicy.sent[REPORT_DELTA],
+                (unsigned long)reportPolicy.sent[REPORT_HEARTBEAT]);
+  Serial.printf("Clock sync replies: %lu | link RX frames: %lu, CRC errors: %lu\n",
+                (unsigned long)timeSyncReplies, (unsigned long)linkReader.frames,
+                (unsigned long)linkReader.crcErrors);
+  Serial.printf("Link %s | backlog %lu samples (%lu flash pages), %lu logged, %lu replayed, %lu dropped\n",
+                linkUp ? "UP" : "DOWN", (unsigned long)sampleLogCount(),
+                (unsigned long)sampleLogFlashPages(), (unsigned long)samplesLogged,
+                (unsigned long)samplesReplayed, (unsigned long)sampleLog.dropped);
 }
 
 // Diagnostic function for troubleshooting
 void runDiagnostics() {
   Serial.println("\n=== SENSOR DIAGNOSTICS ===");
   
-  // Test DHT11
-  float t = dht.readTemperature();
-  float h = dht.readHumidity();
-  Serial.printf("DHT11 (pin %d): T=%.1f H=%.1f %s\n", DHTPIN, t, h,
-                (isnan(t) || isnan(h)) ? "❌ FAILED" : "✓ OK");
+  // Test DHT11 (last result of the background reader)
+  Serial.printf("DHT11 (pin %d): T=%.1f H=%.1f %s\n", DHTPIN, dht11.temperature, dht11.humidity,
+                dht11.lastResult != DHT11_OK ? "❌ FAILED" : "✓ OK");
+  Serial.printf("DHT11 reads: %lu, timeouts: %lu, checksum errors: %lu\n",
+                (unsigned long)dht11.reads, (unsigned long)dht11.timeouts,
+                (unsigned long)dht11.checksumErrors);
   
-  // Test analog sensors
-  Serial.printf("MQ7 (pin %d): %d\n", MQ7_PIN, analogRead(MQ7_PIN));
-  Serial.printf("MQ5 (pin %d): %d\n", MQ5_PIN, analogRead(MQ5_PIN));
-  Serial.printf("MQ135 (pin %d): %d\n", MQ135_PIN, analogRead(MQ135_PIN));
-  Serial.printf("O2 (pin %d): %d\n", O2_PIN, analogRead(O2_PIN));
+  // Test analog sensors (pins are owned by the continuous ADC sampler)
+  Serial.printf("ADC sampler: %s, %lu DMA frames\n",
+                adcSamplerReady() ? "✓ OK" : "❌ NO DATA", (unsigned long)adcFrames);
+  Serial.printf("MQ7 (pin %d): %d\n", MQ7_PIN, adcSamplerRead(ADC_CH_MQ7));
+  Serial.printf("MQ5 (pin %d): %d\n", MQ5_PIN, adcSamplerRead(ADC_CH_MQ5));
+  Serial.printf("MQ135 (pin %d): %d\n", MQ135_PIN, adcSamplerRead(ADC_CH_MQ135));
+  Serial.printf("O2 (pin %d): %d\n", O2_PIN, adcSamplerRead(ADC_CH_O2));
   
   Serial.println("=== DIAGNOSTICS COMPLETE ===\n");
 }
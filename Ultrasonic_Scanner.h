@@ -0,0 +1,178 @@
+// Interrupt-driven HC-SR04 scanner: several ultrasonic sensors pinged in
+// turn, their echoes timed by pin-change interrupts
+//
+//   ultrasonicAdd(trigPin, echoPin);          // setup(), once per sensor
+//   loop():  ultrasonicService();              // fires the next ping when due
+//            if (ultrasonicTake(i, cm)) ...    // a new distance from sensor i
+//
+// Only one sensor pings at a time. Each gets a slot of at least
+// ULTRASONIC_CYCLE_MS / sensors: it pings and its echo is timed. An
+// HC-SR04 listens for as long as its echo line is high, and with no target
+// it holds the line for ~38 ms, so the slot also lasts until the echo has
+// ended (up to ULTRASONIC_ECHO_HOLD_MS). Only then does the next sensor
+// fire, so no sensor is still listening when another one pings. With
+// targets in front of them, each sensor pings once per ULTRASONIC_CYCLE_MS
+// (the HC-SR04's shortest measurement cycle); with nothing in range a
+// round of four takes ~155 ms. An echo longer than ULTRASONIC_ECHO_MAX_US
+// (beyond ~4 m) counts as no target.
+//
+// The echo edges are timestamped in an interrupt, so nothing waits in
+// pulseIn(); ultrasonicService() costs a 10 us trigger pulse per slot.
+// On the Mega the echo pins must be on port K (A8-A15), which shares one
+// pin-change interrupt (PCINT2). Elsewhere (ESP32, the simulator) each
+// echo pin gets a CHANGE interrupt.
+
+#ifndef ULTRASONIC_SCANNER_H
+#define ULTRASONIC_SCANNER_H
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+#if defined(__AVR_ATmega2560__) || defined(__AVR_ATmega1280__)
+#define ULTRASONIC_PCINT 1
+#include <avr/interrupt.h>
+#endif
+
+#define ULTRASONIC_MAX 4
+#ifndef ULTRASONIC_CYCLE_MS
+#define ULTRASONIC_CYCLE_MS 60    // per sensor: datasheet minimum between pings
+#endif
+#define ULTRASONIC_ECHO_HOLD_MS 40      // longest a slot waits for the echo to end
+#define ULTRASONIC_ECHO_MAX_US 23500    // ~4 m, the HC-SR04's range
+#define ULTRASONIC_TRIGGER_US 10
+#define ULTRASONIC_US_PER_CM 58   // echo time per cm of distance (there and back)
+
+struct UltrasonicSensor {
+  uint8_t trig, echo;
+  uint8_t echoBit;                 // bit in PINK (Mega)
+  volatile bool inEcho;            // echo line is high
+  volatile unsigned long riseAt;   // micros() of its rising edge
+  volatile unsigned long width;    // echo pulse of the current ping, 0 = none yet
+  uint16_t distance;               // cm of the last ping, 0 = no target
+  bool fresh;                      // distance not taken yet
+};
+
+UltrasonicSensor ultrasonic[ULTRASONIC_MAX];
+uint8_t ultrasonicCount = 0;
+uint8_t ultrasonicActive = 0;      // sensor whose slot is running
+bool ultrasonicPinging = false;
+unsigned long ultrasonicSlotStart = 0;
+uint32_t ultrasonicPings = 0, ultrasonicMisses = 0;   // misses: no target in range
+
+void IRAM_ATTR ultrasonicOnEdge(uint8_t index, bool high, unsigned long now) {
+  UltrasonicSensor &s = ultrasonic[index];
+  if (high) {
+    s.riseAt = now;
+    s.inEcho = true;
+  } else if (s.inEcho) {
+    s.width = now - s.riseAt;
+    s.inEcho = false;
+  }
+}
+
+#if ULTRASONIC_PCINT
+uint8_t ultrasonicPinkLast = 0;
+
+ISR(PCINT2_vect) {
+  unsigned long now = micros();
+  uint8_t pins = PINK;
+  uint8_t changed = pins ^ ultrasonicPinkLast;
+  ultrasonicPinkLast = pins;
+  for (uint8_t i = 0; i < ultrasonicCount; i++) {
+    if (changed & ultrasonic[i].echoBit) {
+      ultrasonicOnEdge(i, pins & ultrasonic[i].echoBit, now);
+    }
+  }
+}
+#else
+// attachInterrupt() handlers take no argument, so one per sensor slot
+template <uint8_t I> void IRAM_ATTR ultrasonicIsr() {
+  ultrasonicOnEdge(I, digitalRead(ultrasonic[I].echo), micros());
+}
+void (*const ultrasonicIsrs[ULTRASONIC_MAX])() = {
+  ultrasonicIsr<0>, ultrasonicIsr<1>, ultrasonicIsr<2>, ultrasonicIsr<3>
+};
+#endif
+
+// Set up a sensor; returns its index (the order of the calls)
+uint8_t ultrasonicAdd(uint8_t trig, uint8_t echo) {
+  uint8_t index = ultrasonicCount;
+  UltrasonicSensor &s = ultrasonic[index];
+  s.trig = trig;
+  s.echo = echo;
+  s.inEcho = false;
+  s.width = 0;
+  s.distance = 0;
+  s.fresh = false;
+  pinMode(trig, OUTPUT);
+  digitalWrite(trig, LOW);
+  pinMode(echo, INPUT);
+#if ULTRASONIC_PCINT
+  s.echoBit = 1 << (echo - A8);
+  ultrasonicPinkLast = PINK;
+  ultrasonicCount = index + 1;
+  PCMSK2 |= s.echoBit;
+  PCICR |= 1 << PCIE2;
+#else
+  s.echoBit = 0;
+  ultrasonicCount = index + 1;
+  attachInterrupt(digitalPinToInterrupt(echo), ultrasonicIsrs[index], CHANGE);
+#endif
+  return index;
+}
+
+// Close the running slot: publish its sensor's distance
+void ultrasonicFinish(UltrasonicSensor &s) {
+  noInterrupts();
+  unsigned long width = s.width;
+  interrupts();
+  if (width == 0 || width > ULTRASONIC_ECHO_MAX_US) {
+    ultrasonicMisses++;
+    width = 0;
+  }
+  s.distance = (width + ULTRASONIC_US_PER_CM / 2) / ULTRASONIC_US_PER_CM;
+  s.fresh = true;
+}
+
+// Call often (every loop); pings the next sensor once the slot is over
+void ultrasonicService() {
+  if (ultrasonicCount == 0) {
+    return;
+  }
+  if (ultrasonicPinging) {
+    unsigned long elapsed = micros() - ultrasonicSlotStart;
+    if (elapsed < ULTRASONIC_CYCLE_MS * 1000UL / ultrasonicCount) {
+      return;
+    }
+    if (ultrasonic[ultrasonicActive].inEcho && elapsed < ULTRASONIC_ECHO_HOLD_MS * 1000UL) {
+      return;   // still listening
+    }
+    ultrasonicFinish(ultrasonic[ultrasonicActive]);
+    ultrasonicActive = (ultrasonicActive + 1) % ultrasonicCount;
+  }
+  UltrasonicSensor &s = ultrasonic[ultrasonicActive];
+  noInterrupts();
+  s.width = 0;
+  interrupts();
+  digitalWrite(s.trig, HIGH);
+  delayMicroseconds(ULTRASONIC_TRIGGER_US);
+  digitalWrite(s.trig, LOW);
+  ultrasonicSlotStart = micros();
+  ultrasonicPinging = true;
+  ultrasonicPings++;
+}
+
+// Take sensor index's distance (cm, 0 = no target) if it has pinged since
+// the last call. Never blocks.
+bool ultrasonicTake(uint8_t index, uint16_t &cm) {
+  UltrasonicSensor &s = ultrasonic[index];
+  if (!s.fresh) {
+    return false;
+  }
+  s.fresh = false;
+  cm = s.distance;
+  return true;
+}
+
+#endif
@@ -0,0 +1,476 @@
+// Simulated Arduino core: virtual clock, GPIO/ADC state, scheduled pin
+// events (interrupt sources, DHT11 model) and serial streams.
+//
+// The default main() runs setup() once and loop() until the requested
+// virtual time has passed:
+//
+//   ./program [seconds]        (default 60)
+//
+// Environment:
+//   SIM_SERIAL_IN, SIM_SERIAL1_IN, SIM_SERIAL2_IN    files fed into the ports' RX
+//   SIM_SERIAL_OUT, SIM_SERIAL1_OUT, SIM_SERIAL2_OUT files capturing TX (Serial -> stdout)
+//   SIM_SOFTSERIAL_IN, SIM_SOFTSERIAL_OUT          same for a SoftwareSerial port
+//   SIM_ANALOG="pin=value,..."     fixed ADC readings (A0 = 54 ... as on a Mega)
+//   SIM_DIGITAL="pin=value,..."    input levels
+//   SIM_PULSE_US="pin=width,..."   pulseIn() result per pin (e.g. ultrasonic echo)
+//   SIM_PULSE_TRAIN="pin=hz,..."   square wave on input pins
+//   SIM_ULTRASONIC="trig=echo,..." HC-SR04 model: each trigger pulse sends an
+//                                  echo of the SIM_PULSE_US width (none = no target)
+//   SIM_DHT11_PIN, SIM_TEMPERATURE, SIM_HUMIDITY   simulated DHT11
+//   SIM_LOOP_COST_US   virtual time one loop() iteration takes (default 100)
+//   SIM_SEED           random() seed
+//   SIM_TRACE          trace servos/displays to stderr
+
+#include "Arduino.h"
+#include <queue>
+#include <vector>
+
+#define SIM_PINS 128
+#define SIM_CALL_COST_US 1   // every clock read costs 1 µs, so busy-waits terminate
+
+static uint64_t simMicros = 0;
+static bool inEvent = false;
+static uint8_t pinModes[SIM_PINS];
+static uint8_t pinLevels[SIM_PINS];
+static int analogLevels[SIM_PINS];
+static int analogOut[SIM_PINS];
+static unsigned long pulseWidths[SIM_PINS];
+static void (*isrs[SIM_PINS])();
+static int isrModes[SIM_PINS];
+static bool interruptsOn = true;
+static unsigned long (*pulseInHook)(uint8_t, uint8_t, unsigned long) = nullptr;
+static bool traceOn = false;
+static unsigned long loopCostUs = 100;
+float simTemperature = 25.0f, simHumidity = 50.0f;
+
+HardwareSerial Serial(0);
+HardwareSerial Serial1(1);
+HardwareSerial Serial2(2);
+static HardwareSerial *softSerial = nullptr;
+
+// FreeRTOS shim (FreeRTOS.cpp): run tasks that are due, report the next wake-up
+void simRunTasks();
+uint64_t simNextTaskWake();
+bool simInTask();
+void simTaskDelay(uint64_t untilMicros);
+
+// --- Scheduled pin events ---
+
+struct PinEvent {
+  uint64_t at;
+  uint32_t order;  // FIFO among events at the same time
+  uint8_t pin;
+  uint8_t value;
+  bool operator>(const PinEvent &o) const { return at != o.at ? at > o.at : order > o.order; }
+};
+
+static std::priority_queue<PinEvent, std::vector<PinEvent>, std::greater<PinEvent>> pinEvents;
+static uint32_t pinEventOrder = 0;
+static uint64_t pulseTrainHalfUs[SIM_PINS];  // 0 = no pulse train
+
+static void applyPin(uint8_t pin, int value);
+
+void simScheduleDigital(uint8_t pin, int value, uint64_t atMicros) {
+  pinEvents.push({atMicros, pinEventOrder++, pin, (uint8_t)(value ? HIGH : LOW)});
+}
+
+// Move the clock forward, delivering pin events (and their interrupts) on time
+static void advanceTo(uint64_t t) {
+  if (inEvent) {  // an ISR reading the clock; events resume after it returns
+    if (t > simMicros) simMicros = t;
+    return;
+  }
+  while (!pinEvents.empty() && pinEvents.top().at <= t) {
+    PinEvent e = pinEvents.top();
+    pinEvents.pop();
+    if (e.at > simMicros) simMicros = e.at;
+    inEvent = true;
+    applyPin(e.pin, e.value);
+    inEvent = false;
+    if (pulseTrainHalfUs[e.pin]) {
+      simScheduleDigital(e.pin, !e.value, e.at + pulseTrainHalfUs[e.pin]);
+    }
+  }
+  if (t > simMicros) simMicros = t;
+}
+
+void simAdvanceMicros(unsigned long us) { advanceTo(simMicros + us); }
+uint64_t simNowMicros() { return simMicros; }
+
+// unsigned long is 64 bits on the host, so these don't wrap at 32 bits as on
+// a board: a wrapped value would break every `micros() - start` after ~71 min
+unsigned long micros() {
+  advanceTo(simMicros + SIM_CALL_COST_US);
+  return (unsigned long)simMicros;
+}
+
+unsigned long millis() {
+  advanceTo(simMicros + SIM_CALL_COST_US);
+  return (unsigned long)(simMicros / 1000);
+}
+
+// Let due FreeRTOS tasks run while the main context waits until t
+static void waitUntil(uint64_t t) {
+  if (simInTask()) {
+    simTaskDelay(t);
+    return;
+  }
+  for (;;) {
+    uint64_t wake = simNextTaskWake();
+    if (wake > t) break;
+    advanceTo(wake);
+    simRunTasks();
+  }
+  advanceTo(t);
+}
+
+void delay(unsigned long ms) { waitUntil(simMicros + (uint64_t)ms * 1000); }
+void delayMicroseconds(unsigned int us) { advanceTo(simMicros + us); }
+void yield() { waitUntil(simMicros); }
+
+// --- GPIO ---
+
+static void applyPin(uint8_t pin, int value) {
+  int old = pinLevels[pin];
+  pinLevels[pin] = value ? HIGH : LOW;
+  if (!isrs[pin] || old == pinLevels[pin] || !interruptsOn) return;
+  int m = isrModes[pin];
+  if (m == CHANGE || (m == RISING && value) || (m == FALLING && !value)) isrs[pin]();
+}
+
+static uint8_t ultrasonicEcho[SIM_PINS];  // echo pin + 1 per trigger pin, 0 = none
+static void ultrasonicPing(uint8_t trig);
+
+static uint8_t dht11Pin = 0xFF;
+static uint64_t dht11LowSince = 0;
+static void dht11Reply();
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin >= SIM_PINS) return;
+  uint8_t old = pinModes[pin];
+  pinModes[pin] = mode;
+  if (pin == dht11Pin && old == OUTPUT && mode != OUTPUT) {
+    applyPin(pin, HIGH);  // the data line has a pull-up
+    dht11Reply();         // host released the line after its start signal
+  } else if (mode == INPUT_PULLUP) {
+    pinLevels[pin] = HIGH;
+  }
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  if (pin >= SIM_PINS) return;
+  if (pin == dht11Pin && val == LOW) dht11LowSince = simMicros;
+  if (ultrasonicEcho[pin] && pinLevels[pin] == HIGH && val == LOW) ultrasonicPing(pin);
+  pinLevels[pin] = val ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin) { return pin < SIM_PINS ? pinLevels[pin] : LOW; }
+int analogRead(uint8_t pin) { return pin < SIM_PINS ? analogLevels[pin] : 0; }
+
+void analogWrite(uint8_t pin, int value) {
+  if (pin < SIM_PINS) analogOut[pin] = value;
+}
+
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration) {
+  if (pin < SIM_PINS) analogOut[pin] = frequency;
+  simTrace("tone pin %u %u Hz %lu ms", pin, frequency, duration);
+}
+
+void noTone(uint8_t pin) {
+  if (pin < SIM_PINS) analogOut[pin] = 0;
+}
+
+// The pulse arrives right away; the call takes as long as the pulse (or the timeout)
+unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeout) {
+  unsigned long width = pin < SIM_PINS ? pulseWidths[pin] : 0;
+  if (pulseInHook) width = pulseInHook(pin, state, timeout);
+  if (width > timeout) width = 0;
+  advanceTo(simMicros + (width ? width : timeout));
+  return width;
+}
+
+void attachInterrupt(int irq, void (*isr)(), int mode) {
+  if (irq < 0 || irq >= SIM_PINS) return;
+  isrs[irq] = isr;
+  isrModes[irq] = mode;
+}
+
+void detachInterrupt(int irq) {
+  if (irq >= 0 && irq < SIM_PINS) isrs[irq] = nullptr;
+}
+
+void noInterrupts() { interruptsOn = false; }
+void interrupts() { interruptsOn = true; }
+
+long random(long howbig) { return howbig > 0 ? rand() % howbig : 0; }
+long random(long lo, long hi) { return hi > lo ? lo + random(hi - lo) : lo; }
+void randomSeed(unsigned long seed) { srand(seed); }
+
+long map(long x, long inMin, long inMax, long outMin, long outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+void simSetAnalog(uint8_t pin, int value) {
+  if (pin < SIM_PINS) analogLevels[pin] = value;
+}
+
+void simSetDigital(uint8_t pin, int value) {
+  if (pin < SIM_PINS) applyPin(pin, value);
+}
+
+int simGetDigital(uint8_t pin) { return pin < SIM_PINS ? pinLevels[pin] : LOW; }
+int simGetPinMode(uint8_t pin) { return pin < SIM_PINS ? pinModes[pin] : INPUT; }
+int simGetAnalogOut(uint8_t pin) { return pin < SIM_PINS ? analogOut[pin] : 0; }
+
+void simSetPulseWidth(uint8_t pin, unsigned long us) {
+  if (pin < SIM_PINS) pulseWidths[pin] = us;
+}
+
+void simSetPulseInHook(unsigned long (*hook)(uint8_t, uint8_t, unsigned long)) {
+  pulseInHook = hook;
+}
+
+void simSetPulseTrain(uint8_t pin, float hz) {
+  if (pin >= SIM_PINS) return;
+  bool start = pulseTrainHalfUs[pin] == 0;
+  pulseTrainHalfUs[pin] = hz > 0 ? (uint64_t)(500000.0 / hz) : 0;
+  if (start && pulseTrainHalfUs[pin]) {
+    simScheduleDigital(pin, !pinLevels[pin], simMicros + pulseTrainHalfUs[pin]);
+  }
+}
+
+// --- DHT11 model ---
+
+void simAttachDht11(uint8_t pin) {
+  dht11Pin = pin;
+}
+
+// Queue the sensor's reply: 80 µs low + 80 µs high response, then 40 bits
+// (50 µs low + 26/70 µs high each) and a final low before releasing the line
+static void dht11Reply() {
+  if (simMicros - dht11LowSince < 18000) return;  // start signal too short
+  uint8_t data[5];
+  int h = (int)lround(simHumidity * 10), t = (int)lround(fabs(simTemperature) * 10);
+  data[0] = h / 10;
+  data[1] = h % 10;
+  data[2] = t / 10;
+  data[3] = (t % 10) | (simTemperature < 0 ? 0x80 : 0);
+  data[4] = data[0] + data[1] + data[2] + data[3];
+
+  uint64_t at = simMicros + 30;
+  simScheduleDigital(dht11Pin, LOW, at);
+  simScheduleDigital(dht11Pin, HIGH, at += 80);
+  at += 80;
+  for (int i = 0; i < 40; i++) {
+    simScheduleDigital(dht11Pin, LOW, at);
+    simScheduleDigital(dht11Pin, HIGH, at += 50);
+    at += (data[i / 8] & (0x80 >> (i % 8))) ? 70 : 26;
+  }
+  simScheduleDigital(dht11Pin, LOW, at);
+  simScheduleDigital(dht11Pin, HIGH, at + 50);
+}
+
+// --- HC-SR04 model ---
+
+// The falling trigger edge starts the ping: the echo line goes high ~450 µs
+// later for the round trip, or for 38 ms when nothing is in range
+static void ultrasonicPing(uint8_t trig) {
+  uint8_t echo = ultrasonicEcho[trig] - 1;
+  unsigned long width = pulseWidths[echo] ? pulseWidths[echo] : 38000;
+  simScheduleDigital(echo, HIGH, simMicros + 450);
+  simScheduleDigital(echo, LOW, simMicros + 450 + width);
+  simTrace("ping trig %u echo %u %lu us", trig, echo, width);
+}
+
+void simTrace(const char *fmt, ...) {
+  if (!traceOn) return;
+  va_list ap;
+  va_start(ap, fmt);
+  fprintf(stderr, "[%10.3f] ", simMicros / 1e6);
+  vfprintf(stderr, fmt, ap);
+  fputc('\n', stderr);
+  va_end(ap);
+}
+
+// --- Stream ---
+
+int Stream::timedRead() {
+  unsigned long start = millis();
+  do {
+    int c = read();
+    if (c >= 0) return c;
+    delay(1);
+  } while (millis() - start < timeout_);
+  return -1;
+}
+
+size_t Stream::readBytes(uint8_t *buf, size_t len) {
+  size_t n = 0;
+  while (n < len) {
+    int c = timedRead();
+    if (c < 0) break;
+    buf[n++] = (uint8_t)c;
+  }
+  return n;
+}
+
+String Stream::readStringUntil(char term) {
+  std::string s;
+  int c = timedRead();
+  while (c >= 0 && c != term) {
+    s += (char)c;
+    c = timedRead();
+  }
+  return String(s);
+}
+
+String Stream::readString() {
+  std::string s;
+  for (int c = timedRead(); c >= 0; c = timedRead()) s += (char)c;
+  return String(s);
+}
+
+long Stream::parseInt() {
+  int c;
+  while ((c = peek()) >= 0 && c != '-' && (c < '0' || c > '9')) read();
+  String s = readStringUntil('\n');
+  return s.toInt();
+}
+
+// --- HardwareSerial ---
+
+void HardwareSerial::begin(unsigned long baud, uint32_t, int, int) {
+  baud_ = baud ? baud : 9600;
+  lastRelease_ = (unsigned long)simMicros;
+}
+
+// Move injected bytes into the RX buffer at 10 bits per byte
+void HardwareSerial::release() {
+  unsigned long now = (unsigned long)simMicros;
+  unsigned long byteUs = 10000000UL / baud_;
+  while (!pending_.empty() && now - lastRelease_ >= byteUs) {
+    rx_.push_back(pending_.front());
+    pending_.pop_front();
+    lastRelease_ += byteUs;
+  }
+  if (pending_.empty()) lastRelease_ = now;
+}
+
+int HardwareSerial::available() {
+  release();
+  return (int)rx_.size();
+}
+
+int HardwareSerial::read() {
+  release();
+  if (rx_.empty()) return -1;
+  int c = rx_.front();
+  rx_.pop_front();
+  return c;
+}
+
+int HardwareSerial::peek() {
+  release();
+  return rx_.empty() ? -1 : rx_.front();
+}
+
+int HardwareSerial::availableForWrite() { return 128; }
+
+size_t HardwareSerial::write(uint8_t b) {
+  if (out_) fputc(b, out_);
+  if (hook_) hook_(index_, b);
+  return 1;
+}
+
+void HardwareSerial::simInject(const uint8_t *buf, size_t len) {
+  if (pending_.empty()) lastRelease_ = (unsigned long)simMicros;
+  pending_.insert(pending_.end(), buf, buf + len);
+}
+
+// --- Host driver ---
+
+static void injectFile(HardwareSerial &port, const char *env) {
+  const char *path = getenv(env);
+  if (!path) return;
+  FILE *f = fopen(path, "rb");
+  if (!f) {
+    fprintf(stderr, "sim: can't open %s=%s\n", env, path);
+    exit(1);
+  }
+  uint8_t buf[512];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) port.simInject(buf, n);
+  fclose(f);
+}
+
+static void openOutput(HardwareSerial &port, const char *env) {
+  const char *path = getenv(env);
+  if (path) port.simSetOutput(fopen(path, "wb"));
+}
+
+// Parse "pin=value,pin=value" lists
+static void forEachPair(const char *env, void (*apply)(int pin, double value)) {
+  const char *a = getenv(env);
+  if (!a) return;
+  int pin, used;
+  double value;
+  while (sscanf(a, "%d=%lf%n", &pin, &value, &used) == 2) {
+    if (pin >= 0 && pin < SIM_PINS) apply(pin, value);
+    a += used;
+    if (*a == ',') a++;
+  }
+}
+
+void simRegisterSoftwareSerial(HardwareSerial *port) {
+  softSerial = port;
+}
+
+void simBegin(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+  traceOn = getenv("SIM_TRACE") != nullptr;
+  if (const char *c = getenv("SIM_LOOP_COST_US")) loopCostUs = strtoul(c, nullptr, 10);
+  srand(getenv("SIM_SEED") ? atoi(getenv("SIM_SEED")) : 1);
+  Serial.simSetOutput(stdout);
+  openOutput(Serial, "SIM_SERIAL_OUT");
+  openOutput(Serial1, "SIM_SERIAL1_OUT");
+  openOutput(Serial2, "SIM_SERIAL2_OUT");
+  injectFile(Serial, "SIM_SERIAL_IN");
+  injectFile(Serial1, "SIM_SERIAL1_IN");
+  injectFile(Serial2, "SIM_SERIAL2_IN");
+  if (softSerial) {
+    openOutput(*softSerial, "SIM_SOFTSERIAL_OUT");
+    injectFile(*softSerial, "SIM_SOFTSERIAL_IN");
+  }
+  forEachPair("SIM_ANALOG", [](int pin, double v) { analogLevels[pin] = (int)v; });
+  forEachPair("SIM_DIGITAL", [](int pin, double v) { pinLevels[pin] = v ? HIGH : LOW; });
+  forEachPair("SIM_PULSE_US", [](int pin, double v) { pulseWidths[pin] = (unsigned long)v; });
+  forEachPair("SIM_PULSE_TRAIN", [](int pin, double v) { simSetPulseTrain(pin, v); });
+  forEachPair("SIM_ULTRASONIC", [](int pin, double v) {
+    if (v >= 0 && v < SIM_PINS) ultrasonicEcho[pin] = (uint8_t)v + 1;
+  });
+  if (const char *p = getenv("SIM_DHT11_PIN")) simAttachDht11(atoi(p));
+  if (const char *t = getenv("SIM_TEMPERATURE")) simTemperature = atof(t);
+  if (const char *h = getenv("SIM_HUMIDITY")) simHumidity = atof(h);
+  setup();
+}
+
+void simRunUntil(uint64_t endMicros) {
+  while (simMicros < endMicros) {
+    loop();
+    simRunTasks();
+    waitUntil(simMicros + loopCostUs);
+  }
+  fflush(stdout);
+}
+
+// The tests in test/ link the core without a sketch
+__attribute__((weak)) void setup() {}
+__attribute__((weak)) void loop() {}
+
+__attribute__((weak)) int main(int argc, char **argv) {
+  double seconds = argc > 1 ? atof(argv[1]) : 60;
+  simBegin(argc, argv);
+  simRunUntil((uint64_t)(seconds * 1e6));
+  return 0;
+}
@@ -0,0 +1,258 @@
+// Simulated Arduino core for host (native) builds
+//
+// Time is virtual: it only moves when the sketch reads the clock, delays,
+// waits on pulseIn() or finishes a loop() iteration, so runs are
+// deterministic and much faster than real time. See Arduino.cpp for the
+// simulator controls and the environment variables the host binary reads.
+
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string>
+#include <deque>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define RISING 1
+#define FALLING 2
+#define CHANGE 3
+#define SERIAL_8N1 0x800001c
+#define A0 54
+#define A1 55
+#define A2 56
+#define A3 57
+#define A4 58
+#define A5 59
+#define A6 60
+#define A7 61
+#define A8 62
+#define A9 63
+#define A10 64
+#define A11 65
+#define LED_BUILTIN 13
+#define PROGMEM
+#define IRAM_ATTR
+#define F(s) (s)
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+#define pgm_read_dword(p) (*(const uint32_t *)(p))
+#define pgm_read_ptr(p) (*(void *const *)(p))
+#define constrain(x, lo, hi) ((x) < (lo) ? (lo) : ((x) > (hi) ? (hi) : (x)))
+#define digitalPinToInterrupt(p) (p)
+#define NOT_AN_INTERRUPT -1
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration = 0);
+void noTone(uint8_t pin);
+unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeout = 1000000UL);
+void attachInterrupt(int irq, void (*isr)(), int mode);
+void detachInterrupt(int irq);
+void noInterrupts();
+void interrupts();
+long random(long howbig);
+long random(long lo, long hi);
+void randomSeed(unsigned long seed);
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+
+class String {
+public:
+  String() {}
+  String(const char *s) : s_(s ? s : "") {}
+  String(const std::string &s) : s_(s) {}
+  String(char c) : s_(1, c) {}
+  String(int v) : s_(std::to_string(v)) {}
+  String(unsigned v) : s_(std::to_string(v)) {}
+  String(long v) : s_(std::to_string(v)) {}
+  String(unsigned long v) : s_(std::to_string(v)) {}
+  String(double v, int digits = 2) {
+    char b[32];
+    snprintf(b, sizeof(b), "%.*f", digits, v);
+    s_ = b;
+  }
+  const char *c_str() const { return s_.c_str(); }
+  unsigned length() const { return s_.size(); }
+  char charAt(unsigned i) const { return i < s_.size() ? s_[i] : 0; }
+  char operator[](unsigned i) const { return charAt(i); }
+  int indexOf(char c, unsigned from = 0) const {
+    size_t p = s_.find(c, from);
+    return p == std::string::npos ? -1 : (int)p;
+  }
+  int indexOf(const String &s, unsigned from = 0) const {
+    size_t p = s_.find(s.s_, from);
+    return p == std::string::npos ? -1 : (int)p;
+  }
+  String substring(unsigned from) const { return from < s_.size() ? String(s_.substr(from)) : String(); }
+  String substring(unsigned from, unsigned to) const {
+    return from < to && from < s_.size() ? String(s_.substr(from, to - from)) : String();
+  }
+  bool startsWith(const String &p) const { return s_.compare(0, p.s_.size(), p.s_) == 0; }
+  long toInt() const { return atol(s_.c_str()); }
+  float toFloat() const { return atof(s_.c_str()); }
+  String &operator+=(const String &o) { s_ += o.s_; return *this; }
+  friend String operator+(const String &a, const String &b) { return String(a.s_ + b.s_); }
+  friend String operator+(const char *a, const String &b) { return String(std::string(a) + b.s_); }
+  friend String operator+(const String &a, const char *b) { return String(a.s_ + b); }
+  bool operator==(const char *o) const { return s_ == o; }
+  bool operator==(const String &o) const { return s_ == o.s_; }
+  bool operator!=(const char *o) const { return s_ != o; }
+  void trim() {
+    size_t a = s_.find_first_not_of(" \t\r\n");
+    size_t b = s_.find_last_not_of(" \t\r\n");
+    s_ = (a == std::string::npos) ? "" : s_.substr(a, b - a + 1);
+  }
+  void replace(const String &from, const String &to) {
+    if (from.s_.empty()) return;
+    size_t pos = 0;
+    while ((pos = s_.find(from.s_, pos)) != std::string::npos) {
+      s_.replace(pos, from.s_.size(), to.s_);
+      pos += to.s_.size();
+    }
+  }
+  void toUpperCase() { for (auto &c : s_) c = toupper(c); }
+  void toLowerCase() { for (auto &c : s_) c = tolower(c); }
+private:
+  std::string s_;
+};
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t b) = 0;
+  virtual size_t write(const uint8_t *buf, size_t len) {
+    for (size_t i = 0; i < len; i++) write(buf[i]);
+    return len;
+  }
+  size_t write(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+  size_t write(const char *s, size_t len) { return write((const uint8_t *)s, len); }
+  size_t print(const char *s) { return write(s); }
+  size_t print(const String &s) { return write(s.c_str()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int v) { return printf("%d", v); }
+  size_t print(unsigned v) { return printf("%u", v); }
+  size_t print(long v) { return printf("%ld", v); }
+  size_t print(unsigned long v) { return printf("%lu", v); }
+  size_t print(double v, int digits = 2) { return printf("%.*f", digits, v); }
+  size_t println() { return write("\r\n"); }
+  template <typename T> size_t println(T v) { size_t n = print(v); return n + println(); }
+  size_t println(double v, int digits) { size_t n = print(v, digits); return n + println(); }
+  size_t printf(const char *fmt, ...) __attribute__((format(printf, 2, 3))) {
+    char buf[256];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    if (n < 0) return 0;
+    return write((const uint8_t *)buf, strlen(buf));
+  }
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  void setTimeout(unsigned long ms) { timeout_ = ms; }
+  size_t readBytes(uint8_t *buf, size_t len);
+  size_t readBytes(char *buf, size_t len) { return readBytes((uint8_t *)buf, len); }
+  String readStringUntil(char term);
+  String readString();
+  long parseInt();
+protected:
+  int timedRead();
+  unsigned long timeout_ = 1000;
+};
+
+// Serial port backed by the simulator: output goes to a FILE, input is
+// released into the RX buffer at the configured baud rate in virtual time.
+class HardwareSerial : public Stream {
+public:
+  explicit HardwareSerial(int index) : index_(index) {}
+  void begin(unsigned long baud, uint32_t config = SERIAL_8N1, int rx = -1, int tx = -1);
+  void end() {}
+  int available() override;
+  int read() override;
+  int peek() override;
+  int availableForWrite();
+  void flush() {}
+  size_t write(uint8_t b) override;
+  using Print::write;
+  operator bool() const { return true; }
+  // Simulator side
+  void simInject(const uint8_t *buf, size_t len);
+  void simSetOutput(FILE *f) { out_ = f; }
+  void simSetOutputHook(void (*hook)(int port, uint8_t b)) { hook_ = hook; }
+private:
+  void release();
+  int index_;
+  unsigned long baud_ = 9600;
+  unsigned long lastRelease_ = 0;
+  std::deque<uint8_t> pending_, rx_;
+  FILE *out_ = nullptr;
+  void (*hook_)(int, uint8_t) = nullptr;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+extern HardwareSerial Serial2;
+
+void setup();
+void loop();
+
+// --- Simulator controls (host only) ---
+
+void simAdvanceMicros(unsigned long us);
+uint64_t simNowMicros();
+void simSetAnalog(uint8_t pin, int value);
+void simSetDigital(uint8_t pin, int value);  // drives an input, firing attached interrupts
+int simGetDigital(uint8_t pin);
+int simGetPinMode(uint8_t pin);
+int simGetAnalogOut(uint8_t pin);
+// Change a pin at an absolute virtual time (µs); delivered in time order
+void simScheduleDigital(uint8_t pin, int value, uint64_t atMicros);
+// Change a pin's SIM_PULSE_US width (pulseIn() and the HC-SR04 model's echo)
+void simSetPulseWidth(uint8_t pin, unsigned long us);
+// Answer pulseIn() from a model instead of the fixed SIM_PULSE_US widths
+void simSetPulseInHook(unsigned long (*hook)(uint8_t pin, uint8_t state, unsigned long timeout));
+// Square wave on an input pin, e.g. a sound sensor's pulse output
+void simSetPulseTrain(uint8_t pin, float hz);
+// DHT11 on a pin: answers the start signal with a reply carrying simTemperature/simHumidity
+void simAttachDht11(uint8_t pin);
+extern float simTemperature, simHumidity;
+// SoftwareSerial ports register here so simBegin() can wire up their files
+void simRegisterSoftwareSerial(HardwareSerial *port);
+// Trace device activity (servos, displays) to stderr when SIM_TRACE is set
+void simTrace(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+// Run setup() and loop() as the default host main() does. A custom main()
+// (e.g. a scenario driver) can call these and script the inputs in between.
+void simBegin(int argc, char **argv);
+void simRunUntil(uint64_t endMicros);
+
+// ESP32 sketches get FreeRTOS through Arduino.h, so the host does too
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+#endif
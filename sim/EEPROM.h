@@ -0,0 +1,51 @@
+// Simulated AVR EEPROM: E2END + 1 bytes kept in a host file next to the
+// simulated LittleFS files (see FS.h), so they survive between runs the
+// way the real EEPROM survives a reset
+#ifndef SIM_EEPROM_H
+#define SIM_EEPROM_H
+
+#include "FS.h"
+
+#define E2END 1023
+
+class EEPROMClass {
+public:
+  uint8_t read(int addr) {
+    load();
+    return addr >= 0 && addr <= E2END ? data_[addr] : 0xFF;
+  }
+  void write(int addr, uint8_t value) {
+    load();
+    if (addr < 0 || addr > E2END) return;
+    data_[addr] = value;
+    ::mkdir(fs::simFsRoot().c_str(), 0755);
+    if (FILE *f = fopen(path().c_str(), "wb")) {
+      fwrite(data_, 1, sizeof(data_), f);
+      fclose(f);
+    }
+  }
+  void update(int addr, uint8_t value) {
+    if (read(addr) != value) write(addr, value);
+  }
+  uint16_t length() { return E2END + 1; }
+
+private:
+  uint8_t data_[E2END + 1];
+  bool loaded_ = false;
+
+  static std::string path() { return fs::simFsRoot() + "/eeprom.bin"; }
+  void load() {
+    if (loaded_) return;
+    loaded_ = true;
+    memset(data_, 0xFF, sizeof(data_));   // erased
+    if (FILE *f = fopen(path().c_str(), "rb")) {
+      size_t n = fread(data_, 1, sizeof(data_), f);
+      (void)n;
+      fclose(f);
+    }
+  }
+};
+
+inline EEPROMClass EEPROM;
+
+#endif
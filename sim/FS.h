@@ -0,0 +1,113 @@
+// Simulated Arduino-ESP32 FS: files live in a host directory
+// (SIM_FS_DIR, default /tmp/sim_littlefs) so they survive between runs
+// the way flash survives a reboot.
+#ifndef SIM_FS_H
+#define SIM_FS_H
+
+#include "Arduino.h"
+#include <memory>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs {
+
+inline std::string simFsRoot() {
+  const char *r = getenv("SIM_FS_DIR");
+  return r ? r : "/tmp/sim_littlefs";
+}
+
+class File : public Stream {
+public:
+  File() {}
+  explicit operator bool() const { return fp_ || dir_; }
+  size_t read(uint8_t *buf, size_t len) { return fp_ ? fread(buf, 1, len, fp_.get()) : 0; }
+  int read() override {
+    uint8_t b;
+    return read(&b, 1) == 1 ? b : -1;
+  }
+  int peek() override {
+    if (!fp_) return -1;
+    int c = fgetc(fp_.get());
+    if (c >= 0) ungetc(c, fp_.get());
+    return c;
+  }
+  int available() override {
+    if (!fp_) return 0;
+    long pos = ftell(fp_.get());
+    return (int)(size() - pos);
+  }
+  size_t write(uint8_t b) override { return write(&b, 1); }
+  size_t write(const uint8_t *buf, size_t len) override { return fp_ ? fwrite(buf, 1, len, fp_.get()) : 0; }
+  using Print::write;
+  bool seek(uint32_t pos) { return fp_ && fseek(fp_.get(), pos, SEEK_SET) == 0; }
+  size_t position() const { return fp_ ? ftell(fp_.get()) : 0; }
+  size_t size() const {
+    struct stat st;
+    return stat(path_.c_str(), &st) == 0 ? st.st_size : 0;
+  }
+  void flush() {
+    if (fp_) fflush(fp_.get());
+  }
+  void close() {
+    fp_.reset();
+    dir_.reset();
+  }
+  const char *name() const { return name_.c_str(); }
+  bool isDirectory() const { return (bool)dir_; }
+  File openNextFile() {
+    File f;
+    if (!dir_) return f;
+    for (dirent *e; (e = readdir(dir_.get()));) {
+      if (e->d_name[0] == '.') continue;
+      f.open(path_ + "/" + e->d_name, "rb");
+      return f;
+    }
+    return f;
+  }
+
+  // Opens a host file or directory (simulator side)
+  void open(const std::string &path, const char *mode) {
+    path_ = path;
+    name_ = path.substr(path.find_last_of('/') + 1);
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+      dir_.reset(opendir(path.c_str()), closedir);
+    } else if (FILE *f = fopen(path.c_str(), mode)) {
+      fp_.reset(f, fclose);
+    }
+  }
+
+private:
+  std::shared_ptr<FILE> fp_;
+  std::shared_ptr<DIR> dir_;
+  std::string path_, name_;
+};
+
+class FS {
+public:
+  bool mkdir(const char *path) { return ::mkdir((simFsRoot() + path).c_str(), 0755) == 0; }
+  bool remove(const char *path) { return ::remove((simFsRoot() + path).c_str()) == 0; }
+  bool rmdir(const char *path) { return ::rmdir((simFsRoot() + path).c_str()) == 0; }
+  bool rename(const char *from, const char *to) {
+    return ::rename((simFsRoot() + from).c_str(), (simFsRoot() + to).c_str()) == 0;
+  }
+  bool exists(const char *path) {
+    struct stat st;
+    return stat((simFsRoot() + path).c_str(), &st) == 0;
+  }
+  File open(const char *path, const char *mode = "r", bool create = false) {
+    (void)create;
+    File f;
+    const char *hostMode = mode[0] == 'w' ? "wb" : mode[0] == 'a' ? "ab" : "rb";
+    f.open(simFsRoot() + path, hostMode);
+    return f;
+  }
+};
+
+}  // namespace fs
+
+using fs::File;
+using fs::FS;
+
+#endif
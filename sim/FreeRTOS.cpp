@@ -0,0 +1,218 @@
+// Cooperative FreeRTOS tasks and queues on the simulator's virtual clock.
+// Each task is a ucontext coroutine with its own host stack.
+
+#include "Arduino.h"
+#include <ucontext.h>
+#include <deque>
+#include <vector>
+
+#define SIM_TASK_STACK_BYTES (256 * 1024)  // host code needs more than the ESP32 sizes
+
+struct SimTask {
+  ucontext_t ctx;
+  TaskFunction_t fn;
+  void *arg;
+  UBaseType_t priority;
+  uint64_t wakeAt;
+  uint32_t order;     // round-robin among equal priorities: lowest runs first
+  bool dead;
+  std::vector<char> stack;
+};
+
+struct SimQueue {
+  std::deque<std::vector<uint8_t>> items;
+  UBaseType_t length;
+  UBaseType_t itemSize;
+  std::vector<SimTask *> waiters;  // tasks blocked on this queue (either direction)
+};
+
+static std::vector<SimTask *> tasks;
+static SimTask *current = nullptr;
+static ucontext_t schedulerCtx;
+static uint32_t taskOrder = 0;
+
+bool simInTask() { return current != nullptr; }
+
+uint64_t simNextTaskWake() {
+  uint64_t next = UINT64_MAX;
+  for (SimTask *t : tasks) {
+    if (!t->dead && t->wakeAt < next) next = t->wakeAt;
+  }
+  return next;
+}
+
+// Run every task that is due, highest priority first, until all are blocked
+void simRunTasks() {
+  if (current) return;
+  for (;;) {
+    uint64_t now = simNowMicros();
+    SimTask *next = nullptr;
+    for (SimTask *t : tasks) {
+      if (t->dead || t->wakeAt > now) continue;
+      if (!next || t->priority > next->priority ||
+          (t->priority == next->priority && t->order < next->order)) {
+        next = t;
+      }
+    }
+    if (!next) return;
+    current = next;
+    swapcontext(&schedulerCtx, &next->ctx);
+    current = nullptr;
+  }
+}
+
+// Suspend the running task until untilMicros (or until a queue wakes it)
+void simTaskDelay(uint64_t untilMicros) {
+  SimTask *self = current;
+  self->wakeAt = untilMicros;
+  self->order = ++taskOrder;
+  swapcontext(&self->ctx, &schedulerCtx);
+}
+
+static void taskEntry() {
+  current->fn(current->arg);
+  current->dead = true;  // returning from a task is an error on FreeRTOS; just stop it
+  swapcontext(&current->ctx, &schedulerCtx);
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stackDepth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core) {
+  (void)name;
+  (void)stackDepth;
+  (void)core;
+  SimTask *t = new SimTask();
+  t->fn = fn;
+  t->arg = arg;
+  t->priority = priority;
+  t->wakeAt = simNowMicros();
+  t->order = ++taskOrder;
+  t->stack.resize(SIM_TASK_STACK_BYTES);
+  getcontext(&t->ctx);
+  t->ctx.uc_stack.ss_sp = t->stack.data();
+  t->ctx.uc_stack.ss_size = t->stack.size();
+  t->ctx.uc_link = nullptr;
+  makecontext(&t->ctx, taskEntry, 0);
+  tasks.push_back(t);
+  if (handle) *handle = t;
+  return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stackDepth, void *arg,
+                       UBaseType_t priority, TaskHandle_t *handle) {
+  return xTaskCreatePinnedToCore(fn, name, stackDepth, arg, priority, handle, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+  SimTask *t = task ? task : current;
+  if (!t) return;
+  t->dead = true;
+  if (t == current) swapcontext(&t->ctx, &schedulerCtx);
+}
+
+void vTaskDelay(TickType_t ticks) {
+  delay(ticks);
+}
+
+void taskYIELD() {
+  if (current) simTaskDelay(simNowMicros());
+}
+
+TickType_t xTaskGetTickCount() {
+  return (TickType_t)(simNowMicros() / 1000);
+}
+
+BaseType_t xTaskDelayUntil(TickType_t *previousWake, TickType_t increment) {
+  TickType_t next = *previousWake + increment;
+  TickType_t now = xTaskGetTickCount();
+  *previousWake = next;
+  int32_t ahead = (int32_t)(next - now);
+  if (ahead <= 0) {
+    return pdFALSE;  // deadline already passed, no delay
+  }
+  delay((unsigned long)ahead);
+  return pdTRUE;
+}
+
+// --- Queues ---
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+  SimQueue *q = new SimQueue();
+  q->length = length;
+  q->itemSize = itemSize;
+  return q;
+}
+
+static void wakeWaiters(SimQueue *q) {
+  for (SimTask *t : q->waiters) t->wakeAt = simNowMicros();
+  q->waiters.clear();
+}
+
+// Block until the queue changes or the deadline passes. From loop() this
+// runs the tasks in the meantime. Returns false once the deadline is reached.
+static bool waitOnQueue(SimQueue *q, uint64_t deadline) {
+  uint64_t now = simNowMicros();
+  if (now >= deadline) return false;
+  if (current) {
+    q->waiters.push_back(current);
+    simTaskDelay(deadline);
+    return true;
+  }
+  uint64_t next = simNextTaskWake();
+  if (next == UINT64_MAX) return false;  // nothing could ever change the queue
+  if (next > deadline) next = deadline;
+  if (next > now) simAdvanceMicros(next - now);
+  simRunTasks();
+  return true;
+}
+
+static uint64_t deadlineFor(TickType_t wait) {
+  return wait == portMAX_DELAY ? UINT64_MAX : simNowMicros() + (uint64_t)wait * 1000;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t wait) {
+  uint64_t deadline = deadlineFor(wait);
+  while (q->items.size() >= q->length) {
+    if (!waitOnQueue(q, deadline)) return pdFALSE;
+  }
+  const uint8_t *p = (const uint8_t *)item;
+  q->items.emplace_back(p, p + q->itemSize);
+  wakeWaiters(q);
+  return pdTRUE;
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t q, const void *item) {
+  q->items.clear();
+  const uint8_t *p = (const uint8_t *)item;
+  q->items.emplace_back(p, p + q->itemSize);
+  wakeWaiters(q);
+  return pdTRUE;
+}
+
+static BaseType_t receive(QueueHandle_t q, void *item, TickType_t wait, bool remove) {
+  uint64_t deadline = deadlineFor(wait);
+  while (q->items.empty()) {
+    if (!waitOnQueue(q, deadline)) return pdFALSE;
+  }
+  memcpy(item, q->items.front().data(), q->itemSize);
+  if (remove) {
+    q->items.pop_front();
+    wakeWaiters(q);
+  }
+  return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t wait) {
+  return receive(q, item, wait, true);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t q, void *item, TickType_t wait) {
+  return receive(q, item, wait, false);
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) {
+  return q->items.size();
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t q) {
+  return q->length - q->items.size();
+}
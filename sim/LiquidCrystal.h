@@ -0,0 +1,49 @@
+// Simulated HD44780 LCD: keeps a character buffer and traces each change
+#ifndef SIM_LIQUIDCRYSTAL_H
+#define SIM_LIQUIDCRYSTAL_H
+
+#include "Arduino.h"
+
+class LiquidCrystal : public Print {
+public:
+  LiquidCrystal(uint8_t rs, uint8_t en, uint8_t d4, uint8_t d5, uint8_t d6, uint8_t d7) {
+    (void)rs; (void)en; (void)d4; (void)d5; (void)d6; (void)d7;
+    clear();
+  }
+  LiquidCrystal(uint8_t rs, uint8_t rw, uint8_t en, uint8_t d0, uint8_t d1, uint8_t d2, uint8_t d3,
+                uint8_t d4, uint8_t d5, uint8_t d6, uint8_t d7) : LiquidCrystal(rs, en, d4, d5, d6, d7) {
+    (void)rw; (void)d0; (void)d1; (void)d2; (void)d3;
+  }
+  void begin(uint8_t cols, uint8_t rows) {
+    cols_ = cols < 20 ? cols : 20;
+    rows_ = rows < 4 ? rows : 4;
+    clear();
+  }
+  void clear() {
+    memset(text_, ' ', sizeof(text_));
+    col_ = row_ = 0;
+  }
+  void home() { col_ = row_ = 0; }
+  void setCursor(uint8_t col, uint8_t row) {
+    col_ = col;
+    row_ = row < rows_ ? row : rows_ - 1;
+  }
+  size_t write(uint8_t c) override {
+    if (col_ < cols_) text_[row_][col_] = c;
+    col_++;
+    simTrace("lcd %u: |%.*s|", row_, cols_, text_[row_]);
+    return 1;
+  }
+  using Print::write;
+  void noDisplay() {}
+  void display() {}
+  void noCursor() {}
+  void cursor() {}
+  // Current contents of a row (for scenario drivers)
+  String simRow(uint8_t row) const { return String(std::string(text_[row], cols_)); }
+private:
+  char text_[4][20];
+  uint8_t cols_ = 16, rows_ = 2, col_ = 0, row_ = 0;
+};
+
+#endif
@@ -0,0 +1,23 @@
+// Simulated LittleFS: see FS.h for where the files are kept
+#ifndef SIM_LITTLEFS_H
+#define SIM_LITTLEFS_H
+
+#include "FS.h"
+
+class LittleFSFS : public fs::FS {
+public:
+  bool begin(bool formatOnFail = false, const char *basePath = "/littlefs", uint8_t maxOpenFiles = 10,
+             const char *partitionLabel = "spiffs") {
+    (void)formatOnFail; (void)basePath; (void)maxOpenFiles; (void)partitionLabel;
+    ::mkdir(fs::simFsRoot().c_str(), 0755);
+    return true;
+  }
+  void end() {}
+  bool format() { return true; }
+  size_t totalBytes() { return 1536 * 1024; }
+  size_t usedBytes() { return 0; }
+};
+
+inline LittleFSFS LittleFS;
+
+#endif
@@ -0,0 +1,26 @@
+// Simulated Servo library: remembers the angle and traces moves
+#ifndef SIM_SERVO_H
+#define SIM_SERVO_H
+
+#include "Arduino.h"
+
+class Servo {
+public:
+  uint8_t attach(int pin) {
+    pin_ = pin;
+    return 0;
+  }
+  void detach() { pin_ = -1; }
+  bool attached() const { return pin_ >= 0; }
+  void write(int angle) {
+    angle_ = constrain(angle, 0, 180);
+    simTrace("servo pin %d -> %d deg", pin_, angle_);
+  }
+  void writeMicroseconds(int us) { write(map(us, 544, 2400, 0, 180)); }
+  int read() const { return angle_; }
+private:
+  int pin_ = -1;
+  int angle_ = 90;
+};
+
+#endif
@@ -0,0 +1,19 @@
+// Simulated SoftwareSerial: a fourth serial port (index 3), fed and captured
+// through SIM_SOFTSERIAL_IN / SIM_SOFTSERIAL_OUT
+#ifndef SIM_SOFTWARESERIAL_H
+#define SIM_SOFTWARESERIAL_H
+
+#include "Arduino.h"
+
+class SoftwareSerial : public HardwareSerial {
+public:
+  SoftwareSerial(uint8_t rx, uint8_t tx, bool inverse = false) : HardwareSerial(3) {
+    (void)rx; (void)tx; (void)inverse;
+    simRegisterSoftwareSerial(this);
+  }
+  bool listen() { return true; }
+  bool isListening() { return true; }
+  bool overflow() { return false; }
+};
+
+#endif
@@ -0,0 +1,30 @@
+// Simulated TM1637 4-digit display: traces what would be shown
+#ifndef SIM_TM1637DISPLAY_H
+#define SIM_TM1637DISPLAY_H
+
+#include "Arduino.h"
+
+class TM1637Display {
+public:
+  TM1637Display(uint8_t clk, uint8_t dio, unsigned int bitDelay = 100) : clk_(clk) {
+    (void)dio;
+    (void)bitDelay;
+  }
+  void setBrightness(uint8_t brightness, bool on = true) {
+    simTrace("tm1637 clk %u brightness %u%s", clk_, brightness, on ? "" : " (off)");
+  }
+  void setSegments(const uint8_t segments[], uint8_t length = 4, uint8_t pos = 0) {
+    simTrace("tm1637 clk %u segments %02x %02x %02x %02x", clk_, length > 0 ? segments[0] : 0,
+             length > 1 ? segments[1] : 0, length > 2 ? segments[2] : 0, length > 3 ? segments[3] : 0);
+    (void)pos;
+  }
+  void clear() { simTrace("tm1637 clk %u clear", clk_); }
+  void showNumberDec(int num, bool leadingZero = false, uint8_t length = 4, uint8_t pos = 0) {
+    (void)pos;
+    simTrace(leadingZero ? "tm1637 clk %u %0*d" : "tm1637 clk %u %*d", clk_, length, num);
+  }
+private:
+  uint8_t clk_;
+};
+
+#endif
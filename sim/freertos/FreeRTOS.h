@@ -0,0 +1,28 @@
+// Host stand-in for the FreeRTOS subset the ESP32 sketches use.
+//
+// Tasks are cooperative coroutines scheduled on the simulator's virtual
+// clock: a task runs until it blocks (vTaskDelay, xTaskDelayUntil, a queue
+// wait or delay()), then the next due task or loop() continues. Priorities
+// order tasks that are due at the same time; core affinity is ignored.
+// One tick is 1 ms, as on the ESP32 Arduino core.
+
+#ifndef SIM_FREERTOS_H
+#define SIM_FREERTOS_H
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdTRUE  1
+#define pdFALSE 0
+#define pdPASS  pdTRUE
+#define pdFAIL  pdFALSE
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFFUL)
+#define portTICK_PERIOD_MS 1
+#define configTICK_RATE_HZ 1000
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+#endif
@@ -0,0 +1,72 @@
+# PlatformIO pre-script: build the sketch named by the SKETCH environment
+# variable (e.g. SKETCH=Receiver.cpp pio run -e native), or by the
+# environment's custom_sketch option when SKETCH isn't set. pio test
+# builds the tests in test/ against the simulated core without a sketch.
+#
+# The sketches are written like .ino files, so this does what the Arduino
+# IDE does before compiling: add #include <Arduino.h> and a prototype for
+# every function, inserted just before the first function definition.
+
+import os
+import re
+
+from SCons.Script import COMMAND_LINE_TARGETS
+
+Import("env")
+
+FUNCTION_RE = re.compile(r"^([A-Za-z_][\w:<>\s\*&]*?[\s\*&])([A-Za-z_]\w*)\s*\(([^;{}]*)\)\s*\{")
+NOT_FUNCTIONS = ("if", "for", "while", "switch", "return")
+
+
+def strip_defaults(args):
+    return re.sub(r"\s*=\s*[^,]+", "", args)
+
+
+def preprocess(path):
+    lines = open(path, encoding="utf-8").read().split("\n")
+    prototypes = []
+    first = None
+    depth = 0
+    for i, line in enumerate(lines):
+        m = FUNCTION_RE.match(line) if depth == 0 else None
+        if m and m.group(2) not in NOT_FUNCTIONS and not line.startswith(("struct", "class", "enum", "typedef", "template")):
+            if first is None:
+                first = i
+            if not line.startswith(("static inline", "inline")) and m.group(2) not in ("setup", "loop"):
+                prototypes.append("%s%s(%s);" % (m.group(1), m.group(2), strip_defaults(m.group(3))))
+        depth += line.count("{") - line.count("}")
+    # Leave a function's leading comment attached to it
+    insert = first if first is not None else 0
+    while insert > 0 and lines[insert - 1].startswith("//"):
+        insert -= 1
+    out = ["#include <Arduino.h>", '#line 1 "%s"' % path]
+    out += lines[:insert] + prototypes + ['#line %d "%s"' % (insert + 1, path)] + lines[insert:]
+    return "\n".join(out)
+
+
+def build_sketch():
+    sketch = os.environ.get("SKETCH") or env.GetProjectOption("custom_sketch", "")
+    if not sketch:
+        print("Set SKETCH to the sketch to build, e.g. SKETCH=Receiver.cpp pio run -e native")
+        env.Exit(1)
+
+    source = os.path.join(project_dir, sketch)
+    if not os.path.isfile(source):
+        print("No such sketch: %s" % source)
+        env.Exit(1)
+
+    generated_dir = os.path.join(env.subst("$BUILD_DIR"), "sketch_src")
+    os.makedirs(generated_dir, exist_ok=True)
+    generated = os.path.join(generated_dir, "sketch.cpp")
+    text = preprocess(source)
+    # Only rewrite on change so unchanged sketches are not recompiled
+    if not os.path.isfile(generated) or open(generated, encoding="utf-8").read() != text:
+        with open(generated, "w", encoding="utf-8") as f:
+            f.write(text)
+    env.BuildSources(os.path.join("$BUILD_DIR", "sketch"), generated_dir)
+
+
+project_dir = env.subst("$PROJECT_DIR")
+env.Append(CPPPATH=[project_dir])
+if "__test" not in COMMAND_LINE_TARGETS:
+    build_sketch()
@@ -0,0 +1,85 @@
+// Gas_Adc_Sampler.h: oversampling and smoothing of the raw ADC stream
+
+#include <Arduino.h>
+#include <unity.h>
+#include "Gas_Adc_Sampler.h"
+
+AdcDecimator d;
+
+void setUp() {}
+void tearDown() {}
+
+void addBlock(AdcDecimator &dec, uint16_t raw) {
+  for (uint32_t n = 0; n < (1u << (2 * dec.oversampleBits)); n++) {
+    adcDecimatorAdd(dec, raw);
+  }
+}
+
+void test_no_output_before_a_full_block() {
+  adcDecimatorInit(d, 4, 2);
+  for (int n = 0; n < 255; n++) {
+    adcDecimatorAdd(d, 1000);
+  }
+  TEST_ASSERT_EQUAL(0, d.outputs);
+  adcDecimatorAdd(d, 1000);
+  TEST_ASSERT_EQUAL(1, d.outputs);
+  TEST_ASSERT_EQUAL(1000, adcDecimatorRead(d));
+}
+
+void test_oversampling_adds_resolution() {
+  adcDecimatorInit(d, 4, 0);
+  for (int n = 0; n < 256; n++) {
+    adcDecimatorAdd(d, n % 2 ? 1001 : 1000);
+  }
+  // 1000.5 in 16ths, which a single conversion can't show
+  TEST_ASSERT_EQUAL(16008, d.filtered >> 8);
+  TEST_ASSERT_EQUAL(1001, adcDecimatorRead(d));   // rounded back to raw counts
+}
+
+void test_smoothing_steps_by_a_quarter() {
+  adcDecimatorInit(d, 4, 2);
+  addBlock(d, 0);             // the first output is taken as it is
+  TEST_ASSERT_EQUAL(0, adcDecimatorRead(d));
+  addBlock(d, 4095);
+  TEST_ASSERT_EQUAL(1024, adcDecimatorRead(d));   // 4095 / 4
+  for (int n = 0; n < 60; n++) {
+    addBlock(d, 4095);
+  }
+  TEST_ASSERT_EQUAL(4095, adcDecimatorRead(d));
+}
+
+void test_no_smoothing_follows_at_once() {
+  adcDecimatorInit(d, 2, 0);
+  addBlock(d, 100);
+  addBlock(d, 3000);
+  TEST_ASSERT_EQUAL(3000, adcDecimatorRead(d));
+  TEST_ASSERT_EQUAL(2, d.outputs);
+}
+
+void test_sampler_polls_every_channel() {
+  const AdcChannelConfig channels[ADC_SAMPLER_CHANNELS] = {
+    {A0, 4, 2}, {A1, 4, 2}, {A2, 4, 2}, {A3, 4, 3},
+  };
+  TEST_ASSERT_TRUE(adcSamplerBegin(channels));
+  TEST_ASSERT_FALSE(adcSamplerReady());
+  simSetAnalog(A0, 350);
+  simSetAnalog(A1, 2700);
+  simSetAnalog(A2, 150);
+  simSetAnalog(A3, 4000);
+  adcSamplerPoll();
+  TEST_ASSERT_TRUE(adcSamplerReady());
+  TEST_ASSERT_EQUAL(350, adcSamplerRead(ADC_CH_MQ7));
+  TEST_ASSERT_EQUAL(2700, adcSamplerRead(ADC_CH_MQ5));
+  TEST_ASSERT_EQUAL(150, adcSamplerRead(ADC_CH_MQ135));
+  TEST_ASSERT_EQUAL(4000, adcSamplerRead(ADC_CH_O2));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_no_output_before_a_full_block);
+  RUN_TEST(test_oversampling_adds_resolution);
+  RUN_TEST(test_smoothing_steps_by_a_quarter);
+  RUN_TEST(test_no_smoothing_follows_at_once);
+  RUN_TEST(test_sampler_polls_every_channel);
+  return UNITY_END();
+}
@@ -0,0 +1,98 @@
+// Button_Events.h: debouncing of bouncy presses and releases
+
+#include <Arduino.h>
+#include <unity.h>
+#include "Button_Events.h"
+
+#define PIN 4
+
+uint8_t button;
+
+void setUp() {}
+void tearDown() {}
+
+void drain() {
+  ButtonEvent e;
+  while (buttonNextEvent(e)) {
+  }
+}
+
+// The contact chatters: level, then its opposite and back, 1 ms apart
+void bounce(int level, int chatter) {
+  simSetDigital(PIN, level);
+  for (int i = 0; i < chatter; i++) {
+    simAdvanceMicros(1000);
+    simSetDigital(PIN, !level);
+    simAdvanceMicros(1000);
+    simSetDigital(PIN, level);
+  }
+  simAdvanceMicros((BUTTON_DEBOUNCE_MS + 5) * 1000UL);
+}
+
+void test_bouncy_press_counts_once() {
+  drain();
+  bounce(LOW, 3);
+  ButtonEvent e;
+  TEST_ASSERT_TRUE(buttonNextEvent(e));
+  TEST_ASSERT_EQUAL(button, e.button);
+  TEST_ASSERT_FALSE(buttonNextEvent(e));
+  bounce(HIGH, 3);   // the release is no press
+  TEST_ASSERT_FALSE(buttonNextEvent(e));
+}
+
+void test_two_presses() {
+  drain();
+  bounce(LOW, 2);
+  bounce(HIGH, 2);
+  bounce(LOW, 2);
+  bounce(HIGH, 0);
+  ButtonEvent e;
+  TEST_ASSERT_TRUE(buttonNextEvent(e));
+  TEST_ASSERT_TRUE(buttonNextEvent(e));
+  TEST_ASSERT_FALSE(buttonNextEvent(e));
+}
+
+// The ISR runs late and the contact has already bounced high again
+void test_press_read_high_by_the_isr() {
+  drain();
+  simSetDigital(PIN, HIGH);
+  buttonOnEdge(button);
+  ButtonEvent e;
+  TEST_ASSERT_TRUE(buttonNextEvent(e));
+  simAdvanceMicros((BUTTON_DEBOUNCE_MS + 5) * 1000UL);
+  TEST_ASSERT_FALSE(buttonNextEvent(e));   // quiet and high: released again
+  TEST_ASSERT_FALSE(buttons[button].down);
+}
+
+// An edge lost on the way doesn't leave the button inverted
+void test_lost_edge_resyncs() {
+  drain();
+  simSetDigital(PIN, HIGH);
+  buttons[button].down = true;
+  simAdvanceMicros((BUTTON_DEBOUNCE_MS + 5) * 1000UL);
+  ButtonEvent e;
+  TEST_ASSERT_FALSE(buttonNextEvent(e));
+  bounce(LOW, 1);
+  TEST_ASSERT_TRUE(buttonNextEvent(e));
+  bounce(HIGH, 0);
+}
+
+// Once BUTTON_MAX buttons are set up, another one gets no slot
+void test_no_slot_past_max() {
+  while (buttonCount < BUTTON_MAX) {
+    TEST_ASSERT_EQUAL(buttonCount, buttonAdd(PIN + 1 + buttonCount));
+  }
+  TEST_ASSERT_EQUAL(BUTTON_NONE, buttonAdd(PIN + 1 + BUTTON_MAX));
+  TEST_ASSERT_EQUAL(BUTTON_MAX, buttonCount);
+}
+
+int main() {
+  button = buttonAdd(PIN);
+  UNITY_BEGIN();
+  RUN_TEST(test_bouncy_press_counts_once);
+  RUN_TEST(test_two_presses);
+  RUN_TEST(test_press_read_high_by_the_isr);
+  RUN_TEST(test_lost_edge_resyncs);
+  RUN_TEST(test_no_slot_past_max);
+  return UNITY_END();
+}
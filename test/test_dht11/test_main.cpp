@@ -0,0 +1,120 @@
+// DHT11_Async.h: decoding recorded replies, and a whole read against the
+// simulator's DHT11 model
+
+#include <Arduino.h>
+#include <unity.h>
+#include "DHT11_Async.h"
+
+#define PIN 27
+
+uint16_t times[DHT11_MAX_EDGES];
+uint8_t levels[DHT11_MAX_EDGES];
+uint8_t count;
+
+void setUp() {}
+void tearDown() {}
+
+void edge(uint16_t &t, uint16_t after, uint8_t level) {
+  t += after;
+  times[count] = t;
+  levels[count++] = level;
+}
+
+// Edges as the ISR records them: the release edge, the 80 us response low
+// and high, then 50 us low + 26/70 us high per bit. Widths wobble by a few
+// us as they do on a real sensor, and the timer wraps mid-reply.
+void record(const uint8_t data[5], int bits = 40) {
+  uint16_t t = 0xFF00;
+  count = 0;
+  edge(t, 0, HIGH);
+  edge(t, 30, LOW);
+  edge(t, 80, HIGH);
+  edge(t, 80, LOW);
+  for (int i = 0; i < bits; i++) {
+    bool one = data[i / 8] & (0x80 >> (i % 8));
+    edge(t, 48 + i % 4, HIGH);
+    edge(t, one ? 68 + i % 5 : 23 + i % 6, LOW);
+  }
+  edge(t, 50, HIGH);
+}
+
+void test_decodes_a_reply() {
+  const uint8_t sent[5] = {62, 0, 31, 5, 98};
+  uint8_t data[5];
+  record(sent);
+  TEST_ASSERT_EQUAL(DHT11_OK, dht11Decode(times, levels, count, data));
+  TEST_ASSERT_EQUAL_MEMORY(sent, data, 5);
+}
+
+void test_bad_checksum() {
+  const uint8_t sent[5] = {62, 0, 31, 5, 99};
+  uint8_t data[5];
+  record(sent);
+  TEST_ASSERT_EQUAL(DHT11_ERR_CHECKSUM, dht11Decode(times, levels, count, data));
+}
+
+void test_cut_off_reply_times_out() {
+  const uint8_t sent[5] = {62, 0, 31, 5, 98};
+  uint8_t data[5];
+  record(sent, 30);   // the line stopped toggling after 30 bits
+  TEST_ASSERT_EQUAL(DHT11_ERR_TIMEOUT, dht11Decode(times, levels, count, data));
+  count = 1;          // nothing but the release edge: no sensor
+  TEST_ASSERT_EQUAL(DHT11_ERR_TIMEOUT, dht11Decode(times, levels, count, data));
+}
+
+// Poll the way Transmitter's climate task does: sleep until the next step
+bool readSensor() {
+  dht11Start();
+  unsigned long lowFrom = micros();
+  while (!dht11Poll()) {
+    if (dht11.state == DHT11_RECEIVING && lowFrom) {
+      TEST_ASSERT_UINT_WITHIN(100, DHT11_START_LOW_MS * 1000UL, micros() - lowFrom);
+      lowFrom = 0;
+    }
+    simAdvanceMicros(dht11WaitMs() * 1000);
+  }
+  return dht11.lastResult == DHT11_OK;
+}
+
+void test_start_signal_lasts_its_own_deadline() {
+  dht11Begin(PIN);
+  dht11Start();
+  TEST_ASSERT_EQUAL(DHT11_START_LOW_MS, dht11WaitMs());
+  simAdvanceMicros(5000);
+  TEST_ASSERT_EQUAL(DHT11_START_LOW_MS - 5, dht11WaitMs());
+  simAdvanceMicros(15000);
+  TEST_ASSERT_EQUAL(0, dht11WaitMs());
+  dht11Poll();
+  TEST_ASSERT_EQUAL(DHT11_RECEIVING, dht11.state);
+  TEST_ASSERT_LESS_OR_EQUAL(DHT11_REPLY_US / 1000 + 1, dht11WaitMs());
+}
+
+void test_reads_the_simulated_sensor() {
+  simAttachDht11(PIN);
+  simTemperature = -4.5f;
+  simHumidity = 38.0f;
+  dht11Begin(PIN);
+  TEST_ASSERT_TRUE(readSensor());
+  TEST_ASSERT_FLOAT_WITHIN(0.01, -4.5, dht11.temperature);
+  TEST_ASSERT_FLOAT_WITHIN(0.01, 38.0, dht11.humidity);
+}
+
+void test_no_sensor_times_out() {
+  simAttachDht11(0xFF);
+  dht11Begin(PIN);
+  uint32_t timeouts = dht11.timeouts;
+  TEST_ASSERT_FALSE(readSensor());
+  TEST_ASSERT_EQUAL(DHT11_ERR_TIMEOUT, dht11.lastResult);
+  TEST_ASSERT_EQUAL(timeouts + 1, dht11.timeouts);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_decodes_a_reply);
+  RUN_TEST(test_bad_checksum);
+  RUN_TEST(test_cut_off_reply_times_out);
+  RUN_TEST(test_start_signal_lasts_its_own_deadline);
+  RUN_TEST(test_reads_the_simulated_sensor);
+  RUN_TEST(test_no_sensor_times_out);
+  return UNITY_END();
+}
@@ -0,0 +1,95 @@
+// Fast_Gpio.h: the AVR register code run on the host against an array of
+// registers with the Mega pin map, and its speed next to digitalWrite()
+
+#include <Arduino.h>
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+
+uint8_t hostRegs[0x10C];
+uint8_t SREG;
+void cli() {}
+#define FAST_GPIO_HOST_REGS hostRegs
+#include "Fast_Gpio.h"
+
+#define PINB 0x23
+#define PORTB 0x25
+#define PORTE 0x2E
+#define PORTG 0x34
+#define PORTH 0x102
+
+// The traffic lights of Smart_traffic_system.cpp: pins 2-13, bit i = pin 2 + i
+typedef FastPinGroup<2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13> Lights;
+
+void setUp() { memset(hostRegs, 0, sizeof(hostRegs)); }
+void tearDown() {}
+
+void test_pin_writes_its_bit() {
+  FastPin<13>::high();   // PB7
+  TEST_ASSERT_EQUAL(0x80, hostRegs[PORTB]);
+  TEST_ASSERT_TRUE(FastPin<13>::latched());
+  FastPin<13>::low();
+  TEST_ASSERT_EQUAL(0, hostRegs[PORTB]);
+  FastPin<13>::toggle();   // one write to PINB
+  TEST_ASSERT_EQUAL(0x80, hostRegs[PINB]);
+  hostRegs[PORTH] = 0x81;
+  FastPin<9>::high();   // PH6, past the SBI range
+  TEST_ASSERT_EQUAL(0xC1, hostRegs[PORTH]);
+}
+
+void test_group_sets_each_port() {
+  hostRegs[PORTB] = hostRegs[PORTE] = hostRegs[PORTG] = hostRegs[PORTH] = 0x01;   // pins outside the group
+  Lights::write(0xFFF);
+  TEST_ASSERT_EQUAL(0x01 | 0x38, hostRegs[PORTE]);   // pins 2, 3, 5 = PE4, PE5, PE3
+  TEST_ASSERT_EQUAL(0x01 | 0x20, hostRegs[PORTG]);   // pin 4 = PG5
+  TEST_ASSERT_EQUAL(0x01 | 0x78, hostRegs[PORTH]);   // pins 6-9 = PH3-PH6
+  TEST_ASSERT_EQUAL(0x01 | 0xF0, hostRegs[PORTB]);   // pins 10-13 = PB4-PB7
+  Lights::write(0);
+  TEST_ASSERT_EQUAL(0x01, hostRegs[PORTE]);
+  TEST_ASSERT_EQUAL(0x01, hostRegs[PORTG]);
+  TEST_ASSERT_EQUAL(0x01, hostRegs[PORTH]);
+  TEST_ASSERT_EQUAL(0x01, hostRegs[PORTB]);
+}
+
+void test_group_bit_order() {
+  // Road A green (pin 4), B red (pin 5), C red (pin 8), D yellow (pin 12)
+  Lights::write(1 << 2 | 1 << 3 | 1 << 6 | 1 << 10);
+  TEST_ASSERT_EQUAL(0x08, hostRegs[PORTE]);   // PE3
+  TEST_ASSERT_EQUAL(0x20, hostRegs[PORTG]);   // PG5
+  TEST_ASSERT_EQUAL(0x20, hostRegs[PORTH]);   // PH5
+  TEST_ASSERT_EQUAL(0x40, hostRegs[PORTB]);   // PB6
+}
+
+// Host time per intersection update: the group against twelve
+// digitalWrite() calls on the simulator. On the Mega the group is four
+// port writes (about 40 cycles) and digitalWrite() about 50 cycles a pin.
+void test_speed() {
+  const int rounds = 1000000;
+  using Clock = std::chrono::steady_clock;
+  auto t0 = Clock::now();
+  for (int r = 0; r < rounds; r++) {
+    Lights::write((uint16_t)r);
+  }
+  auto t1 = Clock::now();
+  for (int r = 0; r < rounds; r++) {
+    for (uint8_t i = 0; i < 12; i++) {
+      digitalWrite(2 + i, (r >> i) & 1 ? HIGH : LOW);
+    }
+  }
+  auto t2 = Clock::now();
+  double group = std::chrono::duration<double, std::nano>(t1 - t0).count() / rounds;
+  double single = std::chrono::duration<double, std::nano>(t2 - t1).count() / rounds;
+  char line[96];
+  snprintf(line, sizeof(line), "12 lights: FastPinGroup %.1f ns, digitalWrite %.1f ns", group, single);
+  TEST_MESSAGE(line);
+  TEST_ASSERT_LESS_THAN(single, group);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_pin_writes_its_bit);
+  RUN_TEST(test_group_sets_each_port);
+  RUN_TEST(test_group_bit_order);
+  RUN_TEST(test_speed);
+  return UNITY_END();
+}
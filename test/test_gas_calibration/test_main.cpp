@@ -0,0 +1,89 @@
+// Gas_Calibration.h: the generated tables against the curves they come
+// from, and the integer lookup against the exact curve
+
+#include <Arduino.h>
+#include <unity.h>
+#include <math.h>
+#include "Gas_Calibration.h"
+
+// The curves in tools/gas_curves.py: ppm = a * (Rs/R0)^b
+struct Curve {
+  const GasCurve *table;
+  double a, b, clean;
+};
+
+const Curve curves[] = {
+  {&GAS_CURVE_MQ7, 99.042, -1.518, 27.5},
+  {&GAS_CURVE_MQ5, 177.65, -2.56, 6.5},
+  {&GAS_CURVE_MQ135, 102.2, -2.473, 3.6},
+};
+
+double exactPpm(const Curve &c, double ratio) {
+  double ppm = c.a * pow(ratio, c.b);
+  return ppm > 65535 ? 65535 : ppm;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_tables_match_the_generator() {
+  for (int k = 0; k < GAS_CURVE_POINTS; k++) {
+    double ratio = pow(2.0, -4 + k / 16.0);
+    TEST_ASSERT_EQUAL(lround(ratio * GAS_RATIO_ONE), gasRatioPoints[k]);
+    for (const Curve &c : curves) {
+      TEST_ASSERT_UINT_WITHIN(1, lround(exactPpm(c, ratio)), c.table->ppm[k]);
+    }
+  }
+  for (const Curve &c : curves) {
+    TEST_ASSERT_EQUAL(lround(c.clean * GAS_RATIO_ONE), c.table->cleanAirRatio);
+  }
+}
+
+// Every Q10 ratio in the table's range: within 2% of the curve beyond the
+// 1 ppm the result can't resolve (the bound tools/gas_curves.py --check uses)
+void test_lookup_error_bound() {
+  for (const Curve &c : curves) {
+    double worst = 0;
+    for (uint32_t q = gasRatioPoints[0]; q < gasRatioPoints[GAS_CURVE_POINTS - 1]; q++) {
+      double exact = exactPpm(c, q / 1024.0);
+      if (exact < 1 || exact >= 65535) continue;
+      double err = (fabs(gasCurvePpm(*c.table, q) - exact) - 1) / exact;
+      if (err > worst) worst = err;
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.02, 0, worst);
+  }
+}
+
+void test_clamped_outside_the_table() {
+  TEST_ASSERT_EQUAL(GAS_CURVE_MQ7.ppm[0], gasCurvePpm(GAS_CURVE_MQ7, 1));
+  TEST_ASSERT_EQUAL(GAS_CURVE_MQ7.ppm[GAS_CURVE_POINTS - 1], gasCurvePpm(GAS_CURVE_MQ7, 0xFFFF));
+}
+
+// A sensor set up from a clean-air reading reads the curve's clean-air ppm there
+void test_clean_air_reading() {
+  for (const Curve &c : curves) {
+    for (uint16_t adc : {100, 400, 900}) {
+      GasSensor s = {c.table, 0};
+      gasSensorBegin(s, adc);
+      TEST_ASSERT_UINT_WITHIN(c.table->cleanAirRatio / 200, c.table->cleanAirRatio, gasRatio(s, adc));   // R0 is rounded
+      double exact = exactPpm(c, c.clean);
+      TEST_ASSERT_FLOAT_WITHIN(0.02 * exact + 1, exact, gasSensorPpm(s, adc));
+    }
+  }
+}
+
+void test_adc_ends() {
+  TEST_ASSERT_EQUAL(0xFFFFFFFFUL, gasRsRl(0));
+  TEST_ASSERT_EQUAL(0, gasRsRl(GAS_ADC_MAX));
+  TEST_ASSERT_UINT_WITHIN(256, 65536, gasRsRl(GAS_ADC_MAX / 2));   // Rs = RL at mid scale
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_tables_match_the_generator);
+  RUN_TEST(test_lookup_error_bound);
+  RUN_TEST(test_clamped_outside_the_table);
+  RUN_TEST(test_clean_air_reading);
+  RUN_TEST(test_adc_ends);
+  return UNITY_END();
+}
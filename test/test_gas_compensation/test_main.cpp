@@ -0,0 +1,90 @@
+// Gas_Compensation.h: the bilinear climate factor at the grid corners, in
+// between and past the edges
+
+#include <Arduino.h>
+#include <unity.h>
+#include "Gas_Compensation.h"
+
+#define T_LAST (GAS_CLIMATE_T_FIRST + (GAS_CLIMATE_T_POINTS - 1) * GAS_CLIMATE_T_STEP)
+#define RH_LAST (GAS_CLIMATE_RH_FIRST + (GAS_CLIMATE_RH_POINTS - 1) * GAS_CLIMATE_RH_STEP)
+
+const uint16_t (*const tables[])[GAS_CLIMATE_T_POINTS] = {gasClimateMq7, gasClimateMq5, gasClimateMq135};
+
+int16_t gridT(int i) { return GAS_CLIMATE_T_FIRST + i * GAS_CLIMATE_T_STEP; }
+int16_t gridRh(int j) { return GAS_CLIMATE_RH_FIRST + j * GAS_CLIMATE_RH_STEP; }
+
+void setUp() {}
+void tearDown() {}
+
+// Every grid point, the four corners of the grid included, reads its entry
+void test_grid_points() {
+  for (auto table : tables) {
+    for (int j = 0; j < GAS_CLIMATE_RH_POINTS; j++) {
+      for (int i = 0; i < GAS_CLIMATE_T_POINTS; i++) {
+        TEST_ASSERT_EQUAL(table[j][i], gasClimateFactor(table, gridT(i), gridRh(j)));
+      }
+    }
+  }
+}
+
+// The middle of a cell is the mean of its corners; a quarter of the way in
+// weighs them 9:3:3:1
+void test_inside_a_cell() {
+  for (auto table : tables) {
+    for (int j = 0; j + 1 < GAS_CLIMATE_RH_POINTS; j++) {
+      for (int i = 0; i + 1 < GAS_CLIMATE_T_POINTS; i++) {
+        uint32_t a = table[j][i], b = table[j][i + 1], c = table[j + 1][i], d = table[j + 1][i + 1];
+        TEST_ASSERT_UINT_WITHIN(1, (a + b + c + d + 2) / 4,
+                                gasClimateFactor(table, gridT(i) + GAS_CLIMATE_T_STEP / 2,
+                                                 gridRh(j) + GAS_CLIMATE_RH_STEP / 2));
+        TEST_ASSERT_UINT_WITHIN(1, (9 * a + 3 * b + 3 * c + d + 8) / 16,
+                                gasClimateFactor(table, gridT(i) + GAS_CLIMATE_T_STEP / 4,
+                                                 gridRh(j) + GAS_CLIMATE_RH_STEP / 4));
+      }
+    }
+  }
+}
+
+// Past the grid the nearest edge or corner holds
+void test_clamped_outside() {
+  const int lastT = GAS_CLIMATE_T_POINTS - 1, lastRh = GAS_CLIMATE_RH_POINTS - 1;
+  for (auto table : tables) {
+    TEST_ASSERT_EQUAL(table[0][0], gasClimateFactor(table, -400, 0));
+    TEST_ASSERT_EQUAL(table[0][lastT], gasClimateFactor(table, T_LAST + 300, 0));
+    TEST_ASSERT_EQUAL(table[lastRh][0], gasClimateFactor(table, -400, RH_LAST + 100));
+    TEST_ASSERT_EQUAL(table[lastRh][lastT], gasClimateFactor(table, T_LAST + 300, RH_LAST + 100));
+    TEST_ASSERT_EQUAL(table[2][lastT], gasClimateFactor(table, T_LAST + 300, gridRh(2)));
+  }
+}
+
+// The curves hold at 20 °C / 65% RH, so the factor there is about 1
+void test_reference_climate() {
+  for (auto table : tables) {
+    TEST_ASSERT_UINT_WITHIN(10, 1024, gasClimateFactor(table, 200, 650));
+  }
+}
+
+void test_sample() {
+  GasSample s = {};
+  s.mq7Ppm = s.mq5Ppm = s.mq135Ppm = 1000;
+  s.temperature = 300;
+  s.humidity = 800;
+  gasCompensateSample(s);   // no climate reading: left alone
+  TEST_ASSERT_EQUAL(1000, s.mq7Ppm);
+  s.flags = GAS_FLAG_HAS_CLIMATE;
+  gasCompensateSample(s);
+  TEST_ASSERT_EQUAL((1000UL * gasClimateMq7[3][4] + 512) >> 10, s.mq7Ppm);
+  TEST_ASSERT_EQUAL((1000UL * gasClimateMq5[3][4] + 512) >> 10, s.mq5Ppm);
+  TEST_ASSERT_EQUAL((1000UL * gasClimateMq135[3][4] + 512) >> 10, s.mq135Ppm);
+  TEST_ASSERT_EQUAL(0xFFFF, gasCompensatePpm(60000, 2048));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_grid_points);
+  RUN_TEST(test_inside_a_cell);
+  RUN_TEST(test_clamped_outside);
+  RUN_TEST(test_reference_climate);
+  RUN_TEST(test_sample);
+  return UNITY_END();
+}
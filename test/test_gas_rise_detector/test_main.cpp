@@ -0,0 +1,137 @@
+// Gas_Rise_Detector.h: the slope of known ramps, the pre-alarm hysteresis
+// and the restart on a gap or on time going backwards
+
+#include <Arduino.h>
+#include <unity.h>
+#include "Gas_Rise_Detector.h"
+
+const GasRiseLimit limit = {300, 100};   // 300 ppm/min, from 100 ppm
+GasRiseDetector d;
+
+void setUp() { riseReset(d); }
+void tearDown() {}
+
+// ppm = start + perMinute * t, one sample every stepMs from t0
+void ramp(uint32_t &t, uint32_t stepMs, int samples, double &ppm, double perMinute) {
+  for (int i = 0; i < samples; i++) {
+    riseAdd(d, t, (uint16_t)(ppm + 0.5));
+    t += stepMs;
+    ppm += perMinute * stepMs / 60000.0;
+  }
+}
+
+// The first three readings pass straight through; from the fourth on the
+// median lags a ramp by one sample. The fit is exact once the window holds
+// only lagged ones.
+#define RAMP_SETTLED (RISE_WINDOW + 3)
+
+void test_slope_of_a_ramp() {
+  uint32_t t = 1000;
+  double ppm = 20;
+  ramp(t, 5000, RISE_WINDOW - 1, ppm, 600);
+  TEST_ASSERT_EQUAL(0, d.slope);   // window not full yet
+  ramp(t, 5000, RAMP_SETTLED - (RISE_WINDOW - 1), ppm, 600);
+  TEST_ASSERT_EQUAL(600, d.slope);
+  ramp(t, 5000, 100, ppm, 600);
+  TEST_ASSERT_EQUAL(600, d.slope);
+}
+
+// A falling ramp while the sender's clock wraps past 2^32
+void test_clock_wrap() {
+  uint32_t t = 0xFFFFFFFFUL - 6000;
+  double ppm = 2000;
+  ramp(t, 1000, RAMP_SETTLED, ppm, -120);
+  TEST_ASSERT_EQUAL(-120, d.slope);
+}
+
+// Uneven spacing: the median's lag of one sample bends the fit a little
+void test_uneven_spacing() {
+  uint32_t t = 0;
+  double ppm = 2000;
+  const uint32_t steps[] = {200, 5000, 1300, 4700, 200, 200, 3000, 900};
+  for (int i = 0; i < 40; i++) {
+    ramp(t, steps[i % 8], 1, ppm, -120);
+  }
+  TEST_ASSERT_INT_WITHIN(15, -120, d.slope);
+}
+
+// Thousands of updates of the running sums leave no drift behind
+void test_no_drift() {
+  uint32_t t = 0;
+  double ppm = 10;
+  ramp(t, 1000, 20000, ppm, 60);
+  ppm = 400;
+  ramp(t, 1000, RAMP_SETTLED, ppm, 0);
+  TEST_ASSERT_EQUAL(0, d.slope);
+}
+
+// The median of three keeps one bad frame from faking a rise
+void test_single_spike() {
+  uint32_t t = 0;
+  for (int i = 0; i < 3 * RISE_WINDOW; i++) {
+    TEST_ASSERT_FALSE(riseUpdate(d, limit, t, i == 2 * RISE_WINDOW ? 5000 : 100));
+    t += 1000;
+  }
+}
+
+void test_pre_alarm_hysteresis() {
+  uint32_t t = 0;
+  double ppm = 10;
+  ramp(t, 1000, RAMP_SETTLED, ppm, 400);
+  TEST_ASSERT_FALSE(riseUpdate(d, limit, t, (uint16_t)ppm));   // still below 100 ppm
+  ramp(t, 1000, 10, ppm, 400);
+  TEST_ASSERT_TRUE(riseUpdate(d, limit, t, (uint16_t)ppm));
+  t += 1000;
+  ppm += 200 / 60.0;
+  for (int i = 0; i < 2 * RISE_WINDOW; i++) {   // 200 ppm/min: above half the limit
+    TEST_ASSERT_TRUE(riseUpdate(d, limit, t, (uint16_t)(ppm + 0.5)));
+    t += 1000;
+    ppm += 200 / 60.0;
+  }
+  for (int i = 0; i < 2 * RISE_WINDOW; i++) {   // levelling off
+    riseUpdate(d, limit, t, (uint16_t)ppm);
+    t += 1000;
+  }
+  TEST_ASSERT_FALSE(d.rising);
+}
+
+void test_reset_on_gap() {
+  uint32_t t = 0;
+  double ppm = 100;
+  ramp(t, 1000, RAMP_SETTLED, ppm, 600);
+  TEST_ASSERT_EQUAL(600, d.slope);
+  t += RISE_MAX_GAP_MS;
+  riseAdd(d, t, 200);
+  TEST_ASSERT_EQUAL(1, d.count);
+  TEST_ASSERT_EQUAL(0, d.slope);
+  TEST_ASSERT_EQUAL(200, d.value[d.oldest]);   // the median starts again too
+}
+
+void test_reset_on_time_going_backwards() {
+  uint32_t t = 100000;
+  double ppm = 100;
+  ramp(t, 1000, RAMP_SETTLED, ppm, 600);
+  riseAdd(d, 500, 50);   // the transmitter restarted
+  TEST_ASSERT_EQUAL(1, d.count);
+  TEST_ASSERT_EQUAL(0, d.slope);
+  t = 500;
+  riseAdd(d, t, 50);   // the same timestamp again
+  TEST_ASSERT_EQUAL(1, d.count);
+  t += 1000;
+  ppm = 50 + 10;
+  ramp(t, 1000, RAMP_SETTLED - 1, ppm, 600);
+  TEST_ASSERT_EQUAL(600, d.slope);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_slope_of_a_ramp);
+  RUN_TEST(test_clock_wrap);
+  RUN_TEST(test_uneven_spacing);
+  RUN_TEST(test_no_drift);
+  RUN_TEST(test_single_spike);
+  RUN_TEST(test_pre_alarm_hysteresis);
+  RUN_TEST(test_reset_on_gap);
+  RUN_TEST(test_reset_on_time_going_backwards);
+  return UNITY_END();
+}
@@ -0,0 +1,44 @@
+// Loop_Profiler.h: log2 histogram bucket boundaries
+
+#include <Arduino.h>
+#include <unity.h>
+#include "Loop_Profiler.h"
+
+void setUp() {}
+void tearDown() {}
+
+// Bucket 0 is under 1 us, bucket i is [2^(i-1), 2^i) us
+void test_bucket_boundaries() {
+  TEST_ASSERT_EQUAL(0, profileBucket(0));
+  TEST_ASSERT_EQUAL(1, profileBucket(1));
+  TEST_ASSERT_EQUAL(2, profileBucket(2));
+  TEST_ASSERT_EQUAL(2, profileBucket(3));
+  TEST_ASSERT_EQUAL(3, profileBucket(4));
+  TEST_ASSERT_EQUAL(16, profileBucket(0xFFFF));
+  TEST_ASSERT_EQUAL(17, profileBucket(0x10000));   // past 16 bits
+  TEST_ASSERT_EQUAL(20, profileBucket((1UL << 20) - 1));
+  TEST_ASSERT_EQUAL(21, profileBucket(1UL << 20));
+}
+
+// Everything from the last bucket's start up lands in it
+void test_long_scopes_clamp() {
+  TEST_ASSERT_EQUAL(PROFILE_BUCKETS - 1, profileBucket(1UL << 21));
+  TEST_ASSERT_EQUAL(PROFILE_BUCKETS - 1, profileBucket(0xFFFFFFFFUL));
+}
+
+void test_record_counts_in_its_bucket() {
+  ProfileRegion r("test");
+  profileRecord(r, 5 * PROFILE_TICKS_PER_US);
+  profileRecord(r, 7 * PROFILE_TICKS_PER_US);
+  TEST_ASSERT_EQUAL(2, r.buckets[3]);
+  TEST_ASSERT_EQUAL(2, r.count);
+  TEST_ASSERT_EQUAL(7 * PROFILE_TICKS_PER_US, r.maxTicks);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_bucket_boundaries);
+  RUN_TEST(test_long_scopes_clamp);
+  RUN_TEST(test_record_counts_in_its_bucket);
+  return UNITY_END();
+}
@@ -0,0 +1,61 @@
+// Gas_Report_Policy.h: band crossings on the values the receiver alarms on
+
+#include <Arduino.h>
+#include <unity.h>
+#include "Gas_Report_Policy.h"
+
+ReportPolicy policy;
+
+GasSample sample(uint16_t mq7Ppm, int16_t temperature = 0, int16_t humidity = 0) {
+  GasSample s = {};
+  s.mq7Ppm = mq7Ppm;
+  s.mq5Ppm = 300;
+  s.mq135Ppm = 5;
+  if (temperature || humidity) {
+    s.flags = GAS_FLAG_HAS_CLIMATE;
+    s.temperature = temperature;
+    s.humidity = humidity;
+  }
+  return s;
+}
+
+void setUp() { policy = ReportPolicy(); }
+void tearDown() {}
+
+void test_first_sample_goes_out() {
+  TEST_ASSERT_EQUAL(REPORT_CROSSING, reportCheck(policy, sample(10), 0));
+  reportSent(policy, sample(10), 0, REPORT_CROSSING);
+  TEST_ASSERT_EQUAL(REPORT_NONE, reportCheck(policy, sample(11), 10));
+  TEST_ASSERT_EQUAL(REPORT_HEARTBEAT, reportCheck(policy, sample(11), REPORT_HEARTBEAT_MS));
+}
+
+// The receiver alarms above its threshold (50 ppm CO), so 50 is still in the band below
+void test_edge_is_above_the_threshold() {
+  reportSent(policy, sample(47), 0, REPORT_CROSSING);
+  TEST_ASSERT_EQUAL(REPORT_NONE, reportCheck(policy, sample(50), 10));
+  TEST_ASSERT_EQUAL(REPORT_CROSSING, reportCheck(policy, sample(51), 10));
+}
+
+// At -10 °C / 20% RH the receiver scales CO readings up by ~1.36: 36 ppm
+// reads 49 there and 38 ppm reads 52, over the threshold
+void test_crossing_after_compensation() {
+  reportSent(policy, sample(36, -100, 200), 0, REPORT_CROSSING);
+  TEST_ASSERT_EQUAL(49, policy.last.mq7Ppm);
+  TEST_ASSERT_EQUAL(REPORT_CROSSING, reportCheck(policy, sample(38, -100, 200), 10));
+}
+
+// At 50 °C / 100% RH it scales them down by ~0.8: 62 ppm is only 49
+void test_no_crossing_after_compensation() {
+  reportSent(policy, sample(55, 500, 1000), 0, REPORT_CROSSING);
+  TEST_ASSERT_EQUAL(REPORT_NONE, reportCheck(policy, sample(62, 500, 1000), 10));
+  TEST_ASSERT_EQUAL(REPORT_CROSSING, reportCheck(policy, sample(64, 500, 1000), 10));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_first_sample_goes_out);
+  RUN_TEST(test_edge_is_above_the_threshold);
+  RUN_TEST(test_crossing_after_compensation);
+  RUN_TEST(test_no_crossing_after_compensation);
+  return UNITY_END();
+}
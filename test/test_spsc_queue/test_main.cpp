@@ -0,0 +1,72 @@
+// Spsc_Queue.h: order and capacity, and a producer and consumer thread
+// racing through a million items
+
+#include <Arduino.h>
+#include <unity.h>
+#include <thread>
+#include "Spsc_Queue.h"
+
+// Every word derived from the sequence number, so a torn copy shows
+struct Item {
+  uint32_t seq;
+  uint32_t check[7];
+};
+
+Item makeItem(uint32_t seq) {
+  Item item;
+  item.seq = seq;
+  for (int i = 0; i < 7; i++) item.check[i] = seq * 2654435761u + i;
+  return item;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_fifo_and_capacity() {
+  SpscQueue<Item, 4> q;
+  Item item;
+  TEST_ASSERT_FALSE(q.pop(item));
+  for (uint32_t i = 0; i < 4; i++) TEST_ASSERT_TRUE(q.push(makeItem(i)));
+  TEST_ASSERT_FALSE(q.push(makeItem(4)));
+  TEST_ASSERT_EQUAL(4, q.count());
+  for (uint32_t i = 0; i < 4; i++) {
+    TEST_ASSERT_TRUE(q.pop(item));
+    TEST_ASSERT_EQUAL(i, item.seq);
+  }
+  TEST_ASSERT_FALSE(q.pop(item));
+}
+
+// The counters wrap at 65536 many times over
+void test_two_threads() {
+  static SpscQueue<Item, 16> q;
+  const uint32_t items = 1000000;
+  std::thread producer([] {
+    for (uint32_t i = 0; i < items;) {
+      if (q.push(makeItem(i))) i++;
+      else std::this_thread::yield();   // full
+    }
+  });
+  uint32_t next = 0, torn = 0, outOfOrder = 0;
+  Item item;
+  while (next < items) {
+    if (!q.pop(item)) {
+      std::this_thread::yield();   // empty
+      continue;
+    }
+    if (item.seq != next) outOfOrder++;
+    Item expected = makeItem(item.seq);
+    if (memcmp(&item, &expected, sizeof(item)) != 0) torn++;
+    next++;
+  }
+  producer.join();
+  TEST_ASSERT_EQUAL(0, outOfOrder);
+  TEST_ASSERT_EQUAL(0, torn);
+  TEST_ASSERT_FALSE(q.pop(item));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_fifo_and_capacity);
+  RUN_TEST(test_two_threads);
+  return UNITY_END();
+}
@@ -0,0 +1,172 @@
+#!/usr/bin/env python3
+# Generate the MQ sensor lookup tables in Gas_Calibration.h and
+# Gas_Compensation.h.
+#
+#   python3 tools/gas_curves.py            # print the generated blocks
+#   python3 tools/gas_curves.py --write    # replace them in the headers
+#   python3 tools/gas_curves.py --check    # compare the fixed-point lookup with the curves
+#
+# Each sensor follows a straight line on the datasheet's log-log plot:
+# ppm = a * (Rs/R0)^b. The tables hold that curve at log-spaced Rs/R0 points,
+# so the boards only interpolate between two table entries.
+#
+# The datasheets also plot Rs/R0 in clean air against temperature, at 33%
+# and 85% RH. Rs/R0 scaled by k turns a reading of ppm into ppm * k^b, so
+# the climate tables hold 1 / k^b: the factor that brings a reading back to
+# the 20 °C / 65% RH the curves were measured at.
+
+import os
+import sys
+
+Q = 1024                  # Rs/R0 and Rs/RL fixed point (Q10)
+STEPS_PER_OCTAVE = 16
+FIRST_OCTAVE = -4         # Rs/R0 from 1/16 ...
+LAST_OCTAVE = 5           # ... to 32
+PPM_MAX = 65535
+
+# name, gas, a, b, Rs/R0 in clean air
+CURVES = [
+    ("MQ7", "CO", 99.042, -1.518, 27.5),
+    ("MQ5", "CH4", 177.65, -2.56, 6.5),
+    ("MQ135", "NH3", 102.2, -2.473, 3.6),
+]
+
+# Rs/R0 in clean air at CLIMATE_DATA_T, on the datasheets' 33% and 85% RH curves
+CLIMATE_DATA_T = [-10, 0, 10, 20, 30, 40, 50]
+CLIMATE_DATA = {
+    "MQ7": ([1.13, 1.08, 1.03, 1.00, 0.97, 0.95, 0.93],
+            [1.03, 0.98, 0.94, 0.91, 0.88, 0.86, 0.84]),
+    "MQ5": ([1.18, 1.12, 1.05, 1.00, 0.96, 0.93, 0.91],
+            [1.06, 1.01, 0.95, 0.90, 0.87, 0.85, 0.83]),
+    "MQ135": ([1.70, 1.40, 1.16, 0.99, 0.90, 0.87, 0.91],
+              [1.61, 1.30, 1.07, 0.90, 0.80, 0.77, 0.82]),
+}
+CLIMATE_REF = (20, 65)                  # °C, %RH of the gas curves
+CLIMATE_T = list(range(-10, 51, 10))    # table grid, °C
+CLIMATE_RH = list(range(20, 101, 20))   # table grid, %RH
+
+HERE = os.path.dirname(__file__)
+CALIBRATION_HEADER = os.path.join(HERE, "..", "Gas_Calibration.h")
+COMPENSATION_HEADER = os.path.join(HERE, "..", "Gas_Compensation.h")
+BEGIN = "// --- generated by tools/gas_curves.py, do not edit ---\n"
+END = "// --- end of generated tables ---\n"
+
+
+def ratio_points():
+    steps = (LAST_OCTAVE - FIRST_OCTAVE) * STEPS_PER_OCTAVE
+    return [2.0 ** (FIRST_OCTAVE + k / STEPS_PER_OCTAVE) for k in range(steps + 1)]
+
+
+def ppm(a, b, ratio):
+    return min(PPM_MAX, a * ratio ** b)
+
+
+def table(values, per_line=12):
+    lines = []
+    for i in range(0, len(values), per_line):
+        lines.append("  " + ", ".join("%d" % v for v in values[i:i + per_line]) + ",")
+    return "\n".join(lines)
+
+
+def generate_curves():
+    points = ratio_points()
+    out = [BEGIN]
+    out.append("#define GAS_CURVE_POINTS %d\n\n" % len(points))
+    out.append("// Rs/R0 at each table entry, Q10 (2^(k/%d) from 1/%d to %d)\n"
+               % (STEPS_PER_OCTAVE, 2 ** -FIRST_OCTAVE, 2 ** LAST_OCTAVE))
+    out.append("const uint16_t gasRatioPoints[GAS_CURVE_POINTS] PROGMEM = {\n%s\n};\n"
+               % table([round(r * Q) for r in points]))
+    for name, gas, a, b, clean in CURVES:
+        values = [round(ppm(a, b, r)) for r in points]
+        out.append("\n// %s, %s: ppm = %g * (Rs/R0)^%g, Rs/R0 = %g in clean air\n" % (name, gas, a, b, clean))
+        out.append("const uint16_t gasCurve%sPpm[GAS_CURVE_POINTS] PROGMEM = {\n%s\n};\n"
+                   % (name.capitalize(), table(values)))
+        out.append("const GasCurve GAS_CURVE_%s = {gasCurve%sPpm, %d};\n"
+                   % (name, name.capitalize(), round(clean * Q)))
+    out.append(END)
+    return "".join(out)
+
+
+def climate_k(name, t, rh):
+    """Clean-air Rs/R0 at t °C and rh %RH, linear between the datasheet points"""
+    dry, wet = CLIMATE_DATA[name]
+    i = min(len(CLIMATE_DATA_T) - 2, max(0, (t - CLIMATE_DATA_T[0]) // 10))
+    f = (t - CLIMATE_DATA_T[i]) / 10.0
+    k33 = dry[i] + (dry[i + 1] - dry[i]) * f
+    k85 = wet[i] + (wet[i + 1] - wet[i]) * f
+    return k33 + (k85 - k33) * (rh - 33) / (85 - 33)
+
+
+def generate_climate():
+    out = [BEGIN]
+    out.append("#define GAS_CLIMATE_T_POINTS %d\n" % len(CLIMATE_T))
+    out.append("#define GAS_CLIMATE_T_FIRST %d    // 0.1 °C\n" % (CLIMATE_T[0] * 10))
+    out.append("#define GAS_CLIMATE_T_STEP %d\n" % ((CLIMATE_T[1] - CLIMATE_T[0]) * 10))
+    out.append("#define GAS_CLIMATE_RH_POINTS %d\n" % len(CLIMATE_RH))
+    out.append("#define GAS_CLIMATE_RH_FIRST %d   // 0.1 %%RH\n" % (CLIMATE_RH[0] * 10))
+    out.append("#define GAS_CLIMATE_RH_STEP %d\n" % ((CLIMATE_RH[1] - CLIMATE_RH[0]) * 10))
+    for name, gas, a, b, clean in CURVES:
+        ref = climate_k(name, *CLIMATE_REF)
+        rows = []
+        for rh in CLIMATE_RH:
+            rows.append([min(PPM_MAX, round(Q * (climate_k(name, t, rh) / ref) ** -b)) for t in CLIMATE_T])
+        out.append("\n// %s: ppm factor (Q10), rows %d..%d %%RH, columns %d..%d °C\n"
+                   % (name, CLIMATE_RH[0], CLIMATE_RH[-1], CLIMATE_T[0], CLIMATE_T[-1]))
+        out.append("const uint16_t gasClimate%s[GAS_CLIMATE_RH_POINTS][GAS_CLIMATE_T_POINTS] PROGMEM = {\n"
+                   % name.capitalize())
+        for row in rows:
+            out.append("  {%s},\n" % ", ".join("%d" % v for v in row))
+        out.append("};\n")
+    out.append(END)
+    return "".join(out)
+
+
+def lookup(points, values, ratio_q):
+    """The same integer interpolation as gasCurvePpm()"""
+    qpoints = [round(r * Q) for r in points]
+    if ratio_q <= qpoints[0]:
+        return values[0]
+    if ratio_q >= qpoints[-1]:
+        return values[-1]
+    lo, hi = 0, len(qpoints) - 1
+    while hi - lo > 1:
+        mid = (lo + hi) // 2
+        if qpoints[mid] <= ratio_q:
+            lo = mid
+        else:
+            hi = mid
+    p0, p1 = values[lo], values[hi]
+    span = qpoints[hi] - qpoints[lo]
+    return p0 - ((p0 - p1) * (ratio_q - qpoints[lo]) + span // 2) // span
+
+
+def check():
+    """Worst relative error of the lookup against the exact curve, for readings
+    of 1..65535 ppm, beyond the 1 ppm the integer result can't resolve"""
+    points = ratio_points()
+    worst = 0.0
+    for name, gas, a, b, clean in CURVES:
+        values = [round(ppm(a, b, r)) for r in points]
+        err = 0.0
+        for ratio_q in range(round(points[0] * Q), round(points[-1] * Q)):
+            exact = ppm(a, b, ratio_q / Q)
+            if exact < 1 or exact >= PPM_MAX:
+                continue
+            got = lookup(points, values, ratio_q)
+            err = max(err, max(0.0, abs(got - exact) - 1) / exact)
+        print("%-6s %-4s max error %.2f%% (+/- 1 ppm)" % (name, gas, err * 100))
+        worst = max(worst, err)
+    return worst
+
+
+if __name__ == "__main__":
+    if "--check" in sys.argv:
+        sys.exit(0 if check() < 0.02 else 1)
+    for header, block in ((CALIBRATION_HEADER, generate_curves()),
+                          (COMPENSATION_HEADER, generate_climate())):
+        if "--write" in sys.argv:
+            text = open(header, encoding="utf-8").read()
+            start, end = text.index(BEGIN), text.index(END) + len(END)
+            open(header, "w", encoding="utf-8").write(text[:start] + block + text[end:])
+        else:
+            sys.stdout.write(block)
@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+# Turn the binary records of Deferred_Log.h back into text.
+#
+#   python3 tools/log_decode.py Receiver.cpp capture.bin
+#   python3 tools/log_decode.py Smart_traffic_system.cpp --port /dev/ttyACM0 --baud 9600
+#
+# The message table is read from the LOG_CATALOG X-macro in the sketch, so
+# decode with the same source the board was built from. Anything between
+# records (ordinary Serial prints) is copied through unchanged.
+
+import argparse
+import ast
+import re
+import struct
+import sys
+
+SYNC = 0x1E
+HEADER_LEN = 7
+DROPPED_FORMAT = "(%lu log records dropped)"
+
+CATALOG_RE = re.compile(r"#define\s+(\w+)\(X\)\s*\\\n((?:.*\\\n)*.*)")
+ENTRY_RE = re.compile(r"X\(\s*(\w+)\s*,\s*((?:\"(?:[^\"\\]|\\.)*\"\s*)+)\)")
+STRING_RE = re.compile(r"\"(?:[^\"\\]|\\.)*\"")
+CONVERSION_RE = re.compile(r"%([-+ #0]*\d*(?:\.\d+)?)[hlLqjzt]*([diouxXcfFeEgGs%])")
+
+
+def load_catalog(path):
+    """Message formats by ID, from the catalog named in LOG_CATALOG(...)"""
+    source = open(path, encoding="utf-8").read()
+    used = re.search(r"^LOG_CATALOG\((\w+)\)", source, re.M)
+    if not used:
+        sys.exit("%s has no LOG_CATALOG(...)" % path)
+    for m in CATALOG_RE.finditer(source):
+        if m.group(1) == used.group(1):
+            formats = [DROPPED_FORMAT]
+            body = m.group(2).replace("\\\n", "\n")  # join the continued lines
+            for entry in ENTRY_RE.finditer(body):
+                parts = STRING_RE.findall(entry.group(2))
+                formats.append("".join(ast.literal_eval(p) for p in parts))
+            return formats
+    sys.exit("catalog %s not found in %s" % (used.group(1), path))
+
+
+def render(fmt, words):
+    """printf-style formatting with each argument taken from a 32-bit word"""
+    args = iter(words)
+
+    def convert(m):
+        flags, kind = m.group(1), m.group(2)
+        if kind == "%":
+            return "%"
+        word = next(args, 0)
+        if kind in "fFeEgG":
+            value = struct.unpack("<f", struct.pack("<I", word))[0]
+        elif kind in "di":
+            value = word - (1 << 32) if word & 0x80000000 else word
+        elif kind == "c":
+            return chr(word & 0xFF)
+        elif kind == "s":
+            return "?"
+        else:
+            value = word
+        if kind == "u":
+            kind = "d"
+        return ("%" + flags + kind) % value
+
+    return CONVERSION_RE.sub(convert, fmt)
+
+
+class Decoder:
+    def __init__(self, formats, out, timestamps):
+        self.formats = formats
+        self.out = out
+        self.timestamps = timestamps
+        self.buf = bytearray()
+
+    def feed(self, data):
+        self.buf += data
+        while self.buf:
+            sync = self.buf.find(SYNC)
+            if sync != 0:
+                text = self.buf if sync < 0 else self.buf[:sync]
+                self.out.write(text.decode("utf-8", "replace"))
+                del self.buf[:len(text)]
+                continue
+            if len(self.buf) < HEADER_LEN:
+                break
+            msg_id, argc = self.buf[1], self.buf[2]
+            length = HEADER_LEN + 4 * argc
+            if len(self.buf) < length:
+                break
+            stamp = struct.unpack_from("<I", self.buf, 3)[0]
+            words = struct.unpack_from("<%dI" % argc, self.buf, HEADER_LEN)
+            del self.buf[:length]
+            if msg_id < len(self.formats):
+                text = render(self.formats[msg_id], words)
+            else:
+                text = "<unknown log message %d %s>" % (msg_id, list(words))
+            if self.timestamps:
+                body = text.lstrip("\n")  # blank lines go before the time
+                text = text[:len(text) - len(body)] + "[%9.3f] %s" % (stamp / 1000.0, body)
+            self.out.write(text + "\n")
+        self.out.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode Deferred_Log.h records back into text")
+    parser.add_argument("sketch", help="sketch source with the LOG_CATALOG")
+    parser.add_argument("input", nargs="?", default="-", help="captured bytes (default: stdin)")
+    parser.add_argument("--port", help="read a serial port instead (needs pyserial)")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--no-time", action="store_true", help="leave out the board's millis()")
+    args = parser.parse_args()
+
+    decoder = Decoder(load_catalog(args.sketch), sys.stdout, not args.no_time)
+    if args.port:
+        import serial
+        port = serial.Serial(args.port, args.baud, timeout=0.1)
+        while True:
+            decoder.feed(port.read(256))
+    stream = sys.stdin.buffer if args.input == "-" else open(args.input, "rb")
+    while True:
+        data = stream.read1(4096) if hasattr(stream, "read1") else stream.read(4096)
+        if not data:
+            break
+        decoder.feed(data)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,169 @@
+// Rate-of-rise pre-alarm benchmark: runs Receiver.cpp on the simulated core
+// and replays synthetic gas traces from one transmitter into it, to see how
+// much earlier than the threshold alarm the pre-alarm (Gas_Rise_Detector.h)
+// comes, and how often it goes off in clean air
+//
+//   pio run -e rise_bench && .pio/build/rise_bench/program [clean-air hours] [--seed N]
+//     (default 24 h of clean air)
+//
+// The transmitter reads its sensors every 100 ms and sends as
+// Gas_Report_Policy.h decides (crossings at once, deltas, 5 s heartbeats).
+// Every reading has 3% + 1 ppm of noise, and one reading in 3000 is a
+// spike of 3x. Each leak starts from clean air and rises exponentially
+// towards 2-10x the gas's threshold with a 60-900 s time constant; after
+// it the room is aired for 2 min. For each leak the bench reports when the
+// true level crossed the gas's MQ*_THRESHOLD, when the receiver's threshold
+// alarm came on (a spike can set it off early) and how long before the
+// crossing the pre-alarm did ("late" if only after it, "-" if never). Then
+// it replays clean air with a daily swing of ±50% and counts the
+// pre-alarms.
+
+#include <Arduino.h>
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <vector>
+#include "Gas_Link_Protocol.h"
+#include "Gas_Report_Policy.h"
+
+// From Receiver.cpp
+void processIncomingData();
+void logDrain();
+extern std::atomic<uint8_t> alarmNodes[];
+extern uint8_t riseNodes[];
+
+#define NODE 1
+#define READ_MS 100
+#define BAUD_US_PER_BYTE 1042   // 9600 baud
+#define SPIKE_CHANCE (1.0 / 3000)
+#define AIRING_MS 120000UL
+
+// As in Receiver.cpp: the GasChannel order, names and thresholds
+const int gases = 3;
+const char *const gasNames[gases] = {"NH3", "CO", "CH4"};
+const double thresholds[gases] = {25, 50, 1000};
+const double cleanAir[gases] = {4, 1, 2};   // ppm, the datasheet clean-air points
+
+const double peakTimes[] = {2, 3, 5, 10};           // x threshold
+const double timeConstants[] = {60, 120, 300, 600, 900};   // s
+
+std::mt19937 rng(1);
+ReportPolicy policy;
+uint16_t seq = 0;
+uint32_t nodeMillis = 0;
+long frames = 0;
+
+double gauss() { return std::normal_distribution<double>(0, 1)(rng); }
+double uniform() { return std::uniform_real_distribution<double>(0, 1)(rng); }
+
+// One reading as the transmitter would have it
+uint16_t reading(double ppm) {
+  double v = ppm + (0.03 * ppm + 1) * gauss();
+  if (uniform() < SPIKE_CHANCE) v *= 3;
+  return v < 0 ? 0 : v > 0xFFFF ? 0xFFFF : (uint16_t)v;
+}
+
+// Advance by one reading with these true levels; send it if the policy says so
+void step(const double (&ppm)[gases]) {
+  simAdvanceMicros(READ_MS * 1000UL);
+  nodeMillis += READ_MS;
+  GasSample s = {};
+  s.timestamp = nodeMillis;
+  s.mq135Ppm = reading(ppm[0]);
+  s.mq7Ppm = reading(ppm[1]);
+  s.mq5Ppm = reading(ppm[2]);
+  uint8_t reason = reportCheck(policy, s, nodeMillis);
+  if (reason == REPORT_NONE) {
+    return;
+  }
+  reportSent(policy, s, nodeMillis, reason);
+  uint8_t frame[GAS_LINK_MAX_FRAME];
+  size_t len = gasLinkEncodeSample(frame, NODE, ++seq, s);
+  Serial2.simInject(frame, len);
+  simAdvanceMicros(len * BAUD_US_PER_BYTE);   // the frame arrives over the UART
+  processIncomingData();
+  loop();
+  logDrain();
+  frames++;
+}
+
+void air(unsigned long ms) {
+  const double ppm[gases] = {cleanAir[0], cleanAir[1], cleanAir[2]};
+  for (unsigned long t = 0; t < ms; t += READ_MS) step(ppm);
+}
+
+int main(int argc, char **argv) {
+  double hours = 24;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--seed") && i + 1 < argc) rng.seed(atoi(argv[++i]));
+    else if (argv[i][0] != '-') hours = atof(argv[i]);
+    else {
+      fprintf(stderr, "usage: %s [clean-air hours] [--seed N]\n", argv[0]);
+      return 2;
+    }
+  }
+  setenv("SIM_SERIAL_OUT", "/dev/null", 0);   // the Receiver's console
+  simBegin(argc, argv);
+  air(AIRING_MS);
+
+  printf("gas  peak ppm  tau   crossing    alarm  pre-alarm lead\n");
+  for (int g = 0; g < gases; g++) {
+    std::vector<double> leads;
+    int late = 0, missed = 0;
+    for (double times : peakTimes) {
+      for (double tau : timeConstants) {
+        double peak = times * thresholds[g];
+        double ppm[gases] = {cleanAir[0], cleanAir[1], cleanAir[2]};
+        double crossing = -tau * log(1 - (thresholds[g] - cleanAir[g]) / (peak - cleanAir[g]));
+        double preAt = -1, alarmAt = -1;
+        for (unsigned long t = 0; alarmAt < 0 || t / 1000.0 < crossing; t += READ_MS) {
+          ppm[g] = cleanAir[g] + (peak - cleanAir[g]) * (1 - exp(-(t / 1000.0) / tau));
+          step(ppm);
+          if (preAt < 0 && riseNodes[g] > 0) preAt = t / 1000.0;
+          if (alarmAt < 0 && alarmNodes[g].load() > 0) alarmAt = t / 1000.0;
+        }
+        printf("%-4s %8.0f %4.0fs %9.1fs %7.1fs  ", gasNames[g], peak, tau, crossing, alarmAt);
+        if (preAt < 0) {
+          printf("%14s\n", "-");
+          missed++;
+        } else if (preAt > crossing) {
+          printf("%14s\n", "late");
+          late++;
+        } else {
+          printf("%13.1fs\n", crossing - preAt);
+          leads.push_back(crossing - preAt);
+        }
+        air(AIRING_MS);
+      }
+    }
+    std::sort(leads.begin(), leads.end());
+    if (leads.empty()) {
+      printf("%s: no pre-alarm ahead of the crossing", gasNames[g]);
+    } else {
+      printf("%s: pre-alarm ahead of the crossing in %zu leaks, lead %.1f-%.1f s (median %.1f s)",
+             gasNames[g], leads.size(), leads.front(), leads.back(), leads[leads.size() / 2]);
+    }
+    printf("; %d late, %d without\n\n", late, missed);
+  }
+
+  // Clean air with a daily swing
+  long falseAlarms[gases] = {};
+  bool wasRising[gases] = {};
+  unsigned long ms = (unsigned long)(hours * 3600e3);
+  for (unsigned long t = 0; t < ms; t += READ_MS) {
+    double swing = 1 + 0.5 * sin(2 * M_PI * t / 86400e3);
+    const double ppm[gases] = {cleanAir[0] * swing, cleanAir[1] * swing, cleanAir[2] * swing};
+    step(ppm);
+    for (int g = 0; g < gases; g++) {
+      bool rising = riseNodes[g] > 0;
+      if (rising && !wasRising[g]) falseAlarms[g]++;
+      wasRising[g] = rising;
+    }
+  }
+  printf("%.1f h of clean air: false pre-alarms", hours);
+  for (int g = 0; g < gases; g++) {
+    printf(" %s %ld%s", gasNames[g], falseAlarms[g], g < gases - 1 ? "," : "\n");
+  }
+  printf("%ld frames sent\n", frames);
+  return 0;
+}
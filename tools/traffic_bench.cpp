@@ -0,0 +1,294 @@
+// Traffic policy benchmark: runs Smart_traffic_system.cpp on the simulated
+// core against simulated traffic and reports how well it is served
+//
+//   pio run -e traffic_bench && .pio/build/traffic_bench/program [hours] [options]
+//     --rates FILE   arrival rates, lines "hour rateA rateB rateC rateD" (vehicles/min),
+//                    each holding until the next line's hour; repeats daily
+//     --trace FILE   recorded arrivals instead, lines "seconds road" (road A-D)
+//     --miss P       chance the sensor misses a vehicle (default 0.05)
+//     --ghosts N     false detections per sensor per hour (default 2)
+//     --seed N
+//     --max-p95 S    exit with status 3 if the overall p95 delay is over S seconds
+// Without --rates or --trace it runs the weekday in dayRates[] below; the
+// default length is 24 h.
+//
+// Each approach is one lane. A vehicle arrives (Poisson from the rates, or
+// from the trace), is in front of its road's ultrasonic sensor for 0.2 s
+// at 3-6 cm, with ±1 cm of noise on each echo, then joins the queue at the
+// stop line. A green serves no one for its first 2 s, then one vehicle
+// every 2 s. A vehicle's delay runs from its arrival to crossing the line.
+//
+// SIM_SERIAL_OUT=file keeps the sketch's own log. Compare policies by
+// building the sketch with other flags, e.g.
+//   PLATFORMIO_BUILD_FLAGS=-DACTUATED_CONTROL=0 pio run -e traffic_bench
+// The traffic_bench_fixed env is the fixed-time build, and
+// tools/traffic_compare.py runs both over tools/traffic_scenarios/.
+
+#include <Arduino.h>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <random>
+#include <vector>
+
+// As wired in Smart_traffic_system.cpp
+const int roads = 4;
+const uint8_t greenPins[roads] = {4, 7, 10, 13};
+const uint8_t echoPins[roads] = {62, 63, 64, 65};   // A8-A11
+#define BENCH_ULTRASONIC "22=62,24=63,26=64,28=65"  // trig=echo
+
+#define STEP_US 10000           // traffic model resolution
+#define PRESENCE_US 200000      // a vehicle in front of the sensor
+#define GHOST_US 100000         // a false echo
+#define STARTUP_US 2000000      // start-up lost time on green
+#define HEADWAY_US 2000000      // then one vehicle per headway
+#define US_PER_CM 58
+
+// Built-in weekday (vehicles/min per road, from that hour): morning rush
+// inbound on A and C, evening rush outbound on B and D
+struct RateStep {
+  double hour;
+  double rate[roads];
+};
+const RateStep dayRates[] = {
+  {0, {0.3, 0.3, 0.3, 0.3}},  {6, {2, 1.5, 2, 1.5}},   {7, {10, 2, 6, 2}},
+  {10, {4, 4, 4, 4}},         {16, {3, 10, 3, 6}},     {19, {2, 2, 2, 2}},
+  {22, {1, 1, 1, 1}},
+};
+
+struct Road {
+  std::deque<uint64_t> queue;   // arrival times
+  std::vector<double> delays;   // s, of the vehicles served
+  uint64_t nextArrival = 0;
+  uint64_t presentUntil = 0, ghostUntil = 0, nextGhost = 0;
+  uint64_t nextDeparture = 0;
+  bool green = false;
+  long arrivals = 0, missed = 0, ghosts = 0;
+  size_t maxQueue = 0;
+  double queueSum = 0;          // vehicle-steps, for the average
+};
+
+Road road[roads];
+std::vector<RateStep> rates;
+std::vector<std::pair<uint64_t, int>> trace;   // (µs, road), in time order
+size_t traceNext = 0;
+std::mt19937 rng(1);
+double missChance = 0.05, ghostsPerHour = 2;
+double maxP95 = 0;   // s, 0 = no limit
+
+double uniform() { return std::uniform_real_distribution<double>(0, 1)(rng); }
+
+double rateAt(int r, uint64_t t) {
+  double hour = fmod(t / 3600e6, 24);
+  double rate = rates[0].rate[r];
+  for (const RateStep &s : rates) {
+    if (s.hour <= hour) rate = s.rate[r];
+  }
+  return rate;
+}
+
+// Time of the first rate change after t
+uint64_t nextRateChange(uint64_t t) {
+  double hour = fmod(t / 3600e6, 24);
+  double next = rates[0].hour + 24;
+  for (const RateStep &s : rates) {
+    if (s.hour > hour) {
+      next = s.hour;
+      break;
+    }
+  }
+  return t + (uint64_t)((next - hour) * 3600e6) + 1;
+}
+
+// Next Poisson arrival after t. Rates are piecewise constant, so draw
+// against the rate now and retry at the next change if the gap crosses it
+uint64_t nextPoisson(int r, uint64_t t) {
+  for (;;) {
+    double perUs = rateAt(r, t) / 60e6;
+    uint64_t stepEnd = nextRateChange(t);
+    if (perUs > 0) {
+      uint64_t at = t + (uint64_t)(-log(1 - uniform()) / perUs);
+      if (at <= stepEnd) return at;
+    }
+    t = stepEnd;
+  }
+}
+
+void arrive(Road &rd, uint64_t t) {
+  rd.queue.push_back(t);
+  rd.arrivals++;
+  if (uniform() < missChance) {
+    rd.missed++;
+  } else {
+    rd.presentUntil = t + PRESENCE_US;
+  }
+}
+
+bool loadRates(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f) return false;
+  char line[256];
+  while (fgets(line, sizeof(line), f)) {
+    RateStep s;
+    if (line[0] != '#' && sscanf(line, "%lf %lf %lf %lf %lf", &s.hour, &s.rate[0], &s.rate[1],
+                                 &s.rate[2], &s.rate[3]) == 5) {
+      rates.push_back(s);
+    }
+  }
+  fclose(f);
+  std::sort(rates.begin(), rates.end(),
+            [](const RateStep &a, const RateStep &b) { return a.hour < b.hour; });
+  return !rates.empty();
+}
+
+bool loadTrace(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f) return false;
+  char line[256];
+  double seconds;
+  char name;
+  while (fgets(line, sizeof(line), f)) {
+    if (line[0] != '#' && sscanf(line, "%lf %c", &seconds, &name) == 2) {
+      int r = toupper(name) - 'A';
+      if (r >= 0 && r < roads) trace.push_back({(uint64_t)(seconds * 1e6), r});
+    }
+  }
+  fclose(f);
+  std::sort(trace.begin(), trace.end());
+  return !trace.empty();
+}
+
+double percentile(std::vector<double> &v, double p) {
+  if (v.empty()) return 0;
+  std::sort(v.begin(), v.end());
+  return v[std::min(v.size() - 1, (size_t)(v.size() * p))];
+}
+
+int main(int argc, char **argv) {
+  double hours = 24;
+  const char *ratesPath = nullptr, *tracePath = nullptr;
+  for (int i = 1; i < argc; i++) {
+    std::string a = argv[i];
+    bool more = i + 1 < argc;
+    if (a == "--rates" && more) ratesPath = argv[++i];
+    else if (a == "--trace" && more) tracePath = argv[++i];
+    else if (a == "--miss" && more) missChance = atof(argv[++i]);
+    else if (a == "--ghosts" && more) ghostsPerHour = atof(argv[++i]);
+    else if (a == "--seed" && more) rng.seed(atoi(argv[++i]));
+    else if (a == "--max-p95" && more) maxP95 = atof(argv[++i]);
+    else if (a[0] != '-') hours = atof(a.c_str());
+    else {
+      fprintf(stderr, "usage: %s [hours] [--rates FILE | --trace FILE] [--miss P] [--ghosts N] "
+                      "[--seed N] [--max-p95 S]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (ratesPath && !loadRates(ratesPath)) {
+    fprintf(stderr, "no rates in %s\n", ratesPath);
+    return 1;
+  }
+  if (tracePath && !loadTrace(tracePath)) {
+    fprintf(stderr, "no arrivals in %s\n", tracePath);
+    return 1;
+  }
+  if (rates.empty()) rates.assign(dayRates, dayRates + sizeof(dayRates) / sizeof(dayRates[0]));
+
+  setenv("SIM_ULTRASONIC", BENCH_ULTRASONIC, 0);
+  setenv("SIM_LOOP_COST_US", "1000", 0);   // a busy Mega loop(); plenty for the ping slots
+  setenv("SIM_SERIAL_OUT", "/dev/null", 0);
+  auto wallStart = std::chrono::steady_clock::now();
+  simBegin(argc, argv);
+
+  // Traffic starts once setup() is done; times below are from then
+  uint64_t start = simNowMicros(), end = start + (uint64_t)(hours * 3600e6);
+  for (int r = 0; r < roads; r++) {
+    road[r].nextArrival = tracePath ? UINT64_MAX : start + nextPoisson(r, 0);
+    road[r].nextGhost = ghostsPerHour > 0
+                          ? start + (uint64_t)(-log(1 - uniform()) * 3600e6 / ghostsPerHour)
+                          : UINT64_MAX;
+  }
+  int lastGreen = -1;
+  long cycles = 0, greens = 0;
+  uint64_t firstCycle = 0, lastCycle = 0;
+
+  for (uint64_t t = start; t < end; t += STEP_US) {
+    while (traceNext < trace.size() && start + trace[traceNext].first <= t) {
+      arrive(road[trace[traceNext].second], t);
+      traceNext++;
+    }
+    for (int r = 0; r < roads; r++) {
+      Road &rd = road[r];
+      while (rd.nextArrival <= t) {
+        arrive(rd, rd.nextArrival);
+        rd.nextArrival = start + nextPoisson(r, rd.nextArrival - start);
+      }
+      if (rd.nextGhost <= t) {
+        rd.ghostUntil = t + GHOST_US;
+        rd.ghosts++;
+        rd.nextGhost = t + (uint64_t)(-log(1 - uniform()) * 3600e6 / ghostsPerHour);
+      }
+      // Echo for the next ping: a vehicle at 3-6 cm (±1 cm noise), else nothing
+      double cm = 0;
+      if (t < rd.presentUntil || t < rd.ghostUntil) {
+        cm = 3 + 3 * uniform() + std::normal_distribution<double>(0, 1)(rng);
+      }
+      simSetPulseWidth(echoPins[r], cm > 0 ? (unsigned long)(cm * US_PER_CM) : 0);
+
+      // Queue discharge on green
+      bool green = simGetDigital(greenPins[r]);
+      if (green && !rd.green) {
+        rd.nextDeparture = t + STARTUP_US;
+        greens++;
+        if (r <= lastGreen) {   // the controller went round again
+          if (cycles++ == 0) firstCycle = t;
+          lastCycle = t;
+        }
+        lastGreen = r;
+      }
+      rd.green = green;
+      if (green && t >= rd.nextDeparture && !rd.queue.empty()) {
+        rd.delays.push_back((t - rd.queue.front()) / 1e6);
+        rd.queue.pop_front();
+        rd.nextDeparture = t + HEADWAY_US;
+      }
+      rd.queueSum += rd.queue.size();
+      rd.maxQueue = std::max(rd.maxQueue, rd.queue.size());
+    }
+    simRunUntil(t + STEP_US);
+  }
+
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+  double steps = (end - start) / STEP_US;
+  printf("%.1f h of traffic in %.1f s\n\n", hours, wall);
+  printf("road  arrivals  served  left  delay avg   p95  queue avg  max  missed  ghosts\n");
+  std::vector<double> all;
+  long arrivals = 0, served = 0, left = 0;
+  double queueAvg = 0;
+  size_t maxQueue = 0;
+  for (int r = 0; r < roads; r++) {
+    Road &rd = road[r];
+    double sum = 0;
+    for (double d : rd.delays) sum += d;
+    printf("%c     %8ld  %6zu  %4zu  %8.1fs %5.0fs  %9.1f  %3zu  %6ld  %6ld\n", 'A' + r, rd.arrivals,
+           rd.delays.size(), rd.queue.size(), rd.delays.empty() ? 0 : sum / rd.delays.size(),
+           percentile(rd.delays, 0.95), rd.queueSum / steps, rd.maxQueue, rd.missed, rd.ghosts);
+    all.insert(all.end(), rd.delays.begin(), rd.delays.end());
+    arrivals += rd.arrivals;
+    served += rd.delays.size();
+    left += rd.queue.size();
+    queueAvg += rd.queueSum / steps / roads;
+    maxQueue = std::max(maxQueue, rd.maxQueue);
+  }
+  double sum = 0;
+  for (double d : all) sum += d;
+  printf("all   %8ld  %6ld  %4ld  %8.1fs %5.0fs  %9.1f  %3zu\n\n", arrivals, served, left,
+         all.empty() ? 0 : sum / all.size(), percentile(all, 0.95), queueAvg, maxQueue);
+  printf("throughput %.0f vehicles/h, %ld greens, cycle %.1f s avg\n", served / hours, greens,
+         cycles > 1 ? (lastCycle - firstCycle) / 1e6 / (cycles - 1) : 0.0);
+  double p95 = percentile(all, 0.95);
+  if (maxP95 > 0 && p95 > maxP95) {
+    printf("\nWARNING: p95 delay %.0f s is over the %.0f s limit\n", p95, maxP95);
+    return 3;
+  }
+  return 0;
+}
@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+# Run the traffic benchmark for the actuated and the fixed-time controller
+# over the scenarios in tools/traffic_scenarios/ and compare them.
+#
+#   pio run -e traffic_bench -e traffic_bench_fixed
+#   python3 tools/traffic_compare.py                  # every scenario
+#   python3 tools/traffic_compare.py peak weekday     # some of them
+#
+#   pio run -e traffic_bench_fixed -e traffic_bench_lifetime
+#   python3 tools/traffic_compare.py --allocation shifting
+#     the fixed plan's split by recent demand against the old split by
+#     lifetime vehicle counts (RECENT_DEMAND_ALLOCATION=0)
+#
+# Each scenario is a traffic_bench --rates file; its "# bench:" line holds
+# the hours to run and any other bench options. A scenario without rate
+# lines runs the bench's built-in weekday. Both builds run it with the same
+# --seeds seeds (5 by default), so they see exactly the same vehicles and
+# every run repeats exactly. One seed alone is not enough: a shift of a few
+# microseconds in when the sketch does something changes which ping sees
+# which vehicle, and moves a single run's delays by 10% or more. The table
+# shows the mean over the seeds and, in brackets, the lowest and highest
+# single run.
+#
+# Exits with status 1 when the actuated controller's (or with --allocation,
+# the recent-demand split's) mean average or p95 delay is worse than the
+# fixed plan's (the lifetime split's) by more than --tolerance in any
+# scenario, or a bench run fails (e.g. over its --max-p95 limit).
+
+import argparse
+import concurrent.futures
+import glob
+import os
+import re
+import subprocess
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+PROJECT = os.path.dirname(HERE)
+SCENARIOS = os.path.join(HERE, "traffic_scenarios")
+RATE_LINE_RE = re.compile(r"^\s*\d")
+ALL_RE = re.compile(r"^all\s+(\d+)\s+(\d+)\s+(\d+)\s+([\d.]+)s\s+([\d.]+)s")
+THROUGHPUT_RE = re.compile(r"^throughput (\d+) vehicles/h, \d+ greens, cycle ([\d.]+) s")
+
+
+def scenario_args(path):
+    """Bench arguments for a scenario file"""
+    args = []
+    has_rates = False
+    for line in open(path, encoding="utf-8"):
+        if line.startswith("# bench:"):
+            args += line[len("# bench:"):].split()
+        elif RATE_LINE_RE.match(line):
+            has_rates = True
+    if has_rates:
+        args += ["--rates", path]
+    return args
+
+
+def run(program, args):
+    """(result dict, bench status) of one run"""
+    out = subprocess.run([program] + args, capture_output=True, text=True)
+    result = {}
+    for line in out.stdout.splitlines():
+        m = ALL_RE.match(line)
+        if m:
+            result["served"] = int(m.group(2))
+            result["left"] = int(m.group(3))
+            result["avg"] = float(m.group(4))
+            result["p95"] = float(m.group(5))
+        m = THROUGHPUT_RE.match(line)
+        if m:
+            result["throughput"] = int(m.group(1))
+            result["cycle"] = float(m.group(2))
+        if line.startswith("WARNING"):
+            print("  %s: %s" % (os.path.basename(program), line))
+    if "avg" not in result:
+        sys.stderr.write(out.stdout + out.stderr)
+        sys.exit("%s %s failed" % (program, " ".join(args)))
+    return result, out.returncode
+
+
+def mean(runs, key):
+    return sum(r[key] for r in runs) / len(runs)
+
+
+def spread(runs, key, fmt):
+    values = [r[key] for r in runs]
+    return ("(" + fmt + "-" + fmt + ")") % (min(values), max(values))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare the actuated and fixed-time traffic controllers")
+    parser.add_argument("scenarios", nargs="*", help="names in tools/traffic_scenarios/ (default: all)")
+    parser.add_argument("--actuated", default=os.path.join(PROJECT, ".pio/build/traffic_bench/program"))
+    parser.add_argument("--fixed", default=os.path.join(PROJECT, ".pio/build/traffic_bench_fixed/program"))
+    parser.add_argument("--lifetime", default=os.path.join(PROJECT, ".pio/build/traffic_bench_lifetime/program"))
+    parser.add_argument("--allocation", action="store_true",
+                        help="compare the fixed plan's recent-demand split with the lifetime-count split")
+    parser.add_argument("--tolerance", type=float, default=0.1, help="allowed regression (default 0.1 = 10%%)")
+    parser.add_argument("--seeds", type=int, default=5, help="run seeds 1..N (default 5)")
+    parser.add_argument("--max-p95", help="passed on to the bench")
+    opts = parser.parse_args()
+
+    names = opts.scenarios or sorted(os.path.splitext(os.path.basename(p))[0]
+                                     for p in glob.glob(os.path.join(SCENARIOS, "*.txt")))
+    extra = ["--max-p95", opts.max_p95] if opts.max_p95 else []
+    seeds = range(1, opts.seeds + 1)
+    if opts.allocation:
+        policies = (("recent", opts.fixed), ("lifetime", opts.lifetime))
+    else:
+        policies = (("actuated", opts.actuated), ("fixed", opts.fixed))
+    (new, _), (old, _) = policies
+    print("%-16s %-9s %-20s %-16s %7s %7s %5s" % ("scenario", "policy", "avg", "p95", "veh/h", "cycle", "left"))
+    failed = []
+    with concurrent.futures.ThreadPoolExecutor(os.cpu_count()) as pool:
+        for name in names:
+            args = scenario_args(os.path.join(SCENARIOS, name + ".txt")) + extra
+            jobs = {(policy, seed): pool.submit(run, program, args + ["--seed", str(seed)])
+                    for policy, program in policies for seed in seeds}
+            means = {}
+            for policy, _ in policies:
+                runs = []
+                for seed in seeds:
+                    r, status = jobs[(policy, seed)].result()
+                    runs.append(r)
+                    if status != 0:
+                        failed.append("%s (%s, seed %d): bench status %d" % (name, policy, seed, status))
+                means[policy] = {key: mean(runs, key) for key in ("avg", "p95")}
+                print("%-16s %-9s %6.1fs %-13s %4.0fs %-11s %7.0f %6.1fs %5.0f" % (
+                    name, policy, means[policy]["avg"], spread(runs, "avg", "%.1f"),
+                    means[policy]["p95"], spread(runs, "p95", "%.0f"), mean(runs, "throughput"),
+                    mean(runs, "cycle"), mean(runs, "left")))
+            for key in ("avg", "p95"):
+                if means[new][key] > means[old][key] * (1 + opts.tolerance):
+                    failed.append("%s: %s mean %s delay %.1f s vs %s %.1f s" % (
+                        name, new, key, means[new][key], old, means[old][key]))
+    if failed:
+        print("\nREGRESSION:\n  " + "\n  ".join(failed))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())